@@ -4,18 +4,23 @@
 
 #include <iostream>
 #include <string>
+#include <stdexcept>
 
-#include "../util/gcry_exception.h"
+#include "md5_batch.h"
+#include "des_bitslice.h"
 
-CheckPassword::CheckPassword(const ParsedFile &cypherFile):
-    cipher(),
+CheckPassword::CheckPassword(const ParsedFile &cypherFile, bool usePaddingPrefilter,
+                             const PlaintextFilter &plaintextFilter, const CryptoBackends &backends):
+    backends(backends),
+    md5Engine(createMd5Engine(backends.md5)),
+    tripleDesEngine(createTripleDesEngine(backends.tripleDes)),
+    sha256Engine(createSha256Engine(backends.sha256)),
     
     cipherTextSize(cypherFile.contentSize),
     sha256CheckSumSize(cypherFile.shaCheckSumSize),
     initialValueSize(cypherFile.initialValueSize),
     
-    md5CheckSumSize(gcry_md_get_algo_dlen(GCRY_MD_MD5)),
-    tripleDESKeySize(gcry_cipher_get_algo_keylen(GCRY_CIPHER_3DES)),
+    md5CheckSumSize(md5DigestSize),
     
     cipherText(cypherFile.content),
     sha256CheckSum(cypherFile.shaCheckSum),
@@ -23,21 +28,39 @@ CheckPassword::CheckPassword(const ParsedFile &cypherFile):
     
     originalText(new unsigned char[cipherTextSize]),
     md5HashResult(new unsigned char[md5CheckSumSize]),
-    tripleDesKey(new unsigned char [tripleDESKeySize]),
-    sha256HashResult(new unsigned char [sha256CheckSumSize])
+    sha256HashResult(new unsigned char [sha256CheckSumSize]),
+    
+    usePaddingPrefilter(usePaddingPrefilter),
+    blockSize(tripleDesBlockSize),
+    lastBlock(new unsigned char [blockSize]),
+    
+    plaintextFilter(plaintextFilter.limitTo(cipherTextSize, blockSize)),
+    plaintextFilterSize(std::min((this->plaintextFilter.getCheckedSize() + blockSize - 1) / blockSize * blockSize,
+                                 cipherTextSize))
 {
-    processGcryError(gcry_cipher_open(&cipher, GCRY_CIPHER_3DES, GCRY_CIPHER_MODE_CBC, 0));
+    if(usePaddingPrefilter && !isPaddingPrefilterApplicable(cypherFile))
+    {
+        throw std::logic_error("ERROR in CheckPassword: padding prefilter requires ciphertext of whole blocks.");
+    }
+    if(!plaintextFilter.isEmpty() && !isPlaintextFilterApplicable(cypherFile, plaintextFilter))
+    {
+        throw std::logic_error("ERROR in CheckPassword: plaintext filter requires ciphertext of whole blocks, "
+                               "which is not shorter than known prefix.");
+    }
 }
 
 CheckPassword::CheckPassword(const CheckPassword& otherCipher):
-    cipher(),
+    backends(otherCipher.backends),
+    // Engines keep keys and contexts, so each object has its own ones.
+    md5Engine(createMd5Engine(backends.md5)),
+    tripleDesEngine(createTripleDesEngine(backends.tripleDes)),
+    sha256Engine(createSha256Engine(backends.sha256)),
     
     cipherTextSize(otherCipher.cipherTextSize),
     sha256CheckSumSize(otherCipher.sha256CheckSumSize),
     initialValueSize(otherCipher.initialValueSize),
     
-    md5CheckSumSize(gcry_md_get_algo_dlen(GCRY_MD_MD5)),
-    tripleDESKeySize(gcry_cipher_get_algo_keylen(GCRY_CIPHER_3DES)),
+    md5CheckSumSize(md5DigestSize),
     
     cipherText(otherCipher.cipherText),
     sha256CheckSum(otherCipher.sha256CheckSum),
@@ -46,41 +69,129 @@ CheckPassword::CheckPassword(const CheckPassword& otherCipher):
     // Even if we copy constructing, scoped_arrays have to initialize with its own buffers.
     originalText(new unsigned char[cipherTextSize]),
     md5HashResult(new unsigned char[md5CheckSumSize]),
-    tripleDesKey(new unsigned char [tripleDESKeySize]),
-    sha256HashResult(new unsigned char [sha256CheckSumSize])
-{
-    processGcryError(gcry_cipher_open(&cipher, GCRY_CIPHER_3DES, GCRY_CIPHER_MODE_CBC, 0));
-}
+    sha256HashResult(new unsigned char [sha256CheckSumSize]),
+    
+    usePaddingPrefilter(otherCipher.usePaddingPrefilter),
+    blockSize(otherCipher.blockSize),
+    lastBlock(new unsigned char [blockSize]),
+    
+    plaintextFilter(otherCipher.plaintextFilter),
+    plaintextFilterSize(otherCipher.plaintextFilterSize)
+{}
 
-CheckPassword::~CheckPassword()
+bool CheckPassword::isPasswordAcceptable(const std::string& password)
 {
-    gcry_cipher_close(cipher);
+    md5Engine->hash(reinterpret_cast<const unsigned char *>(password.data()), password.size(), md5HashResult.get());
+    
+    return(isKeyAcceptable(md5HashResult.get()));
 }
 
-bool CheckPassword::isPasswordAcceptable(const std::string& password)
+bool CheckPassword::isKeyAcceptable(const unsigned char *md5Digest)
 {
-    gcry_md_hash_buffer(GCRY_MD_MD5, md5HashResult.get(), password.c_str(), password.size());
-    
     // MD5 algorithm output only 16 bytes, while 3DES use 24 bytes string as a key.
     // To overcome this, we uses EDE2 mode. Encrypting on phase 1 and 3 done with the same key.
-    std::copy_n(md5HashResult.get(), md5CheckSumSize, tripleDesKey.get());
-    std::copy_n(md5HashResult.get(), tripleDESKeySize - md5CheckSumSize, tripleDesKey.get() + md5CheckSumSize);
-    
-    processGcryError(gcry_cipher_setkey(cipher, tripleDesKey.get(), tripleDESKeySize));
-    
-    // Setting initial value is needed before each decryption, or libgcrypt will consider
-    // that we decrypt one ciphertext by large blocks and will use initial last block
-    // from previous decryption for next decryption.
-    processGcryError(gcry_cipher_setiv(cipher, initialValue.get(), initialValueSize));
-    
-    processGcryError(gcry_cipher_decrypt(cipher, originalText.get(), cipherTextSize, cipherText.get(), cipherTextSize));
+    tripleDesEngine->setKey(md5Digest);
+    return(passesPrefilters() && passesFullCheck());
+}
+
+bool CheckPassword::passesFullCheck()
+{
+    // The rest of text is decrypted right after the blocks checked by plaintext filter, continuing CBC chain
+    // from the last ciphertext block of the checked ones.
+    if(plaintextFilterSize < cipherTextSize)
+    {
+        const unsigned char *previousBlock = plaintextFilterSize == 0 ? initialValue.get() :
+                                             cipherText.get() + plaintextFilterSize - blockSize;
+        tripleDesEngine->decrypt(previousBlock, cipherText.get() + plaintextFilterSize,
+                                 cipherTextSize - plaintextFilterSize, originalText.get() + plaintextFilterSize);
+    }
    
-    gcry_md_hash_buffer(GCRY_MD_SHA256, sha256HashResult.get(), originalText.get(), cipherTextSize);
+    sha256Engine->hash(originalText.get(), cipherTextSize, sha256HashResult.get());
     
     return(std::equal(sha256HashResult.get(), sha256HashResult.get() + sha256CheckSumSize,
                       sha256CheckSum.get()));
 }
 
+bool CheckPassword::passesPrefilters()
+{
+    // For a wrong key the decrypted last block almost never ends with valid padding,
+    // so most of passwords are rejected here by decrypting only one block instead of the whole text.
+    if(usePaddingPrefilter && !hasValidPadding())
+    {
+        return(false);
+    }
+    
+    // The first blocks are checked against known plaintext, so a wrong key costs decryption of a few blocks
+    // regardless of the size of text.
+    if(plaintextFilterSize != 0)
+    {
+        tripleDesEngine->decrypt(initialValue.get(), cipherText.get(), plaintextFilterSize, originalText.get());
+        if(!plaintextFilter.isPrefixAcceptable(originalText.get(), plaintextFilterSize))
+        {
+            return(false);
+        }
+    }
+    return(true);
+}
+
+std::size_t CheckPassword::checkKeys(const unsigned char *md5Digests, std::size_t count,
+                                     boost::dynamic_bitset<> &acceptableKeys)
+{
+    acceptableKeys.resize(count);
+    for(std::size_t index = 0; index < count; ++index)
+    {
+        // Key is set once: prefilters reject almost all keys by a block or a few of them, and the rest
+        // of text is decrypted right away for the few remaining ones, while their key schedule is ready.
+        tripleDesEngine->setKey(md5Digests + index * md5CheckSumSize);
+        acceptableKeys[index] = passesPrefilters() && passesFullCheck();
+    }
+    return(acceptableKeys.count());
+}
+
+bool CheckPassword::hasValidPadding()
+{
+    // In CBC mode the last block is decrypted on its own by using the previous ciphertext block as initial value.
+    // If ciphertext consists of a single block, the previous block is the initial value from file.
+    const unsigned char *previousBlock = cipherTextSize > blockSize ?
+                                         cipherText.get() + cipherTextSize - 2 * blockSize :
+                                         initialValue.get();
+    tripleDesEngine->decrypt(previousBlock, cipherText.get() + cipherTextSize - blockSize, blockSize, lastBlock.get());
+    
+    return(isPaddingValid(lastBlock.get(), blockSize));
+}
+
+bool CheckPassword::isPaddingValid(const unsigned char *block, std::size_t blockSize)
+{
+    // PKCS#5/7 padding is from 1 to blockSize bytes, each of them equals to the number of padding bytes.
+    const unsigned char paddingSize = block[blockSize - 1];
+    if(paddingSize == 0 || paddingSize > blockSize)
+    {
+        return(false);
+    }
+    return(std::all_of(block + blockSize - paddingSize, block + blockSize,
+                       [paddingSize](unsigned char paddingByte)
+                       {
+                           return(paddingByte == paddingSize);
+                       }));
+}
+
+bool CheckPassword::isPaddingPrefilterApplicable(const ParsedFile &cypherFile)
+{
+    const std::size_t blockSize = tripleDesBlockSize;
+    return(cypherFile.contentSize % blockSize == 0 && cypherFile.initialValueSize == blockSize);
+}
+
+bool CheckPassword::isPlaintextFilterApplicable(const ParsedFile &cypherFile, const PlaintextFilter &plaintextFilter)
+{
+    const std::size_t blockSize = tripleDesBlockSize;
+    return(cypherFile.contentSize % blockSize == 0 && plaintextFilter.isApplicable(cypherFile.contentSize));
+}
+
+const PlaintextFilter &CheckPassword::getPlaintextFilter() const
+{
+    return(plaintextFilter);
+}
+
 std::string CheckPassword::getDecryptedText() const
 {
     return(std::string(originalText.get(), originalText.get() + cipherTextSize));
@@ -1,54 +1,123 @@
 #ifndef CHECK_PASSWORD_H
 #define CHECK_PASSWORD_H
 
-#include <gcrypt.h>
-
 #include <string>
+#include <vector>
+#include <memory>
 #include <cstddef>
 
 #include "../io/parse_file.h"
+#include "plaintext_filter.h"
+#include "crypto_backend.h"
 
 #include <boost/smart_ptr/shared_array.hpp>
 #include <boost/smart_ptr/scoped_array.hpp>
+#include <boost/dynamic_bitset.hpp>
 
 /**
- * Class CheckPassword is a wrapper for C-style functions from libgcrypt.
+ * Class CheckPassword checks passwords one by one. Its stages (MD5, 3DES and SHA256) are performed by engines
+ * of backends, given in construction.
  */
 class CheckPassword
 {
 private:
-    gcry_cipher_hd_t cipher;
+    const CryptoBackends backends;
+    std::unique_ptr<Md5Engine> md5Engine;
+    std::unique_ptr<TripleDesEngine> tripleDesEngine;
+    std::unique_ptr<Sha256Engine> sha256Engine;
    
     // In this class we store several buffers and their sizes.
-    // Buffers from parsed file we store as shared, because we don't own them.
+    // Buffers from parsed file we store as shared, because we don't own them (they are views into mapped file).
     // Internal buffers stored in scoped array and own them exclusively.
     // Those internal buffers are used in isPasswordAcceptable function only and could be
     // local variables, but allocating memory once will speed up its execution.
     // NOTICE: cipherText and originalText has same size cipherTextSize and
     //         sha256CheckSum and sha256HashResult has same size sha256CheckSumSize.
-    const std::size_t cipherTextSize, sha256CheckSumSize, initialValueSize, md5CheckSumSize, tripleDESKeySize;
-    const boost::shared_array<unsigned char> cipherText, sha256CheckSum, initialValue;
-    boost::scoped_array<unsigned char> originalText, md5HashResult, tripleDesKey, sha256HashResult;
+    const std::size_t cipherTextSize, sha256CheckSumSize, initialValueSize, md5CheckSumSize;
+    const boost::shared_array<const unsigned char> cipherText, sha256CheckSum, initialValue;
+    boost::scoped_array<unsigned char> originalText, md5HashResult, sha256HashResult;
+    
+    // Whether the last block is checked for PKCS#5/7 padding before decrypting the whole text.
+    // The last block is decrypted into lastBlock buffer of size blockSize.
+    const bool usePaddingPrefilter;
+    const std::size_t blockSize;
+    boost::scoped_array<unsigned char> lastBlock;
+    
+    // What is known about the beginning of original text. Its first plaintextFilterSize bytes (whole blocks)
+    // are decrypted and checked before the rest of text.
+    const PlaintextFilter plaintextFilter;
+    const std::size_t plaintextFilterSize;
+    
+    bool hasValidPadding();
+    // Checks key, which is already set, by padding prefilter and plaintext filter, if they are used.
+    bool passesPrefilters();
+    // Decrypts the rest of text with key, which is already set and has passed prefilters, and compares
+    // SHA256 of the whole text with checksum.
+    bool passesFullCheck();
 public:
-    explicit CheckPassword(const ParsedFile &cypherFile);
+    /**
+     * Padding prefilter and plaintext filter require ciphertext to be applicable for them.
+     * Throws CryptoException if engines of backends fail to initialize.
+     */
+    explicit CheckPassword(const ParsedFile &cypherFile, bool usePaddingPrefilter = false,
+                           const PlaintextFilter &plaintextFilter = PlaintextFilter(),
+                           const CryptoBackends &backends = CryptoBackends());
     CheckPassword(const CheckPassword &otherCipher);
-    ~CheckPassword();
     
     CheckPassword operator=(const CheckPassword &checkPassword) = delete;
 
     /**
      * Checking password is done in following way:
      * 1) Applying MD5 to password.
+     *    If padding prefilter is used, the last block is decrypted (using previous ciphertext block as initial value)
+     *    and the password is rejected if the block doesn't end with valid PKCS#5/7 padding.
      * 2) Decrypting cipherText with 3DES (EDE2/DED2) algorithm in CBC mode using MD5 result as key 
      *    and initial value for CBC from parsedFile, passed in construction.
+     *    If plaintext filter is given, the first blocks are decrypted and checked by it before the rest of text.
      * 3) Applying SHA256 to original text and comparing it with sha256CheckSum from parsedFile.
      */
     bool isPasswordAcceptable(const std::string &password);
     
+    /**
+     * Performs steps 2) and 3) of isPasswordAcceptable for already computed MD5 of password.
+     * It allows to compute MD5 of many passwords at once (see md5Batch) and check them one by one.
+     */
+    bool isKeyAcceptable(const unsigned char *md5Digest);
+    
+    /**
+     * Performs isKeyAcceptable for count MD5 digests at md5Digests + i * md5DigestSize, which are computed
+     * for a whole batch of passwords at once (see CandidateBatch and Md5Engine::hashBatch). Bit i
+     * of acceptableKeys (resized to count) is set, if i-th key is acceptable. Returns number of acceptable keys.
+     * Decrypted text is left from the last checked key, so acceptable key should be checked once more
+     * by isKeyAcceptable to get its text. MultiTargetCheck::checkKeys does the same for several targets.
+     */
+    std::size_t checkKeys(const unsigned char *md5Digests, std::size_t count, boost::dynamic_bitset<> &acceptableKeys);
+    
     /**
      * Returns content from internal buffer with decrypted text.
      */
     std::string getDecryptedText() const;
+    
+    /**
+     * Returns true if padding prefilter can be applied to given file: its ciphertext should consist of whole blocks.
+     */
+    static bool isPaddingPrefilterApplicable(const ParsedFile &cypherFile);
+    
+    /**
+     * Returns plaintext filter limited to the text of file (see PlaintextFilter::limitTo).
+     */
+    const PlaintextFilter &getPlaintextFilter() const;
+    
+    /**
+     * Returns true if plaintext filter can be applied to given file: its ciphertext should consist of whole blocks
+     * and known prefix should fit into it.
+     */
+    static bool isPlaintextFilterApplicable(const ParsedFile &cypherFile, const PlaintextFilter &plaintextFilter);
+    
+    /**
+     * Returns true if decrypted block ends with valid PKCS#5/7 padding.
+     */
+    static bool isPaddingValid(const unsigned char *block, std::size_t blockSize);
 };
 
 #endif
@@ -0,0 +1,469 @@
+#include "crypto_backend.h"
+
+#include <gcrypt.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+
+#ifdef WITH_OPENSSL
+#include <openssl/evp.h>
+#include "../util/openssl_exception.h"
+#endif
+
+#include "md5_batch.h"
+#include "sha256_batch.h"
+#include "des_bitslice.h"
+
+#include "../util/gcry_exception.h"
+
+namespace
+{
+
+class BuiltinMd5Engine: public Md5Engine
+{
+public:
+    void hash(const unsigned char *message, std::size_t size, unsigned char *digest) override
+    {
+        md5Batch(&message, &size, 1, digest);
+    }
+
+    void hashBatch(const unsigned char *const *messages, const std::size_t *lengths, std::size_t count,
+                   unsigned char *digests) override
+    {
+        md5Batch(messages, lengths, count, digests);
+    }
+};
+
+/**
+ * Bitsliced 3DES with a single key uses one of 64 lanes, so it is only a portable fallback.
+ */
+class BuiltinTripleDesEngine: public TripleDesEngine
+{
+private:
+    BitslicedTripleDes bitslicedTripleDes;
+public:
+    BuiltinTripleDesEngine():
+        bitslicedTripleDes(64)
+    {}
+
+    void setKey(const unsigned char *key) override
+    {
+        bitslicedTripleDes.setKeys(key, 1);
+    }
+
+    void decrypt(const unsigned char *previousBlock, const unsigned char *cipherText, std::size_t size,
+                 unsigned char *plainText) override
+    {
+        bitslicedTripleDes.decrypt(previousBlock, cipherText, size / tripleDesBlockSize, plainText, size);
+    }
+};
+
+/**
+ * Multi-lane kernels would hash a single message in one lane, so SHA extensions are used if CPU supports them
+ * and scalar kernel otherwise.
+ */
+class BuiltinSha256Engine: public Sha256Engine
+{
+private:
+    Sha256Batch sha256Batch;
+public:
+    BuiltinSha256Engine():
+        sha256Batch(1, isSha256KernelSupported(Sha256Kernel::ShaNi) ? Sha256Kernel::ShaNi : Sha256Kernel::Scalar)
+    {}
+
+    void hash(const unsigned char *message, std::size_t size, unsigned char *digest) override
+    {
+        sha256Batch.reset(1);
+        sha256Batch.update(message, size, size);
+        std::copy_n(sha256Batch.finish(), sha256DigestSize, digest);
+    }
+};
+
+class GcryptMd5Engine: public Md5Engine
+{
+public:
+    void hash(const unsigned char *message, std::size_t size, unsigned char *digest) override
+    {
+        gcry_md_hash_buffer(GCRY_MD_MD5, digest, message, size);
+    }
+};
+
+class GcryptTripleDesEngine: public TripleDesEngine
+{
+private:
+    gcry_cipher_hd_t cipher;
+    unsigned char tripleDesKey[tripleDesEde2KeySize + tripleDesBlockSize];
+public:
+    GcryptTripleDesEngine():
+        cipher()
+    {
+        processGcryError(gcry_cipher_open(&cipher, GCRY_CIPHER_3DES, GCRY_CIPHER_MODE_CBC, 0));
+    }
+
+    ~GcryptTripleDesEngine()
+    {
+        gcry_cipher_close(cipher);
+    }
+
+    GcryptTripleDesEngine(const GcryptTripleDesEngine &) = delete;
+    GcryptTripleDesEngine &operator=(const GcryptTripleDesEngine &) = delete;
+
+    void setKey(const unsigned char *key) override
+    {
+        // Libgcrypt uses 24 bytes key, so EDE2 key is extended by its first DES key, which is used
+        // on phases 1 and 3.
+        std::copy_n(key, tripleDesEde2KeySize, tripleDesKey);
+        std::copy_n(key, tripleDesBlockSize, tripleDesKey + tripleDesEde2KeySize);
+        processGcryError(gcry_cipher_setkey(cipher, tripleDesKey, sizeof(tripleDesKey)));
+    }
+
+    void decrypt(const unsigned char *previousBlock, const unsigned char *cipherText, std::size_t size,
+                 unsigned char *plainText) override
+    {
+        // Setting initial value is needed before each decryption, or libgcrypt will consider
+        // that we decrypt one ciphertext by large blocks and will use the last block
+        // from previous decryption.
+        processGcryError(gcry_cipher_setiv(cipher, previousBlock, tripleDesBlockSize));
+        processGcryError(gcry_cipher_decrypt(cipher, plainText, size, cipherText, size));
+    }
+};
+
+class GcryptSha256Engine: public Sha256Engine
+{
+public:
+    void hash(const unsigned char *message, std::size_t size, unsigned char *digest) override
+    {
+        gcry_md_hash_buffer(GCRY_MD_SHA256, digest, message, size);
+    }
+};
+
+#ifdef WITH_OPENSSL
+/**
+ * OpenSSL digest with reused context, so that nothing is allocated per message.
+ */
+class OpenSslDigest
+{
+private:
+    const EVP_MD *digestType;
+    EVP_MD_CTX *context;
+public:
+    explicit OpenSslDigest(const EVP_MD *digestType):
+        digestType(digestType), context(EVP_MD_CTX_new())
+    {
+        if(context == nullptr)
+        {
+            throw OpenSslException();
+        }
+    }
+
+    ~OpenSslDigest()
+    {
+        EVP_MD_CTX_free(context);
+    }
+
+    OpenSslDigest(const OpenSslDigest &) = delete;
+    OpenSslDigest &operator=(const OpenSslDigest &) = delete;
+
+    void hash(const unsigned char *message, std::size_t size, unsigned char *digest)
+    {
+        processOpenSslResult(EVP_DigestInit_ex(context, digestType, nullptr));
+        processOpenSslResult(EVP_DigestUpdate(context, message, size));
+        processOpenSslResult(EVP_DigestFinal_ex(context, digest, nullptr));
+    }
+};
+
+class OpenSslMd5Engine: public Md5Engine
+{
+private:
+    OpenSslDigest digest;
+public:
+    OpenSslMd5Engine():
+        digest(EVP_md5())
+    {}
+
+    void hash(const unsigned char *message, std::size_t size, unsigned char *messageDigest) override
+    {
+        digest.hash(message, size, messageDigest);
+    }
+};
+
+class OpenSslTripleDesEngine: public TripleDesEngine
+{
+private:
+    EVP_CIPHER_CTX *context;
+public:
+    OpenSslTripleDesEngine():
+        context(EVP_CIPHER_CTX_new())
+    {
+        if(context == nullptr)
+        {
+            throw OpenSslException();
+        }
+    }
+
+    ~OpenSslTripleDesEngine()
+    {
+        EVP_CIPHER_CTX_free(context);
+    }
+
+    OpenSslTripleDesEngine(const OpenSslTripleDesEngine &) = delete;
+    OpenSslTripleDesEngine &operator=(const OpenSslTripleDesEngine &) = delete;
+
+    void setKey(const unsigned char *key) override
+    {
+        unsigned char tripleDesKey[tripleDesEde2KeySize + tripleDesBlockSize];
+        std::copy_n(key, tripleDesEde2KeySize, tripleDesKey);
+        std::copy_n(key, tripleDesBlockSize, tripleDesKey + tripleDesEde2KeySize);
+        processOpenSslResult(EVP_DecryptInit_ex(context, EVP_des_ede3_cbc(), nullptr, tripleDesKey, nullptr));
+        // Texts are decrypted by parts, padding is checked by the program itself.
+        processOpenSslResult(EVP_CIPHER_CTX_set_padding(context, 0));
+    }
+
+    void decrypt(const unsigned char *previousBlock, const unsigned char *cipherText, std::size_t size,
+                 unsigned char *plainText) override
+    {
+        // Initialization without cipher and key only sets initial value.
+        processOpenSslResult(EVP_DecryptInit_ex(context, nullptr, nullptr, nullptr, previousBlock));
+        int plainTextSize = 0;
+        processOpenSslResult(EVP_DecryptUpdate(context, plainText, &plainTextSize, cipherText,
+                                               static_cast<int>(size)));
+    }
+};
+
+class OpenSslSha256Engine: public Sha256Engine
+{
+private:
+    OpenSslDigest digest;
+public:
+    OpenSslSha256Engine():
+        digest(EVP_sha256())
+    {}
+
+    void hash(const unsigned char *message, std::size_t size, unsigned char *messageDigest) override
+    {
+        digest.hash(message, size, messageDigest);
+    }
+};
+#endif
+
+void checkAvailable(CryptoBackend backend)
+{
+    const std::vector<CryptoBackend> backends = getAvailableCryptoBackends();
+    if(std::find(backends.begin(), backends.end(), backend) == backends.end())
+    {
+        throw std::invalid_argument("ERROR in CryptoBackend: backend " + toString(backend) +
+                                    " isn't built into the program");
+    }
+}
+
+/**
+ * Returns time of one call of operation in seconds. Operation is repeated for at least a couple
+ * of milliseconds, so that timer resolution doesn't matter.
+ */
+double measure(const std::function<void()> &operation)
+{
+    const auto minDuration = std::chrono::milliseconds(2);
+    const auto start = std::chrono::steady_clock::now();
+    std::size_t calls = 0;
+    std::chrono::steady_clock::duration duration;
+    do
+    {
+        operation();
+        ++calls;
+        duration = std::chrono::steady_clock::now() - start;
+    } while(duration < minDuration);
+    return(std::chrono::duration<double>(duration).count() / calls);
+}
+
+/**
+ * Measures given stage for each backend and returns the fastest one. Speeds are reported in calls per second.
+ */
+CryptoBackend chooseFastest(const std::string &stage, std::ostream *report,
+                            const std::function<double(CryptoBackend)> &measureBackend)
+{
+    CryptoBackend fastestBackend = CryptoBackend::Builtin;
+    double fastestTime = 0;
+    if(report != nullptr)
+    {
+        *report << stage << ":";
+    }
+    for(const CryptoBackend backend: getAvailableCryptoBackends())
+    {
+        const double time = measureBackend(backend);
+        if(report != nullptr)
+        {
+            *report << " " << backend << " " << static_cast<unsigned long long>(1 / time) << "/s";
+        }
+        if(fastestTime == 0 || time < fastestTime)
+        {
+            fastestBackend = backend;
+            fastestTime = time;
+        }
+    }
+    if(report != nullptr)
+    {
+        *report << std::endl;
+    }
+    return(fastestBackend);
+}
+
+}
+
+std::string toString(CryptoBackend backend)
+{
+    switch(backend)
+    {
+        case CryptoBackend::Builtin:
+            return("builtin");
+        case CryptoBackend::Gcrypt:
+            return("gcrypt");
+        case CryptoBackend::OpenSsl:
+            return("openssl");
+    }
+    return("unknown");
+}
+
+std::ostream &operator<<(std::ostream &stream, CryptoBackend backend)
+{
+    return(stream << toString(backend));
+}
+
+std::ostream &operator<<(std::ostream &stream, const CryptoBackends &backends)
+{
+    return(stream << "md5=" << backends.md5 << ",3des=" << backends.tripleDes << ",sha256=" << backends.sha256);
+}
+
+CryptoBackend parseCryptoBackend(const std::string &name)
+{
+    for(const CryptoBackend backend: {CryptoBackend::Builtin, CryptoBackend::Gcrypt, CryptoBackend::OpenSsl})
+    {
+        if(name == toString(backend))
+        {
+            checkAvailable(backend);
+            return(backend);
+        }
+    }
+    throw std::invalid_argument("ERROR in parseCryptoBackend: unknown backend \"" + name + "\"");
+}
+
+std::vector<CryptoBackend> getAvailableCryptoBackends()
+{
+#ifdef WITH_OPENSSL
+    return(std::vector<CryptoBackend>({CryptoBackend::Builtin, CryptoBackend::Gcrypt, CryptoBackend::OpenSsl}));
+#else
+    return(std::vector<CryptoBackend>({CryptoBackend::Builtin, CryptoBackend::Gcrypt}));
+#endif
+}
+
+void Md5Engine::hashBatch(const unsigned char *const *messages, const std::size_t *lengths, std::size_t count,
+                          unsigned char *digests)
+{
+    for(std::size_t index = 0; index < count; ++index)
+    {
+        hash(messages[index], lengths[index], digests + index * md5DigestSize);
+    }
+}
+
+std::unique_ptr<Md5Engine> createMd5Engine(CryptoBackend backend)
+{
+    checkAvailable(backend);
+    switch(backend)
+    {
+        case CryptoBackend::Gcrypt:
+            return(std::unique_ptr<Md5Engine>(new GcryptMd5Engine()));
+#ifdef WITH_OPENSSL
+        case CryptoBackend::OpenSsl:
+            return(std::unique_ptr<Md5Engine>(new OpenSslMd5Engine()));
+#endif
+        default:
+            return(std::unique_ptr<Md5Engine>(new BuiltinMd5Engine()));
+    }
+}
+
+std::unique_ptr<TripleDesEngine> createTripleDesEngine(CryptoBackend backend)
+{
+    checkAvailable(backend);
+    switch(backend)
+    {
+        case CryptoBackend::Gcrypt:
+            return(std::unique_ptr<TripleDesEngine>(new GcryptTripleDesEngine()));
+#ifdef WITH_OPENSSL
+        case CryptoBackend::OpenSsl:
+            return(std::unique_ptr<TripleDesEngine>(new OpenSslTripleDesEngine()));
+#endif
+        default:
+            return(std::unique_ptr<TripleDesEngine>(new BuiltinTripleDesEngine()));
+    }
+}
+
+std::unique_ptr<Sha256Engine> createSha256Engine(CryptoBackend backend)
+{
+    checkAvailable(backend);
+    switch(backend)
+    {
+        case CryptoBackend::Gcrypt:
+            return(std::unique_ptr<Sha256Engine>(new GcryptSha256Engine()));
+#ifdef WITH_OPENSSL
+        case CryptoBackend::OpenSsl:
+            return(std::unique_ptr<Sha256Engine>(new OpenSslSha256Engine()));
+#endif
+        default:
+            return(std::unique_ptr<Sha256Engine>(new BuiltinSha256Engine()));
+    }
+}
+
+CryptoBackends calibrateCryptoBackends(std::size_t textSize, std::ostream *report)
+{
+    // Passwords of a typical length hashed in batches as search worker does. They differ in the last
+    // characters like consecutive passwords of odometer, so builtin MD5 skips only the steps of common prefix,
+    // as it does during search.
+    const std::size_t passwordsCount = 256, passwordLength = 8;
+    std::vector<unsigned char> passwords(passwordsCount * passwordLength, 'a');
+    std::vector<const unsigned char *> passwordPointers;
+    for(std::size_t index = 0; index < passwordsCount; ++index)
+    {
+        unsigned char *password = passwords.data() + index * passwordLength;
+        password[passwordLength - 2] = static_cast<unsigned char>('a' + index / 16);
+        password[passwordLength - 1] = static_cast<unsigned char>('a' + index % 16);
+        passwordPointers.push_back(password);
+    }
+    const std::vector<std::size_t> passwordLengths(passwordsCount, passwordLength);
+    std::vector<unsigned char> digests(passwordsCount * md5DigestSize);
+
+    // Text is limited, so calibration stays short, but is not shorter than a block.
+    const std::size_t maxTextSize = 16 * 1024;
+    const std::size_t sampleSize = std::max(std::min(textSize, maxTextSize) / tripleDesBlockSize, std::size_t(1)) *
+                                   tripleDesBlockSize;
+    const std::vector<unsigned char> cipherText(sampleSize, 0x5a), initialValue(tripleDesBlockSize, 0xa5);
+    std::vector<unsigned char> plainText(sampleSize);
+
+    CryptoBackends backends;
+    backends.md5 = chooseFastest("md5", report, [&](CryptoBackend backend)
+    {
+        const std::unique_ptr<Md5Engine> engine = createMd5Engine(backend);
+        return(measure([&]()
+        {
+            engine->hashBatch(passwordPointers.data(), passwordLengths.data(), passwordsCount, digests.data());
+        }) / passwordsCount);
+    });
+    backends.tripleDes = chooseFastest("3des", report, [&](CryptoBackend backend)
+    {
+        const std::unique_ptr<TripleDesEngine> engine = createTripleDesEngine(backend);
+        return(measure([&]()
+        {
+            engine->setKey(digests.data());
+            engine->decrypt(initialValue.data(), cipherText.data(), sampleSize, plainText.data());
+        }));
+    });
+    backends.sha256 = chooseFastest("sha256", report, [&](CryptoBackend backend)
+    {
+        const std::unique_ptr<Sha256Engine> engine = createSha256Engine(backend);
+        return(measure([&]()
+        {
+            engine->hash(plainText.data(), sampleSize, digests.data());
+        }));
+    });
+    return(backends);
+}
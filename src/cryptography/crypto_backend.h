@@ -0,0 +1,115 @@
+#ifndef CRYPTO_BACKEND_H
+#define CRYPTO_BACKEND_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <ostream>
+#include <cstddef>
+
+/**
+ * Libraries, which implement stages of checking password: built-in kernels of this program, libgcrypt and
+ * OpenSSL (available only if the program is built with it, see WITH_OPENSSL).
+ */
+enum class CryptoBackend
+{
+    Builtin,
+    Gcrypt,
+    OpenSsl
+};
+
+std::string toString(CryptoBackend backend);
+std::ostream &operator<<(std::ostream &stream, CryptoBackend backend);
+
+/**
+ * Parses name of backend: builtin, gcrypt or openssl. Throws std::invalid_argument for unknown names
+ * and for backends, which are not built into the program.
+ */
+CryptoBackend parseCryptoBackend(const std::string &name);
+
+/**
+ * Returns backends built into the program.
+ */
+std::vector<CryptoBackend> getAvailableCryptoBackends();
+
+/**
+ * Backends of each stage of checking password. By default they are the ones used before backends were
+ * introduced: built-in multi-buffer MD5 and libgcrypt for 3DES and SHA256.
+ */
+struct CryptoBackends
+{
+    CryptoBackend md5 = CryptoBackend::Builtin;
+    CryptoBackend tripleDes = CryptoBackend::Gcrypt;
+    CryptoBackend sha256 = CryptoBackend::Gcrypt;
+};
+
+std::ostream &operator<<(std::ostream &stream, const CryptoBackends &backends);
+
+/**
+ * Computes MD5 of passwords.
+ */
+class Md5Engine
+{
+public:
+    virtual ~Md5Engine() = default;
+
+    virtual void hash(const unsigned char *message, std::size_t size, unsigned char *digest) = 0;
+
+    /**
+     * Computes MD5 of count messages, message i starts at messages[i] and has length lengths[i], its digest
+     * is written into digests + i * md5DigestSize. By default messages are hashed one by one.
+     */
+    virtual void hashBatch(const unsigned char *const *messages, const std::size_t *lengths, std::size_t count,
+                           unsigned char *digests);
+};
+
+/**
+ * Decrypts ciphertext by 3DES (EDE2) in CBC mode under one key at a time.
+ * Objects of this class and of its descendants are not thread safe.
+ */
+class TripleDesEngine
+{
+public:
+    virtual ~TripleDesEngine() = default;
+
+    /**
+     * Sets EDE2 key of tripleDesEde2KeySize bytes: the first DES key followed by the second one.
+     */
+    virtual void setKey(const unsigned char *key) = 0;
+
+    /**
+     * Decrypts size bytes (whole blocks) of cipherText into plainText. previousBlock is a ciphertext block
+     * before the first one (initial value, if decryption starts from the beginning of ciphertext).
+     */
+    virtual void decrypt(const unsigned char *previousBlock, const unsigned char *cipherText, std::size_t size,
+                         unsigned char *plainText) = 0;
+};
+
+/**
+ * Computes SHA256 of decrypted texts.
+ */
+class Sha256Engine
+{
+public:
+    virtual ~Sha256Engine() = default;
+
+    virtual void hash(const unsigned char *message, std::size_t size, unsigned char *digest) = 0;
+};
+
+/**
+ * Factories of engines of given backend. Throw std::invalid_argument if backend isn't built into the program
+ * and CryptoException if library fails to initialize.
+ */
+std::unique_ptr<Md5Engine> createMd5Engine(CryptoBackend backend);
+std::unique_ptr<TripleDesEngine> createTripleDesEngine(CryptoBackend backend);
+std::unique_ptr<Sha256Engine> createSha256Engine(CryptoBackend backend);
+
+/**
+ * Measures speed of each stage with each available backend on current CPU and returns the fastest ones.
+ * Stages are measured as they are used in the search: MD5 of batches of short passwords, setting key with
+ * decryption and SHA256 of text of given size (limited to a few kilobytes, so calibration takes
+ * a few milliseconds per backend). If report is given, measured speeds are written into it.
+ */
+CryptoBackends calibrateCryptoBackends(std::size_t textSize, std::ostream *report = nullptr);
+
+#endif
@@ -0,0 +1,530 @@
+#include "des_bitslice.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "../util/cpu_features.h"
+
+namespace
+{
+
+// Standard DES tables from FIPS 46-3. Bits are numbered from 1, starting from the most significant bit.
+const unsigned char initialPermutation[64] =
+{
+    58, 50, 42, 34, 26, 18, 10, 2,
+    60, 52, 44, 36, 28, 20, 12, 4,
+    62, 54, 46, 38, 30, 22, 14, 6,
+    64, 56, 48, 40, 32, 24, 16, 8,
+    57, 49, 41, 33, 25, 17, 9, 1,
+    59, 51, 43, 35, 27, 19, 11, 3,
+    61, 53, 45, 37, 29, 21, 13, 5,
+    63, 55, 47, 39, 31, 23, 15, 7
+};
+
+constexpr unsigned char expansion[48] =
+{
+    32, 1, 2, 3, 4, 5,
+    4, 5, 6, 7, 8, 9,
+    8, 9, 10, 11, 12, 13,
+    12, 13, 14, 15, 16, 17,
+    16, 17, 18, 19, 20, 21,
+    20, 21, 22, 23, 24, 25,
+    24, 25, 26, 27, 28, 29,
+    28, 29, 30, 31, 32, 1
+};
+
+constexpr unsigned char permutation[32] =
+{
+    16, 7, 20, 21, 29, 12, 28, 17,
+    1, 15, 23, 26, 5, 18, 31, 10,
+    2, 8, 24, 14, 32, 27, 3, 9,
+    19, 13, 30, 6, 22, 11, 4, 25
+};
+
+const unsigned char permutedChoice1[56] =
+{
+    57, 49, 41, 33, 25, 17, 9,
+    1, 58, 50, 42, 34, 26, 18,
+    10, 2, 59, 51, 43, 35, 27,
+    19, 11, 3, 60, 52, 44, 36,
+    63, 55, 47, 39, 31, 23, 15,
+    7, 62, 54, 46, 38, 30, 22,
+    14, 6, 61, 53, 45, 37, 29,
+    21, 13, 5, 28, 20, 12, 4
+};
+
+const unsigned char permutedChoice2[48] =
+{
+    14, 17, 11, 24, 1, 5,
+    3, 28, 15, 6, 21, 10,
+    23, 19, 12, 4, 26, 8,
+    16, 7, 27, 20, 13, 2,
+    41, 52, 31, 37, 47, 55,
+    30, 40, 51, 45, 33, 48,
+    44, 49, 39, 56, 34, 53,
+    46, 42, 50, 36, 29, 32
+};
+
+const unsigned char keyShifts[16] = {1, 1, 2, 2, 2, 2, 2, 2, 1, 2, 2, 2, 2, 2, 2, 1};
+
+constexpr unsigned char substitutionBoxes[8][4][16] =
+{
+    {
+        {14, 4, 13, 1, 2, 15, 11, 8, 3, 10, 6, 12, 5, 9, 0, 7},
+        {0, 15, 7, 4, 14, 2, 13, 1, 10, 6, 12, 11, 9, 5, 3, 8},
+        {4, 1, 14, 8, 13, 6, 2, 11, 15, 12, 9, 7, 3, 10, 5, 0},
+        {15, 12, 8, 2, 4, 9, 1, 7, 5, 11, 3, 14, 10, 0, 6, 13}
+    },
+    {
+        {15, 1, 8, 14, 6, 11, 3, 4, 9, 7, 2, 13, 12, 0, 5, 10},
+        {3, 13, 4, 7, 15, 2, 8, 14, 12, 0, 1, 10, 6, 9, 11, 5},
+        {0, 14, 7, 11, 10, 4, 13, 1, 5, 8, 12, 6, 9, 3, 2, 15},
+        {13, 8, 10, 1, 3, 15, 4, 2, 11, 6, 7, 12, 0, 5, 14, 9}
+    },
+    {
+        {10, 0, 9, 14, 6, 3, 15, 5, 1, 13, 12, 7, 11, 4, 2, 8},
+        {13, 7, 0, 9, 3, 4, 6, 10, 2, 8, 5, 14, 12, 11, 15, 1},
+        {13, 6, 4, 9, 8, 15, 3, 0, 11, 1, 2, 12, 5, 10, 14, 7},
+        {1, 10, 13, 0, 6, 9, 8, 7, 4, 15, 14, 3, 11, 5, 2, 12}
+    },
+    {
+        {7, 13, 14, 3, 0, 6, 9, 10, 1, 2, 8, 5, 11, 12, 4, 15},
+        {13, 8, 11, 5, 6, 15, 0, 3, 4, 7, 2, 12, 1, 10, 14, 9},
+        {10, 6, 9, 0, 12, 11, 7, 13, 15, 1, 3, 14, 5, 2, 8, 4},
+        {3, 15, 0, 6, 10, 1, 13, 8, 9, 4, 5, 11, 12, 7, 2, 14}
+    },
+    {
+        {2, 12, 4, 1, 7, 10, 11, 6, 8, 5, 3, 15, 13, 0, 14, 9},
+        {14, 11, 2, 12, 4, 7, 13, 1, 5, 0, 15, 10, 3, 9, 8, 6},
+        {4, 2, 1, 11, 10, 13, 7, 8, 15, 9, 12, 5, 6, 3, 0, 14},
+        {11, 8, 12, 7, 1, 14, 2, 13, 6, 15, 0, 9, 10, 4, 5, 3}
+    },
+    {
+        {12, 1, 10, 15, 9, 2, 6, 8, 0, 13, 3, 4, 14, 7, 5, 11},
+        {10, 15, 4, 2, 7, 12, 9, 5, 6, 1, 13, 14, 0, 11, 3, 8},
+        {9, 14, 15, 5, 2, 8, 12, 3, 7, 0, 4, 10, 1, 13, 11, 6},
+        {4, 3, 2, 12, 9, 5, 15, 10, 11, 14, 1, 7, 6, 0, 8, 13}
+    },
+    {
+        {4, 11, 2, 14, 15, 0, 8, 13, 3, 12, 9, 7, 5, 10, 6, 1},
+        {13, 0, 11, 7, 4, 9, 1, 10, 14, 3, 5, 12, 2, 15, 8, 6},
+        {1, 4, 11, 13, 12, 3, 7, 14, 10, 15, 6, 8, 0, 5, 9, 2},
+        {6, 11, 13, 8, 1, 4, 10, 7, 9, 5, 0, 15, 14, 2, 3, 12}
+    },
+    {
+        {13, 2, 8, 4, 6, 15, 11, 1, 10, 9, 3, 14, 5, 0, 12, 7},
+        {1, 15, 13, 8, 10, 3, 7, 4, 12, 5, 6, 11, 0, 14, 9, 2},
+        {7, 11, 4, 1, 9, 12, 14, 2, 0, 6, 10, 13, 15, 3, 5, 8},
+        {2, 1, 14, 7, 4, 10, 8, 13, 15, 12, 9, 0, 3, 5, 6, 11}
+    }
+};
+
+/**
+ * Tables derived from the standard ones, which are used by bitsliced rounds. All indices are zero based.
+ */
+struct BitsliceTables
+{
+    // Final permutation (inverse of initial one).
+    unsigned char finalPermutation[64];
+    // Index of key bit (in 64 bit key) used as j-th bit of subkey of each round.
+    unsigned char subkeyBits[16][48];
+    
+    BitsliceTables()
+    {
+        for(unsigned int bit = 0; bit < 64; ++bit)
+        {
+            finalPermutation[initialPermutation[bit] - 1] = bit;
+        }
+        
+        // Key schedule: C and D halves are rotated independently, subkey is chosen from them by PC2.
+        unsigned char halves[56];
+        std::transform(permutedChoice1, permutedChoice1 + 56, halves, [](unsigned char bit)
+        {
+            return(bit - 1);
+        });
+        for(unsigned int round = 0; round < 16; ++round)
+        {
+            std::rotate(halves, halves + keyShifts[round], halves + 28);
+            std::rotate(halves + 28, halves + 28 + keyShifts[round], halves + 56);
+            for(unsigned int bit = 0; bit < 48; ++bit)
+            {
+                subkeyBits[round][bit] = halves[permutedChoice2[bit] - 1];
+            }
+        }
+    }
+};
+
+/**
+ * Multiplexer networks of S-boxes. They are computed at compile time, so when the round is unrolled, all the
+ * choices inside networks become constants and compiler removes duplicated and trivial multiplexers.
+ */
+struct SubstitutionNetwork
+{
+    // Position in the output of round function, where output bit of S-boxes goes after permutation.
+    unsigned char targets[32];
+    // For each S-box, its output bit and value of the first four input bits the S-box output
+    // as a function of the last two input bits. Such function is encoded as its 4 bit truth table.
+    unsigned char functions[8][4][16];
+    
+    constexpr SubstitutionNetwork():
+        targets(), functions()
+    {
+        for(unsigned int bit = 0; bit < 32; ++bit)
+        {
+            targets[permutation[bit] - 1] = bit;
+        }
+        
+        // S-box input b1..b6: row is b1b6 and column is b2b3b4b5. Output bits are numbered from the most significant.
+        for(unsigned int box = 0; box < 8; ++box)
+        {
+            for(unsigned int outputBit = 0; outputBit < 4; ++outputBit)
+            {
+                for(unsigned int highBits = 0; highBits < 16; ++highBits)
+                {
+                    unsigned int function = 0;
+                    for(unsigned int lowBits = 0; lowBits < 4; ++lowBits)
+                    {
+                        const unsigned int input = highBits * 4 + lowBits;
+                        const unsigned int row = ((input >> 4) & 2) | (input & 1);
+                        const unsigned int column = (input >> 1) & 0xf;
+                        const unsigned int output = substitutionBoxes[box][row][column];
+                        function |= ((output >> (3 - outputBit)) & 1) << lowBits;
+                    }
+                    functions[box][outputBit][highBits] = function;
+                }
+            }
+        }
+    }
+};
+
+constexpr SubstitutionNetwork substitutionNetwork;
+
+const BitsliceTables &getBitsliceTables()
+{
+    static const BitsliceTables tables;
+    return(tables);
+}
+
+/**
+ * Transposes 64x64 bit matrix. Rows are words, columns are numbered from the most significant bit.
+ */
+void transpose64(std::uint64_t *rows)
+{
+    std::uint64_t mask = 0x00000000ffffffffULL;
+    for(unsigned int width = 32; width != 0; width >>= 1, mask ^= mask << width)
+    {
+        for(unsigned int row = 0; row < 64; row = ((row | width) + 1) & ~width)
+        {
+            const std::uint64_t swapped = (rows[row] ^ (rows[row | width] >> width)) & mask;
+            rows[row] ^= swapped;
+            rows[row | width] ^= swapped << width;
+        }
+    }
+}
+
+std::uint64_t loadBigEndian(const unsigned char *bytes)
+{
+    std::uint64_t value = 0;
+    for(unsigned int byteIndex = 0; byteIndex < 8; ++byteIndex)
+    {
+        value = (value << 8) | bytes[byteIndex];
+    }
+    return(value);
+}
+
+void storeBigEndian(std::uint64_t value, unsigned char *bytes)
+{
+    for(unsigned int byteIndex = 8; byteIndex > 0; --byteIndex, value >>= 8)
+    {
+        bytes[byteIndex - 1] = static_cast<unsigned char>(value);
+    }
+}
+
+// Following templates are written for Vector being either std::uint64_t or GCC vector of std::uint64_t.
+// They are forced to be inlined into kernels, which are compiled for specific instruction set.
+// Vectors are passed by reference, because passing wide vectors by value changes ABI depending on instruction set.
+
+template<class Vector>
+inline __attribute__((always_inline)) void multiplex(Vector &result, const Vector &whenZero, const Vector &whenOne,
+                                                     const Vector &selector)
+{
+    result = whenZero ^ ((whenZero ^ whenOne) & selector);
+}
+
+/**
+ * One round of DES: left ^= P(S(E(right) ^ subkey)).
+ */
+template<class Vector>
+inline __attribute__((always_inline)) void desRound(Vector *left, const Vector *right, const Vector *key,
+                                                    const unsigned char *subkeyBits)
+{
+    #pragma GCC unroll 8
+    for(unsigned int box = 0; box < 8; ++box)
+    {
+        Vector input[6];
+        #pragma GCC unroll 6
+        for(unsigned int bit = 0; bit < 6; ++bit)
+        {
+            input[bit] = right[expansion[6 * box + bit] - 1] ^ key[subkeyBits[6 * box + bit]];
+        }
+        
+        // All 16 boolean functions of the last two inputs. S-box outputs are multiplexed from them
+        // by the first four inputs.
+        Vector functions[16], minterms[4];
+        const Vector notFifth = ~input[4], notSixth = ~input[5];
+        minterms[0] = notFifth & notSixth;
+        minterms[1] = notFifth & input[5];
+        minterms[2] = input[4] & notSixth;
+        minterms[3] = input[4] & input[5];
+        functions[0] = Vector{};
+        #pragma GCC unroll 16
+        for(unsigned int function = 1; function < 16; ++function)
+        {
+            functions[function] = functions[function & (function - 1)] | minterms[__builtin_ctz(function)];
+        }
+        
+        #pragma GCC unroll 4
+        for(unsigned int outputBit = 0; outputBit < 4; ++outputBit)
+        {
+            const unsigned char *codes = substitutionNetwork.functions[box][outputBit];
+            Vector level[8];
+            #pragma GCC unroll 8
+            for(unsigned int index = 0; index < 8; ++index)
+            {
+                multiplex(level[index], functions[codes[2 * index]], functions[codes[2 * index + 1]], input[3]);
+            }
+            #pragma GCC unroll 3
+            for(unsigned int inputBit = 3; inputBit > 0; --inputBit)
+            {
+                #pragma GCC unroll 4
+                for(unsigned int index = 0; index < (1u << (inputBit - 1)); ++index)
+                {
+                    multiplex(level[index], level[2 * index], level[2 * index + 1], input[inputBit - 1]);
+                }
+            }
+            left[substitutionNetwork.targets[4 * box + outputBit]] ^= level[0];
+        }
+    }
+}
+
+/**
+ * Full DES (16 rounds) on halves in initially permuted domain. Halves pointers are swapped in such way,
+ * that after the call left and right are halves of the output in initially permuted domain.
+ */
+template<class Vector>
+inline __attribute__((always_inline)) void desRounds(Vector *&left, Vector *&right, const Vector *key,
+                                                     bool decryption, const BitsliceTables &tables)
+{
+    for(unsigned int round = 0; round < 16; ++round)
+    {
+        desRound(left, right, key, tables.subkeyBits[decryption ? 15 - round : round]);
+        std::swap(left, right);
+    }
+    // The last round doesn't swap halves.
+    std::swap(left, right);
+}
+
+template<class Vector>
+inline __attribute__((always_inline)) void tripleDesDecryptSlices(const std::uint64_t *keySlices,
+                                                                  std::size_t keysCount,
+                                                                  const unsigned char *previousBlock,
+                                                                  const unsigned char *cipherText,
+                                                                  std::size_t blocksCount,
+                                                                  unsigned char *plainTexts,
+                                                                  std::size_t plainTextStride)
+{
+    constexpr std::size_t words = sizeof(Vector) / sizeof(std::uint64_t);
+    const BitsliceTables &tables = getBitsliceTables();
+    
+    Vector keys[128];
+    std::memcpy(keys, keySlices, sizeof(keys));
+    
+    for(std::size_t blockIndex = 0; blockIndex < blocksCount; ++blockIndex)
+    {
+        const unsigned char *block = cipherText + blockIndex * tripleDesBlockSize;
+        
+        // Ciphertext is the same for all keys, so each its bit is broadcasted to the whole word.
+        Vector halves[64];
+        for(unsigned int bit = 0; bit < 64; ++bit)
+        {
+            const unsigned int sourceBit = initialPermutation[bit] - 1;
+            const std::uint64_t value = (block[sourceBit / 8] >> (7 - sourceBit % 8)) & 1;
+            halves[bit] = Vector{} - value;
+        }
+        
+        // Decryption of EDE2 is D(K1), E(K2), D(K1). Final and initial permutations between phases cancel each other.
+        Vector *left = halves, *right = halves + 32;
+        desRounds(left, right, keys, true, tables);
+        desRounds(left, right, keys + 64, false, tables);
+        desRounds(left, right, keys, true, tables);
+        
+        Vector output[64];
+        for(unsigned int bit = 0; bit < 64; ++bit)
+        {
+            const unsigned int sourceBit = tables.finalPermutation[bit];
+            const std::uint64_t chainBit = (previousBlock[bit / 8] >> (7 - bit % 8)) & 1;
+            output[bit] = (sourceBit < 32 ? left[sourceBit] : right[sourceBit - 32]) ^ (Vector{} - chainBit);
+        }
+        previousBlock = block;
+        
+        // Transposing bitsliced output back to blocks, 64 keys at once.
+        std::uint64_t outputWords[64][words];
+        std::memcpy(outputWords, output, sizeof(outputWords));
+        for(std::size_t word = 0; word < words && word * 64 < keysCount; ++word)
+        {
+            std::uint64_t rows[64];
+            for(unsigned int bit = 0; bit < 64; ++bit)
+            {
+                rows[bit] = outputWords[bit][word];
+            }
+            transpose64(rows);
+            
+            const std::size_t lanesInWord = std::min<std::size_t>(64, keysCount - word * 64);
+            for(std::size_t lane = 0; lane < lanesInWord; ++lane)
+            {
+                storeBigEndian(rows[lane], plainTexts + (word * 64 + lane) * plainTextStride +
+                                           blockIndex * tripleDesBlockSize);
+            }
+        }
+    }
+}
+
+void tripleDesDecrypt64(const std::uint64_t *keySlices, std::size_t keysCount, const unsigned char *previousBlock,
+                        const unsigned char *cipherText, std::size_t blocksCount, unsigned char *plainTexts,
+                        std::size_t plainTextStride)
+{
+    tripleDesDecryptSlices<std::uint64_t>(keySlices, keysCount, previousBlock, cipherText, blocksCount,
+                                          plainTexts, plainTextStride);
+}
+
+void tripleDesDecrypt128(const std::uint64_t *keySlices, std::size_t keysCount, const unsigned char *previousBlock,
+                         const unsigned char *cipherText, std::size_t blocksCount, unsigned char *plainTexts,
+                         std::size_t plainTextStride)
+{
+    typedef std::uint64_t Vector __attribute__((vector_size(16)));
+    tripleDesDecryptSlices<Vector>(keySlices, keysCount, previousBlock, cipherText, blocksCount,
+                                   plainTexts, plainTextStride);
+}
+
+void tripleDesDecrypt256(const std::uint64_t *keySlices, std::size_t keysCount, const unsigned char *previousBlock,
+                         const unsigned char *cipherText, std::size_t blocksCount, unsigned char *plainTexts,
+                         std::size_t plainTextStride)
+{
+    typedef std::uint64_t Vector __attribute__((vector_size(32)));
+    tripleDesDecryptSlices<Vector>(keySlices, keysCount, previousBlock, cipherText, blocksCount,
+                                   plainTexts, plainTextStride);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+void tripleDesDecrypt256AVX2(const std::uint64_t *keySlices, std::size_t keysCount,
+                             const unsigned char *previousBlock, const unsigned char *cipherText,
+                             std::size_t blocksCount, unsigned char *plainTexts, std::size_t plainTextStride)
+{
+    typedef std::uint64_t Vector __attribute__((vector_size(32)));
+    tripleDesDecryptSlices<Vector>(keySlices, keysCount, previousBlock, cipherText, blocksCount,
+                                   plainTexts, plainTextStride);
+}
+
+// AVX-512VL allows compiler to use ternary logic instructions on 256 bit vectors (one instruction per multiplexer).
+__attribute__((target("avx512f,avx512vl")))
+void tripleDesDecrypt256AVX512(const std::uint64_t *keySlices, std::size_t keysCount,
+                               const unsigned char *previousBlock, const unsigned char *cipherText,
+                               std::size_t blocksCount, unsigned char *plainTexts, std::size_t plainTextStride)
+{
+    typedef std::uint64_t Vector __attribute__((vector_size(32)));
+    tripleDesDecryptSlices<Vector>(keySlices, keysCount, previousBlock, cipherText, blocksCount,
+                                   plainTexts, plainTextStride);
+}
+#endif
+
+}
+
+BitslicedTripleDes::BitslicedTripleDes(std::size_t lanes):
+    lanes(lanes), keysCount(0), keySlices(128 * lanes / 64, 0)
+{
+    if(lanes != 64 && lanes != 128 && lanes != 256)
+    {
+        throw std::invalid_argument("ERROR in BitslicedTripleDes: number of lanes must be 64, 128 or 256.");
+    }
+    // Building tables before first decryption.
+    getBitsliceTables();
+}
+
+std::size_t BitslicedTripleDes::getLanes() const
+{
+    return(lanes);
+}
+
+void BitslicedTripleDes::setKeys(const unsigned char *keys, std::size_t keysCount)
+{
+    if(keysCount > lanes)
+    {
+        throw std::invalid_argument("ERROR in BitslicedTripleDes: number of keys exceeds number of lanes.");
+    }
+    this->keysCount = keysCount;
+    
+    // Slices are stored in the same layout as vectors of lanes bits: slice after slice, word after word inside slice.
+    const std::size_t words = lanes / 64;
+    for(std::size_t word = 0; word < words; ++word)
+    {
+        for(std::size_t keyHalf = 0; keyHalf < 2; ++keyHalf)
+        {
+            std::uint64_t rows[64];
+            for(std::size_t lane = 0; lane < 64; ++lane)
+            {
+                const std::size_t keyIndex = word * 64 + lane;
+                rows[lane] = keyIndex < keysCount ?
+                             loadBigEndian(keys + keyIndex * tripleDesEde2KeySize + keyHalf * tripleDesBlockSize) :
+                             0;
+            }
+            transpose64(rows);
+            for(std::size_t bit = 0; bit < 64; ++bit)
+            {
+                keySlices[(keyHalf * 64 + bit) * words + word] = rows[bit];
+            }
+        }
+    }
+}
+
+void BitslicedTripleDes::decrypt(const unsigned char *previousBlock, const unsigned char *cipherText,
+                                 std::size_t blocksCount, unsigned char *plainTexts,
+                                 std::size_t plainTextStride) const
+{
+    switch(lanes)
+    {
+        case 64:
+            tripleDesDecrypt64(keySlices.data(), keysCount, previousBlock, cipherText, blocksCount,
+                               plainTexts, plainTextStride);
+            break;
+        case 128:
+            tripleDesDecrypt128(keySlices.data(), keysCount, previousBlock, cipherText, blocksCount,
+                                plainTexts, plainTextStride);
+            break;
+        default:
+#if defined(__x86_64__) || defined(__i386__)
+            if(getCpuFeatures().avx512)
+            {
+                tripleDesDecrypt256AVX512(keySlices.data(), keysCount, previousBlock, cipherText, blocksCount,
+                                          plainTexts, plainTextStride);
+                break;
+            }
+            if(getCpuFeatures().avx2)
+            {
+                tripleDesDecrypt256AVX2(keySlices.data(), keysCount, previousBlock, cipherText, blocksCount,
+                                        plainTexts, plainTextStride);
+                break;
+            }
+#endif
+            tripleDesDecrypt256(keySlices.data(), keysCount, previousBlock, cipherText, blocksCount,
+                                plainTexts, plainTextStride);
+            break;
+    }
+}
+
+std::size_t BitslicedTripleDes::getBestLanes()
+{
+    // Without AVX2, 256 bit vectors are emulated by pairs of 128 bit ones, which gives no gain.
+    return(getCpuFeatures().avx2 ? 256 : 128);
+}
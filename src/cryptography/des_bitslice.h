@@ -0,0 +1,58 @@
+#ifndef DES_BITSLICE_H
+#define DES_BITSLICE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Size of 3DES block and size of 3DES EDE2 key (two DES keys, the first one is used for phases 1 and 3).
+ */
+constexpr std::size_t tripleDesBlockSize = 8;
+constexpr std::size_t tripleDesEde2KeySize = 16;
+
+/**
+ * Class BitslicedTripleDes is a bitsliced implementation of 3DES (EDE2) decryption in CBC mode.
+ * It decrypts the same ciphertext under many different keys at once: bit i of all blocks (one block per key)
+ * is stored in one machine word (or SIMD vector) and DES is evaluated by boolean operations on such words,
+ * so each operation processes all keys. In such representation all permutations of DES (including key schedule)
+ * are just a choice of word, so subkeys are taken from the key bits directly during rounds.
+ * S-boxes are evaluated by multiplexer networks, which are built from their tables at compile time.
+ *
+ * Number of keys processed at once (lanes) is 64 (64 bit words), 128 or 256 (SIMD vectors).
+ * Objects of this class are not thread safe.
+ */
+class BitslicedTripleDes
+{
+private:
+    std::size_t lanes, keysCount;
+    // Bitsliced keys: 128 words (64 bits of first DES key followed by 64 bits of second one) of lanes bits each.
+    std::vector<std::uint64_t> keySlices;
+public:
+    /**
+     * Creates an engine for given number of lanes, which must be 64, 128 or 256.
+     */
+    explicit BitslicedTripleDes(std::size_t lanes = getBestLanes());
+    
+    std::size_t getLanes() const;
+    
+    /**
+     * Sets keysCount (not more than lanes) EDE2 keys of tripleDesEde2KeySize bytes each, stored one after another.
+     */
+    void setKeys(const unsigned char *keys, std::size_t keysCount);
+    
+    /**
+     * Decrypts blocksCount blocks of cipherText in CBC mode under each key, set by setKeys.
+     * previousBlock is a ciphertext block before the first one (initial value, if decryption starts
+     * from the beginning of ciphertext). Decrypted text for key i is written into plainTexts + i * plainTextStride.
+     */
+    void decrypt(const unsigned char *previousBlock, const unsigned char *cipherText, std::size_t blocksCount,
+                 unsigned char *plainTexts, std::size_t plainTextStride) const;
+    
+    /**
+     * Returns the widest number of lanes, which is efficient on current CPU.
+     */
+    static std::size_t getBestLanes();
+};
+
+#endif
@@ -0,0 +1,518 @@
+#include "md5_batch.h"
+
+#include <gcrypt.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+
+// Sines table and per step rotations from RFC 1321.
+const std::uint32_t md5Sines[64] =
+{
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee,
+    0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+    0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be,
+    0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+    0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa,
+    0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed,
+    0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+    0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c,
+    0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+    0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05,
+    0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039,
+    0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+    0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
+    0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+};
+
+const unsigned int md5Rotations[4][4] =
+{
+    {7, 12, 17, 22},
+    {5, 9, 14, 20},
+    {4, 11, 16, 23},
+    {6, 10, 15, 21}
+};
+
+const std::uint32_t md5InitialState[4] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476};
+
+// Steps of each word of block: word w is read by step w of the first round and by one step of each other round.
+const unsigned int md5WordSteps[16][4] =
+{
+    {0, 19, 41, 48},
+    {1, 16, 36, 55},
+    {2, 29, 47, 62},
+    {3, 26, 42, 53},
+    {4, 23, 37, 60},
+    {5, 20, 32, 51},
+    {6, 17, 43, 58},
+    {7, 30, 38, 49},
+    {8, 27, 33, 56},
+    {9, 24, 44, 63},
+    {10, 21, 39, 54},
+    {11, 18, 34, 61},
+    {12, 31, 45, 52},
+    {13, 28, 40, 59},
+    {14, 25, 35, 50},
+    {15, 22, 46, 57}
+};
+
+inline unsigned int md5WordIndex(unsigned int step)
+{
+    switch(step / 16)
+    {
+        case 0:
+            return(step);
+        case 1:
+            return((5 * step + 1) % 16);
+        case 2:
+            return((3 * step + 5) % 16);
+        default:
+            return((7 * step) % 16);
+    }
+}
+
+// Following templates are written for Vector being either std::uint32_t or GCC vector of std::uint32_t,
+// so the same code is used by scalar and SIMD kernels. They are forced to be inlined into kernels,
+// which are compiled for specific instruction set.
+// Vectors are passed by reference, because passing wide vectors by value changes ABI depending on instruction set.
+
+// Step of MD5, addend is the word read by the step plus its sine.
+template<class Vector>
+inline __attribute__((always_inline)) void md5Step(unsigned int step, Vector &a, const Vector &b, const Vector &c,
+                                                   const Vector &d, const Vector &addend)
+{
+    Vector mixed;
+    switch(step / 16)
+    {
+        case 0:
+            mixed = d ^ (b & (c ^ d));
+            break;
+        case 1:
+            mixed = c ^ (d & (b ^ c));
+            break;
+        case 2:
+            mixed = b ^ c ^ d;
+            break;
+        default:
+            mixed = c ^ (b | ~d);
+            break;
+    }
+    
+    const unsigned int rotation = md5Rotations[step / 16][step % 4];
+    const Vector sum = a + mixed + addend;
+    a = b + ((sum << rotation) | (sum >> (32 - rotation)));
+}
+
+template<class Vector>
+inline __attribute__((always_inline)) void md5Compress(const Vector *words, Vector *state)
+{
+    Vector a = state[0], b = state[1], c = state[2], d = state[3];
+    // Full unrolling makes step dependent values (round function, word index, rotation) compile time constants.
+    #pragma GCC unroll 64
+    for(unsigned int step = 0; step < 64; ++step)
+    {
+        md5Step(step, a, b, c, d, words[md5WordIndex(step)] + md5Sines[step]);
+        const Vector previousD = d;
+        d = c;
+        c = b;
+        b = a;
+        a = previousD;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+}
+
+/**
+ * Compresses block from state midState, which is reached after steps before FirstStep, by the rest of steps
+ * with precomputed addends (word plus sine) of each step and adds the result to the initial state.
+ */
+template<unsigned int FirstStep, class Vector>
+inline __attribute__((always_inline)) void md5CompressFrom(const Vector *addends, const Vector *midState,
+                                                           Vector *state)
+{
+    Vector a = midState[0], b = midState[1], c = midState[2], d = midState[3];
+    #pragma GCC unroll 64
+    for(unsigned int step = FirstStep; step < 64; ++step)
+    {
+        md5Step(step, a, b, c, d, addends[step]);
+        const Vector previousD = d;
+        d = c;
+        c = b;
+        b = a;
+        a = previousD;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+}
+
+// Steps are compile time constants in unrolled compression, so the first step is selected by switch.
+template<class Vector>
+inline __attribute__((always_inline)) void md5CompressFrom(unsigned int firstStep, const Vector *addends,
+                                                           const Vector *midState, Vector *state)
+{
+    switch(firstStep)
+    {
+        case 0: md5CompressFrom<0>(addends, midState, state); break;
+        case 1: md5CompressFrom<1>(addends, midState, state); break;
+        case 2: md5CompressFrom<2>(addends, midState, state); break;
+        case 3: md5CompressFrom<3>(addends, midState, state); break;
+        case 4: md5CompressFrom<4>(addends, midState, state); break;
+        case 5: md5CompressFrom<5>(addends, midState, state); break;
+        case 6: md5CompressFrom<6>(addends, midState, state); break;
+        case 7: md5CompressFrom<7>(addends, midState, state); break;
+        case 8: md5CompressFrom<8>(addends, midState, state); break;
+        case 9: md5CompressFrom<9>(addends, midState, state); break;
+        case 10: md5CompressFrom<10>(addends, midState, state); break;
+        case 11: md5CompressFrom<11>(addends, midState, state); break;
+        case 12: md5CompressFrom<12>(addends, midState, state); break;
+        case 13: md5CompressFrom<13>(addends, midState, state); break;
+        case 14: md5CompressFrom<14>(addends, midState, state); break;
+        default: md5CompressFrom<15>(addends, midState, state); break;
+    }
+}
+
+inline __attribute__((always_inline)) std::uint32_t md5LoadWord(const unsigned char *bytes)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    std::uint32_t word;
+    std::memcpy(&word, bytes, sizeof(word));
+    return(word);
+#else
+    return(static_cast<std::uint32_t>(bytes[0]) | static_cast<std::uint32_t>(bytes[1]) << 8 |
+           static_cast<std::uint32_t>(bytes[2]) << 16 | static_cast<std::uint32_t>(bytes[3]) << 24);
+#endif
+}
+
+/**
+ * Writes padded single block of message as little endian words. Whole words of message are loaded at once
+ * and each word of block is written once, so block is read back without store forwarding stalls.
+ */
+inline __attribute__((always_inline)) void md5PadBlock(const unsigned char *message, std::size_t length,
+                                                       std::uint32_t *block)
+{
+    // Loop is unrolled, so it is a chain of predictable branches on length without loops over its bytes.
+    #pragma GCC unroll 16
+    for(std::size_t wordIndex = 0; wordIndex < 16; ++wordIndex)
+    {
+        const std::size_t wordStart = 4 * wordIndex;
+        if(wordStart + 4 <= length)
+        {
+            block[wordIndex] = md5LoadWord(message + wordStart);
+        }
+        else if(wordStart <= length)
+        {
+            // The last word holds the rest of message (less than 4 bytes) and padding marker.
+            const std::size_t restLength = length - wordStart;
+            std::uint32_t lastWord = static_cast<std::uint32_t>(0x80) << (8 * restLength);
+            if(restLength > 2)
+            {
+                lastWord |= static_cast<std::uint32_t>(message[wordStart + 2]) << 16;
+            }
+            if(restLength > 1)
+            {
+                lastWord |= static_cast<std::uint32_t>(message[wordStart + 1]) << 8;
+            }
+            if(restLength > 0)
+            {
+                lastWord |= message[wordStart];
+            }
+            block[wordIndex] = lastWord;
+        }
+        else
+        {
+            block[wordIndex] = 0;
+        }
+    }
+    block[14] = static_cast<std::uint32_t>(length * 8);
+}
+
+inline __attribute__((always_inline)) void md5StoreDigest(const std::uint32_t *state, unsigned char *digest)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    std::memcpy(digest, state, md5DigestSize);
+#else
+    for(std::size_t byteIndex = 0; byteIndex < md5DigestSize; ++byteIndex)
+    {
+        digest[byteIndex] = static_cast<unsigned char>(state[byteIndex / 4] >> (8 * (byteIndex % 4)));
+    }
+#endif
+}
+
+/**
+ * Hashes a single message.
+ */
+inline __attribute__((always_inline)) void md5Single(const unsigned char *message, std::size_t length,
+                                                     unsigned char *digest)
+{
+    if(length > md5SingleBlockMaxLength)
+    {
+        gcry_md_hash_buffer(GCRY_MD_MD5, digest, message, length);
+        return;
+    }
+    
+    std::uint32_t block[16];
+    md5PadBlock(message, length, block);
+    std::uint32_t state[4];
+    std::copy(md5InitialState, md5InitialState + 4, state);
+    md5Compress(block, state);
+    md5StoreDigest(state, digest);
+}
+
+/**
+ * Part of compression of groups of messages, which depends only on words of block shared by all lanes (the same
+ * in all messages of group). Candidates enumerated one after another (e.g. by mask, where the last character changes
+ * first) differ only in a few words, so it is computed once for many groups: steps of the first round before the first
+ * word, which differs, and addends of all steps reading shared words.
+ */
+template<class Vector>
+struct Md5SharedPrefix
+{
+    bool isValid = false;
+    // Bit w is set, if word w is shared, sharedWords[w] is its value.
+    std::uint32_t sharedWordsMask = 0;
+    std::uint32_t sharedWords[16];
+    // Compression continues from firstStep with state midState.
+    unsigned int firstStep = 0;
+    Vector midState[4] = {};
+    // Word plus sine of each step, those of steps reading words, which are not shared, are updated for each group.
+    Vector addends[64];
+};
+
+/**
+ * Hashes Lanes messages (each of them fits into single block) simultaneously. Vector holds Lanes 32 bit words.
+ * Messages, which do not fit into single block, are hashed by libgcrypt.
+ * sharedPrefix is kept between groups, it is recomputed, only if shared words of block change.
+ */
+template<std::size_t Lanes, class Vector>
+inline __attribute__((always_inline)) void md5Lanes(const unsigned char *const *messages,
+                                                    const std::size_t *lengths, unsigned char *digests,
+                                                    Md5SharedPrefix<Vector> &sharedPrefix)
+{
+    // Padded blocks of lanes, only words, which differ between lanes, are transposed into vectors.
+    std::uint32_t blocks[Lanes][16];
+    for(std::size_t lane = 0; lane < Lanes; ++lane)
+    {
+        if(lengths[lane] <= md5SingleBlockMaxLength)
+        {
+            md5PadBlock(messages[lane], lengths[lane], blocks[lane]);
+        }
+        else
+        {
+            std::fill(blocks[lane], blocks[lane] + 16, 0);
+        }
+    }
+    
+    std::uint32_t differences[16] = {};
+    for(std::size_t lane = 1; lane < Lanes; ++lane)
+    {
+        for(std::size_t wordIndex = 0; wordIndex < 16; ++wordIndex)
+        {
+            differences[wordIndex] |= blocks[lane][wordIndex] ^ blocks[0][wordIndex];
+        }
+    }
+    std::uint32_t sharedWordsMask = 0;
+    for(std::size_t wordIndex = 0; wordIndex < 16; ++wordIndex)
+    {
+        if(differences[wordIndex] == 0)
+        {
+            sharedWordsMask |= 1u << wordIndex;
+        }
+    }
+    bool isPrefixChanged = !sharedPrefix.isValid || sharedPrefix.sharedWordsMask != sharedWordsMask;
+    for(std::size_t wordIndex = 0; wordIndex < 16 && !isPrefixChanged; ++wordIndex)
+    {
+        isPrefixChanged = (sharedWordsMask >> wordIndex & 1) != 0 &&
+                          sharedPrefix.sharedWords[wordIndex] != blocks[0][wordIndex];
+    }
+    
+    if(isPrefixChanged)
+    {
+        sharedPrefix.isValid = true;
+        sharedPrefix.sharedWordsMask = sharedWordsMask;
+        for(std::size_t wordIndex = 0; wordIndex < 16; ++wordIndex)
+        {
+            sharedPrefix.sharedWords[wordIndex] = blocks[0][wordIndex];
+        }
+        
+        // The first round reads words in order, so its steps before the first word, which is not shared,
+        // are the same for all lanes. At least one step is left for vector compression.
+        sharedPrefix.firstStep = 0;
+        while(sharedPrefix.firstStep < 15 && (sharedWordsMask >> sharedPrefix.firstStep & 1) != 0)
+        {
+            ++sharedPrefix.firstStep;
+        }
+        std::uint32_t a = md5InitialState[0], b = md5InitialState[1], c = md5InitialState[2],
+                      d = md5InitialState[3];
+        for(unsigned int step = 0; step < sharedPrefix.firstStep; ++step)
+        {
+            md5Step(step, a, b, c, d, blocks[0][step] + md5Sines[step]);
+            const std::uint32_t previousD = d;
+            d = c;
+            c = b;
+            b = a;
+            a = previousD;
+        }
+        sharedPrefix.midState[0] = Vector{} + a;
+        sharedPrefix.midState[1] = Vector{} + b;
+        sharedPrefix.midState[2] = Vector{} + c;
+        sharedPrefix.midState[3] = Vector{} + d;
+        
+        for(unsigned int step = 0; step < 64; ++step)
+        {
+            const unsigned int wordIndex = md5WordIndex(step);
+            if((sharedWordsMask >> wordIndex & 1) != 0)
+            {
+                sharedPrefix.addends[step] = Vector{} + (blocks[0][wordIndex] + md5Sines[step]);
+            }
+        }
+    }
+    
+    for(std::size_t wordIndex = 0; wordIndex < 16; ++wordIndex)
+    {
+        if((sharedWordsMask >> wordIndex & 1) == 0)
+        {
+            std::uint32_t laneWords[Lanes];
+            for(std::size_t lane = 0; lane < Lanes; ++lane)
+            {
+                laneWords[lane] = blocks[lane][wordIndex];
+            }
+            Vector word;
+            std::memcpy(&word, laneWords, sizeof(Vector));
+            for(const unsigned int step: md5WordSteps[wordIndex])
+            {
+                sharedPrefix.addends[step] = word + md5Sines[step];
+            }
+        }
+    }
+    
+    Vector state[4];
+    for(std::size_t stateIndex = 0; stateIndex < 4; ++stateIndex)
+    {
+        state[stateIndex] = Vector{} + md5InitialState[stateIndex];
+    }
+    md5CompressFrom(sharedPrefix.firstStep, sharedPrefix.addends, sharedPrefix.midState, state);
+    
+    std::uint32_t result[4][Lanes];
+    std::memcpy(result, state, sizeof(result));
+    for(std::size_t lane = 0; lane < Lanes; ++lane)
+    {
+        unsigned char *digest = digests + lane * md5DigestSize;
+        if(lengths[lane] > md5SingleBlockMaxLength)
+        {
+            gcry_md_hash_buffer(GCRY_MD_MD5, digest, messages[lane], lengths[lane]);
+            continue;
+        }
+        
+        const std::uint32_t laneState[4] = {result[0][lane], result[1][lane], result[2][lane], result[3][lane]};
+        md5StoreDigest(laneState, digest);
+    }
+}
+
+/**
+ * Hashes messages by groups of Lanes with vector kernel and the rest of them one by one.
+ */
+template<std::size_t Lanes, class Vector>
+inline __attribute__((always_inline)) void md5Groups(const unsigned char *const *messages,
+                                                     const std::size_t *lengths, std::size_t count,
+                                                     unsigned char *digests)
+{
+    Md5SharedPrefix<Vector> sharedPrefix;
+    std::size_t messageIndex = 0;
+    for(; messageIndex + Lanes <= count; messageIndex += Lanes)
+    {
+        md5Lanes<Lanes, Vector>(messages + messageIndex, lengths + messageIndex,
+                                digests + messageIndex * md5DigestSize, sharedPrefix);
+    }
+    for(; messageIndex < count; ++messageIndex)
+    {
+        md5Single(messages[messageIndex], lengths[messageIndex], digests + messageIndex * md5DigestSize);
+    }
+}
+
+void md5BatchScalar(const unsigned char *const *messages, const std::size_t *lengths, std::size_t count,
+                    unsigned char *digests)
+{
+    // A single lane shares nothing with the next message, so messages are hashed one by one.
+    for(std::size_t messageIndex = 0; messageIndex < count; ++messageIndex)
+    {
+        md5Single(messages[messageIndex], lengths[messageIndex], digests + messageIndex * md5DigestSize);
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+void md5BatchAVX2(const unsigned char *const *messages, const std::size_t *lengths, std::size_t count,
+                  unsigned char *digests)
+{
+    typedef std::uint32_t Vector __attribute__((vector_size(32)));
+    md5Groups<8, Vector>(messages, lengths, count, digests);
+}
+
+__attribute__((target("avx512f")))
+void md5BatchAVX512(const unsigned char *const *messages, const std::size_t *lengths, std::size_t count,
+                    unsigned char *digests)
+{
+    typedef std::uint32_t Vector __attribute__((vector_size(64)));
+    md5Groups<16, Vector>(messages, lengths, count, digests);
+}
+#endif
+
+}
+
+std::size_t md5BatchLanes(SimdLevel simdLevel)
+{
+    switch(simdLevel)
+    {
+        case SimdLevel::AVX512:
+            return(16);
+        case SimdLevel::AVX2:
+            return(8);
+        default:
+            return(1);
+    }
+}
+
+void md5Batch(const unsigned char *messages, std::size_t stride, const std::size_t *lengths, std::size_t count,
+              unsigned char *digests, SimdLevel simdLevel)
+{
+    // Messages are passed to kernels by pointers, which are prepared for a group of messages at once.
+    const std::size_t groupSize = 64;
+    const unsigned char *groupMessages[groupSize];
+    for(std::size_t groupStart = 0; groupStart < count; groupStart += groupSize)
+    {
+        const std::size_t groupCount = std::min(groupSize, count - groupStart);
+        for(std::size_t messageIndex = 0; messageIndex < groupCount; ++messageIndex)
+        {
+            groupMessages[messageIndex] = messages + (groupStart + messageIndex) * stride;
+        }
+        md5Batch(groupMessages, lengths + groupStart, groupCount, digests + groupStart * md5DigestSize, simdLevel);
+    }
+}
+
+void md5Batch(const unsigned char *const *messages, const std::size_t *lengths, std::size_t count,
+              unsigned char *digests, SimdLevel simdLevel)
+{
+    switch(simdLevel)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        case SimdLevel::AVX512:
+            md5BatchAVX512(messages, lengths, count, digests);
+            break;
+        case SimdLevel::AVX2:
+            md5BatchAVX2(messages, lengths, count, digests);
+            break;
+#endif
+        default:
+            md5BatchScalar(messages, lengths, count, digests);
+            break;
+    }
+}
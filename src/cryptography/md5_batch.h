@@ -0,0 +1,40 @@
+#ifndef MD5_BATCH_H
+#define MD5_BATCH_H
+
+#include <cstddef>
+
+#include "../util/cpu_features.h"
+
+/**
+ * Size of MD5 digest in bytes.
+ */
+constexpr std::size_t md5DigestSize = 16;
+
+/**
+ * Maximal length of message, which fits into a single MD5 block: 64 bytes of block without
+ * one byte of padding marker and 8 bytes of message length.
+ */
+constexpr std::size_t md5SingleBlockMaxLength = 55;
+
+/**
+ * Returns number of messages hashed simultaneously by kernel of given SIMD level.
+ */
+std::size_t md5BatchLanes(SimdLevel simdLevel);
+
+/**
+ * Multi-buffer MD5. Computes MD5 of count messages. Message i starts at messages + i * stride
+ * and has length lengths[i], its digest is written into digests + i * md5DigestSize.
+ * Messages not longer than md5SingleBlockMaxLength are hashed in SIMD lanes of given level (which must be supported
+ * by current CPU), longer ones are passed to libgcrypt. Result is the same as of gcry_md_hash_buffer(GCRY_MD_MD5).
+ */
+void md5Batch(const unsigned char *messages, std::size_t stride, const std::size_t *lengths, std::size_t count,
+              unsigned char *digests, SimdLevel simdLevel = getBestSimdLevel());
+
+/**
+ * The same as previous function, but message i is located anywhere in memory and starts at messages[i],
+ * so messages could be hashed in place without copying them into one buffer.
+ */
+void md5Batch(const unsigned char *const *messages, const std::size_t *lengths, std::size_t count,
+              unsigned char *digests, SimdLevel simdLevel = getBestSimdLevel());
+
+#endif
@@ -0,0 +1,278 @@
+#include "multi_target_check.h"
+
+#include <map>
+#include <algorithm>
+
+#include "md5_batch.h"
+
+namespace
+{
+
+// Number of blocks decrypted at once for each key by bitsliced 3DES, when the whole text is checked.
+const std::size_t bitslicedSegmentBlocks = 64;
+
+const unsigned char *getBlockBeforeLast(const ParsedFile &file)
+{
+    // If ciphertext consists of a single block, the previous block is the initial value from file.
+    return(file.contentSize > tripleDesBlockSize ? file.content.get() + file.contentSize - 2 * tripleDesBlockSize :
+                                                   file.initialValue.get());
+}
+
+}
+
+MultiTargetCheck::MultiTargetCheck(const std::vector<ParsedFile> &files, bool usePaddingPrefilter,
+                                   const PlaintextFilter &plaintextFilter, const CryptoBackends &backends):
+    files(files),
+    targets(),
+    usePaddingPrefilter(usePaddingPrefilter),
+    usePlaintextFilter(!plaintextFilter.isEmpty()),
+    groups(),
+    commonPrefixSizes(),
+    bitslicedTripleDes(),
+    bitslicedTexts(bitslicedTripleDes.getLanes() * bitslicedSegmentBlocks * tripleDesBlockSize),
+    groupSha256Batch(bitslicedTripleDes.getLanes()),
+    targetSha256Batch(bitslicedTripleDes.getLanes())
+{
+    targets.reserve(files.size());
+    for(const ParsedFile &file: files)
+    {
+        targets.emplace_back(file, usePaddingPrefilter, plaintextFilter, backends);
+    }
+
+    if(usePlaintextFilter)
+    {
+        groupByFilteredBlocks();
+    }
+    else if(usePaddingPrefilter)
+    {
+        groupByLastBlocks();
+    }
+    else
+    {
+        groupByCommonPrefix();
+    }
+}
+
+void MultiTargetCheck::groupByFilteredBlocks()
+{
+    // Filter limited to text of target is a part of the key, as texts of different sizes are checked differently.
+    std::map<std::string, std::size_t> groupIndices;
+    for(std::size_t targetIndex = 0; targetIndex < files.size(); ++targetIndex)
+    {
+        const ParsedFile &file = files[targetIndex];
+        const PlaintextFilter &plaintextFilter = targets[targetIndex].getPlaintextFilter();
+        const std::size_t checkedSize = std::min(plaintextFilter.getCheckedSize(), file.contentSize);
+        const std::string key = plaintextFilter.getDescription() + "\n" +
+                                std::string(file.initialValue.get(), file.initialValue.get() + file.initialValueSize) +
+                                std::string(file.content.get(), file.content.get() + checkedSize);
+
+        const auto group = groupIndices.emplace(key, groups.size());
+        if(group.second)
+        {
+            groups.emplace_back();
+            commonPrefixSizes.push_back(0);
+        }
+        groups[group.first->second].push_back(targetIndex);
+    }
+}
+
+void MultiTargetCheck::groupByLastBlocks()
+{
+    std::map<std::string, std::size_t> groupIndices;
+    for(std::size_t targetIndex = 0; targetIndex < files.size(); ++targetIndex)
+    {
+        const ParsedFile &file = files[targetIndex];
+        const unsigned char *previousBlock = getBlockBeforeLast(file);
+        const unsigned char *lastBlock = file.content.get() + file.contentSize - tripleDesBlockSize;
+        const std::string key = std::string(previousBlock, previousBlock + tripleDesBlockSize) +
+                                std::string(lastBlock, lastBlock + tripleDesBlockSize);
+
+        const auto group = groupIndices.emplace(key, groups.size());
+        if(group.second)
+        {
+            groups.emplace_back();
+            commonPrefixSizes.push_back(0);
+        }
+        groups[group.first->second].push_back(targetIndex);
+    }
+}
+
+void MultiTargetCheck::groupByCommonPrefix()
+{
+    // Targets with the same initial value and the first block are decrypted the same way as long as their
+    // ciphertexts are equal. Targets without a whole block can't share anything.
+    std::map<std::string, std::size_t> groupIndices;
+    for(std::size_t targetIndex = 0; targetIndex < files.size(); ++targetIndex)
+    {
+        const ParsedFile &file = files[targetIndex];
+        if(file.contentSize < tripleDesBlockSize)
+        {
+            groups.push_back({targetIndex});
+            commonPrefixSizes.push_back(0);
+            continue;
+        }
+        const std::string key = std::string(file.initialValue.get(), file.initialValue.get() + file.initialValueSize) +
+                                std::string(file.content.get(), file.content.get() + tripleDesBlockSize);
+
+        const auto group = groupIndices.emplace(key, groups.size());
+        if(group.second)
+        {
+            groups.push_back({targetIndex});
+            commonPrefixSizes.push_back(file.contentSize / tripleDesBlockSize * tripleDesBlockSize);
+            continue;
+        }
+        const ParsedFile &firstFile = files[groups[group.first->second].front()];
+        std::size_t &commonPrefixSize = commonPrefixSizes[group.first->second];
+        const std::size_t equalSize = std::mismatch(file.content.get(),
+                                                    file.content.get() + std::min(commonPrefixSize, file.contentSize),
+                                                    firstFile.content.get()).first - file.content.get();
+        commonPrefixSize = equalSize / tripleDesBlockSize * tripleDesBlockSize;
+        groups[group.first->second].push_back(targetIndex);
+    }
+
+    // A single target has nothing to share, so its text is hashed without copying state.
+    for(std::size_t groupIndex = 0; groupIndex < groups.size(); ++groupIndex)
+    {
+        if(groups[groupIndex].size() == 1)
+        {
+            commonPrefixSizes[groupIndex] = 0;
+        }
+    }
+}
+
+std::size_t MultiTargetCheck::getTargetsCount() const
+{
+    return(targets.size());
+}
+
+std::size_t MultiTargetCheck::getGroupsCount() const
+{
+    return(groups.size());
+}
+
+std::size_t MultiTargetCheck::getKeysBatchSize() const
+{
+    return(bitslicedTripleDes.getLanes());
+}
+
+CheckPassword &MultiTargetCheck::getTarget(std::size_t targetIndex)
+{
+    return(targets[targetIndex]);
+}
+
+void MultiTargetCheck::checkKeys(const unsigned char *md5Digests, std::size_t keysCount,
+                                 std::vector<boost::dynamic_bitset<>> &acceptableKeys)
+{
+    acceptableKeys.resize(targets.size());
+    for(boost::dynamic_bitset<> &targetAcceptableKeys: acceptableKeys)
+    {
+        targetAcceptableKeys.resize(keysCount);
+        targetAcceptableKeys.reset();
+    }
+
+    // MD5 digest is exactly EDE2 key: the first DES key followed by the second one.
+    bitslicedTripleDes.setKeys(md5Digests, keysCount);
+
+    for(std::size_t groupIndex = 0; groupIndex < groups.size(); ++groupIndex)
+    {
+        if(usePlaintextFilter)
+        {
+            checkPlaintextGroup(groups[groupIndex], md5Digests, keysCount, acceptableKeys);
+        }
+        else if(usePaddingPrefilter)
+        {
+            checkPaddingGroup(groups[groupIndex], md5Digests, keysCount, acceptableKeys);
+        }
+        else
+        {
+            checkPrefixGroup(groups[groupIndex], commonPrefixSizes[groupIndex], keysCount, acceptableKeys);
+        }
+    }
+}
+
+void MultiTargetCheck::checkPlaintextGroup(const std::vector<std::size_t> &group, const unsigned char *md5Digests,
+                                           std::size_t keysCount, std::vector<boost::dynamic_bitset<>> &acceptableKeys)
+{
+    // Only the first blocks of text are decrypted for all keys, at most one segment of them, the rest of filter
+    // (if any) is checked with the whole text for rare keys, which pass this check.
+    const ParsedFile &file = files[group.front()];
+    const PlaintextFilter &plaintextFilter = targets[group.front()].getPlaintextFilter();
+    const std::size_t segmentSize = bitslicedSegmentBlocks * tripleDesBlockSize;
+    const std::size_t checkedBlocks = std::min({(plaintextFilter.getCheckedSize() + tripleDesBlockSize - 1) /
+                                                tripleDesBlockSize,
+                                                file.contentSize / tripleDesBlockSize, bitslicedSegmentBlocks});
+    bitslicedTripleDes.decrypt(file.initialValue.get(), file.content.get(), checkedBlocks, bitslicedTexts.data(),
+                               segmentSize);
+    for(std::size_t keyIndex = 0; keyIndex < keysCount; ++keyIndex)
+    {
+        if(!plaintextFilter.isPrefixAcceptable(bitslicedTexts.data() + keyIndex * segmentSize,
+                                               checkedBlocks * tripleDesBlockSize))
+        {
+            continue;
+        }
+        for(const std::size_t targetIndex: group)
+        {
+            acceptableKeys[targetIndex][keyIndex] =
+                targets[targetIndex].isKeyAcceptable(md5Digests + keyIndex * md5DigestSize);
+        }
+    }
+}
+
+void MultiTargetCheck::checkPaddingGroup(const std::vector<std::size_t> &group, const unsigned char *md5Digests,
+                                         std::size_t keysCount, std::vector<boost::dynamic_bitset<>> &acceptableKeys)
+{
+    // With padding prefilter only the last block is decrypted for all keys, the keys, which pass it,
+    // are checked one by one. Such keys are rare, so there is no need to decrypt the whole text in bitsliced way.
+    const ParsedFile &file = files[group.front()];
+    bitslicedTripleDes.decrypt(getBlockBeforeLast(file), file.content.get() + file.contentSize - tripleDesBlockSize, 1,
+                               bitslicedTexts.data(), tripleDesBlockSize);
+    for(std::size_t keyIndex = 0; keyIndex < keysCount; ++keyIndex)
+    {
+        if(!CheckPassword::isPaddingValid(bitslicedTexts.data() + keyIndex * tripleDesBlockSize, tripleDesBlockSize))
+        {
+            continue;
+        }
+        for(const std::size_t targetIndex: group)
+        {
+            acceptableKeys[targetIndex][keyIndex] =
+                targets[targetIndex].isKeyAcceptable(md5Digests + keyIndex * md5DigestSize);
+        }
+    }
+}
+
+void MultiTargetCheck::checkPrefixGroup(const std::vector<std::size_t> &group, std::size_t commonPrefixSize,
+                                        std::size_t keysCount, std::vector<boost::dynamic_bitset<>> &acceptableKeys)
+{
+    // Otherwise the whole text is decrypted by segments for all keys, each segment is hashed right away
+    // in SIMD lanes, so memory consumption doesn't depend on size of ciphertext. The common beginning is
+    // processed once, the last target of group continues from its state without copying it.
+    groupSha256Batch.reset(keysCount);
+    decryptAndHash(files[group.front()], 0, commonPrefixSize, groupSha256Batch);
+    for(std::size_t memberIndex = 0; memberIndex < group.size(); ++memberIndex)
+    {
+        const std::size_t targetIndex = group[memberIndex];
+        Sha256Batch &sha256Batch = memberIndex + 1 < group.size() ? targetSha256Batch : groupSha256Batch;
+        if(memberIndex + 1 < group.size())
+        {
+            targetSha256Batch.copyState(groupSha256Batch);
+        }
+        decryptAndHash(files[targetIndex], commonPrefixSize, files[targetIndex].contentSize, sha256Batch);
+        sha256Batch.finish(files[targetIndex].shaCheckSum.get(), acceptableKeys[targetIndex]);
+    }
+}
+
+void MultiTargetCheck::decryptAndHash(const ParsedFile &file, std::size_t first, std::size_t last,
+                                      Sha256Batch &sha256Batch)
+{
+    const std::size_t segmentSize = bitslicedSegmentBlocks * tripleDesBlockSize;
+    const unsigned char *previousBlock = first == 0 ? file.initialValue.get() :
+                                                      file.content.get() + first - tripleDesBlockSize;
+    for(std::size_t segmentStart = first; segmentStart < last; segmentStart += segmentSize)
+    {
+        const std::size_t currentSegmentSize = std::min(segmentSize, last - segmentStart);
+        bitslicedTripleDes.decrypt(previousBlock, file.content.get() + segmentStart,
+                                   currentSegmentSize / tripleDesBlockSize, bitslicedTexts.data(), segmentSize);
+        previousBlock = file.content.get() + segmentStart + currentSegmentSize - tripleDesBlockSize;
+        sha256Batch.update(bitslicedTexts.data(), segmentSize, currentSegmentSize);
+    }
+}
@@ -0,0 +1,94 @@
+#ifndef MULTI_TARGET_CHECK_H
+#define MULTI_TARGET_CHECK_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#include <boost/dynamic_bitset.hpp>
+
+#include "../io/parse_file.h"
+#include "check_password.h"
+#include "des_bitslice.h"
+#include "sha256_batch.h"
+
+/**
+ * Class MultiTargetCheck checks batches of keys against several cipher files (targets) at once.
+ * Keys are set into bitsliced 3DES once per batch, so their schedule is shared by all targets.
+ * Targets are grouped by the part of ciphertext, which is decrypted the same way for them: with plaintext filter
+ * it is the initial value with the first blocks checked by the filter, with padding prefilter it is the last block
+ * with the previous one, otherwise it is the initial value with the common beginning of ciphertexts. Such part
+ * is decrypted once per group and, without prefilter, SHA256 of its plain text is computed once too, each target
+ * continues hashing from its state.
+ * Keys found by bitsliced check are confirmed by CheckPassword of target, which also keeps decrypted text.
+ * Objects of this class are not thread safe.
+ */
+class MultiTargetCheck
+{
+private:
+    const std::vector<ParsedFile> files;
+    std::vector<CheckPassword> targets;
+    const bool usePaddingPrefilter;
+    const bool usePlaintextFilter;
+
+    // Indices of targets in each group and size of the common beginning of their ciphertexts (whole blocks),
+    // which is decrypted and hashed once for the group.
+    std::vector<std::vector<std::size_t>> groups;
+    std::vector<std::size_t> commonPrefixSizes;
+
+    // Decrypted blocks of each key (the last one or a segment of text) and multi-buffer SHA256 of texts
+    // of all keys: state after the common beginning of group and state of the current target.
+    BitslicedTripleDes bitslicedTripleDes;
+    std::vector<unsigned char> bitslicedTexts;
+    Sha256Batch groupSha256Batch, targetSha256Batch;
+
+    void groupByFilteredBlocks();
+    void groupByLastBlocks();
+    void groupByCommonPrefix();
+    void decryptAndHash(const ParsedFile &file, std::size_t first, std::size_t last, Sha256Batch &sha256Batch);
+    void checkPlaintextGroup(const std::vector<std::size_t> &group, const unsigned char *md5Digests,
+                             std::size_t keysCount, std::vector<boost::dynamic_bitset<>> &acceptableKeys);
+    void checkPaddingGroup(const std::vector<std::size_t> &group, const unsigned char *md5Digests,
+                           std::size_t keysCount, std::vector<boost::dynamic_bitset<>> &acceptableKeys);
+    void checkPrefixGroup(const std::vector<std::size_t> &group, std::size_t commonPrefixSize,
+                          std::size_t keysCount, std::vector<boost::dynamic_bitset<>> &acceptableKeys);
+public:
+    /**
+     * Padding prefilter and plaintext filter require ciphertexts of all files to be applicable for them.
+     * Backends are used by CheckPassword of targets, which confirms keys.
+     */
+    explicit MultiTargetCheck(const std::vector<ParsedFile> &files, bool usePaddingPrefilter = false,
+                              const PlaintextFilter &plaintextFilter = PlaintextFilter(),
+                              const CryptoBackends &backends = CryptoBackends());
+
+    MultiTargetCheck(const MultiTargetCheck &) = delete;
+    MultiTargetCheck &operator=(const MultiTargetCheck &) = delete;
+
+    std::size_t getTargetsCount() const;
+
+    /**
+     * Returns number of groups of targets, which share decryption.
+     */
+    std::size_t getGroupsCount() const;
+
+    /**
+     * Returns maximal number of keys, which could be checked by checkKeys at once.
+     */
+    std::size_t getKeysBatchSize() const;
+
+    /**
+     * Checks keysCount (not more than getKeysBatchSize()) MD5 digests of passwords at once against all targets.
+     * Bit i of acceptableKeys[target] is set, if i-th key is acceptable for the target.
+     * It is the batch API of search: a worker fills CandidateBatch (fixed stride slots with array of lengths),
+     * computes MD5 of the whole batch by Md5Engine::hashBatch and checks the digests here with one call.
+     */
+    void checkKeys(const unsigned char *md5Digests, std::size_t keysCount,
+                   std::vector<boost::dynamic_bitset<>> &acceptableKeys);
+
+    /**
+     * Returns CheckPassword of target for checking keys one by one and getting decrypted text.
+     */
+    CheckPassword &getTarget(std::size_t targetIndex);
+};
+
+#endif
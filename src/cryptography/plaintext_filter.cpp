@@ -0,0 +1,133 @@
+#include "plaintext_filter.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+
+int parseHexDigit(char digit)
+{
+    if(digit >= '0' && digit <= '9')
+    {
+        return(digit - '0');
+    }
+    if(digit >= 'a' && digit <= 'f')
+    {
+        return(digit - 'a' + 10);
+    }
+    if(digit >= 'A' && digit <= 'F')
+    {
+        return(digit - 'A' + 10);
+    }
+    return(-1);
+}
+
+bool isPrintable(unsigned char character)
+{
+    return((character >= 0x20 && character < 0x7f) || character == '\t' || character == '\n' || character == '\r');
+}
+
+}
+
+std::string parseKnownPrefix(const std::string &definition)
+{
+    std::string knownPrefix;
+    for(std::size_t position = 0; position < definition.size(); ++position)
+    {
+        if(definition[position] != '\\')
+        {
+            knownPrefix.push_back(definition[position]);
+            continue;
+        }
+
+        if(position + 1 < definition.size() && definition[position + 1] == '\\')
+        {
+            knownPrefix.push_back('\\');
+            ++position;
+            continue;
+        }
+        const int highDigit = position + 3 < definition.size() && definition[position + 1] == 'x' ?
+                              parseHexDigit(definition[position + 2]) : -1;
+        const int lowDigit = highDigit >= 0 ? parseHexDigit(definition[position + 3]) : -1;
+        if(lowDigit < 0)
+        {
+            throw std::invalid_argument("ERROR in parseKnownPrefix: invalid escape sequence at position " +
+                                        std::to_string(position) + " of \"" + definition + "\"");
+        }
+        knownPrefix.push_back(static_cast<char>(highDigit * 16 + lowDigit));
+        position += 3;
+    }
+    return(knownPrefix);
+}
+
+std::string getFormatSignature(const std::string &format)
+{
+    if(format == "pdf")
+    {
+        return("%PDF-");
+    }
+    if(format == "zip")
+    {
+        return(std::string("PK\x03\x04", 4));
+    }
+    if(format == "png")
+    {
+        return(std::string("\x89PNG\r\n\x1a\n", 8));
+    }
+    if(format == "jpeg")
+    {
+        return(std::string("\xff\xd8\xff", 3));
+    }
+    if(format == "gzip")
+    {
+        return(std::string("\x1f\x8b", 2));
+    }
+    if(format == "xml")
+    {
+        return("<?xml");
+    }
+    throw std::invalid_argument("ERROR in getFormatSignature: unknown format \"" + format + "\"");
+}
+
+PlaintextFilter::PlaintextFilter():
+    knownPrefix(), printableSize(0)
+{}
+
+PlaintextFilter::PlaintextFilter(const std::string &knownPrefix, std::size_t printableSize):
+    knownPrefix(knownPrefix), printableSize(printableSize)
+{}
+
+bool PlaintextFilter::isEmpty() const
+{
+    return(getCheckedSize() == 0);
+}
+
+std::size_t PlaintextFilter::getCheckedSize() const
+{
+    return(std::max(knownPrefix.size(), printableSize));
+}
+
+bool PlaintextFilter::isApplicable(std::size_t textSize) const
+{
+    return(knownPrefix.size() <= textSize);
+}
+
+PlaintextFilter PlaintextFilter::limitTo(std::size_t textSize, std::size_t blockSize) const
+{
+    const std::size_t lastBlockStart = textSize > blockSize ? (textSize - 1) / blockSize * blockSize : 0;
+    return(PlaintextFilter(knownPrefix, std::min(printableSize, lastBlockStart)));
+}
+
+bool PlaintextFilter::isPrefixAcceptable(const unsigned char *text, std::size_t size) const
+{
+    const std::size_t comparedSize = std::min(size, knownPrefix.size());
+    return(std::equal(text, text + comparedSize, reinterpret_cast<const unsigned char *>(knownPrefix.data())) &&
+           std::all_of(text, text + std::min(size, printableSize), isPrintable));
+}
+
+std::string PlaintextFilter::getDescription() const
+{
+    // Known prefix could contain any bytes, so it is the last part of description.
+    return("printable " + std::to_string(printableSize) + "\nprefix " + knownPrefix);
+}
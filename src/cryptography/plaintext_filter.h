@@ -0,0 +1,64 @@
+#ifndef PLAINTEXT_FILTER_H
+#define PLAINTEXT_FILTER_H
+
+#include <string>
+#include <cstddef>
+
+/**
+ * Parses known beginning of original text. Characters are taken literally except escape sequences
+ * \xHH (byte with given hex code) and \\ (backslash), e.g. "PK\x03\x04".
+ * Throws std::invalid_argument if escape sequence is malformed.
+ */
+std::string parseKnownPrefix(const std::string &definition);
+
+/**
+ * Returns magic bytes, which files of given format start with: pdf, zip (also docx, jar ...), png, jpeg, gzip, xml.
+ * Throws std::invalid_argument for unknown formats.
+ */
+std::string getFormatSignature(const std::string &format);
+
+/**
+ * Class PlaintextFilter describes what is known about the beginning of original text: its exact bytes
+ * (known prefix or magic bytes of file format) and number of its first bytes, which are printable ASCII
+ * (including tabs and line breaks). Wrong keys are rejected by decrypting only the first blocks of ciphertext,
+ * so their cost doesn't depend on size of file. Default constructed filter accepts any text.
+ */
+class PlaintextFilter
+{
+private:
+    std::string knownPrefix;
+    std::size_t printableSize;
+public:
+    PlaintextFilter();
+    PlaintextFilter(const std::string &knownPrefix, std::size_t printableSize);
+
+    bool isEmpty() const;
+
+    /**
+     * Returns number of the first bytes of text, which are checked by filter.
+     */
+    std::size_t getCheckedSize() const;
+
+    /**
+     * Returns true if known prefix fits into text of given size.
+     */
+    bool isApplicable(std::size_t textSize) const;
+
+    /**
+     * Returns filter for text of given size. Its last block isn't checked for printable characters,
+     * because it could contain padding.
+     */
+    PlaintextFilter limitTo(std::size_t textSize, std::size_t blockSize) const;
+
+    /**
+     * Checks the first size bytes of text, so the whole filter is checked, if size is at least getCheckedSize().
+     */
+    bool isPrefixAcceptable(const unsigned char *text, std::size_t size) const;
+
+    /**
+     * Returns text, which identifies the filter in checkpoint.
+     */
+    std::string getDescription() const;
+};
+
+#endif
@@ -0,0 +1,474 @@
+#include "sha256_batch.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+
+#include "../util/cpu_features.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+
+// Round constants and initial hash value from FIPS 180-4.
+const std::uint32_t sha256Constants[64] =
+{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+const std::uint32_t sha256InitialState[8] =
+{
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+const std::size_t sha256BlockSize = 64;
+
+inline std::uint32_t loadBigEndian(const unsigned char *bytes)
+{
+    return(static_cast<std::uint32_t>(bytes[0]) << 24 | static_cast<std::uint32_t>(bytes[1]) << 16 |
+           static_cast<std::uint32_t>(bytes[2]) << 8 | static_cast<std::uint32_t>(bytes[3]));
+}
+
+// As in md5_batch.cpp, following templates are written for Vector being either std::uint32_t or GCC vector
+// of std::uint32_t and are forced to be inlined into kernels compiled for specific instruction set.
+// Rotations are written in place, so that no function returns a wide vector by value.
+template<class Vector>
+inline __attribute__((always_inline)) void sha256Compress(Vector *words, Vector *state)
+{
+    Vector a = state[0], b = state[1], c = state[2], d = state[3];
+    Vector e = state[4], f = state[5], g = state[6], h = state[7];
+    // Message schedule is kept in a window of 16 words, which are replaced in place.
+    #pragma GCC unroll 64
+    for(unsigned int round = 0; round < 64; ++round)
+    {
+        if(round >= 16)
+        {
+            const Vector &word15 = words[(round - 15) % 16], &word2 = words[(round - 2) % 16];
+            const Vector sigma0 = ((word15 >> 7) | (word15 << 25)) ^ ((word15 >> 18) | (word15 << 14)) ^
+                                  (word15 >> 3);
+            const Vector sigma1 = ((word2 >> 17) | (word2 << 15)) ^ ((word2 >> 19) | (word2 << 13)) ^
+                                  (word2 >> 10);
+            words[round % 16] += sigma0 + words[(round - 7) % 16] + sigma1;
+        }
+
+        const Vector sum1 = ((e >> 6) | (e << 26)) ^ ((e >> 11) | (e << 21)) ^ ((e >> 25) | (e << 7));
+        const Vector choice = g ^ (e & (f ^ g));
+        const Vector temporary1 = h + sum1 + choice + sha256Constants[round] + words[round % 16];
+        const Vector sum0 = ((a >> 2) | (a << 30)) ^ ((a >> 13) | (a << 19)) ^ ((a >> 22) | (a << 10));
+        const Vector majority = (a & b) | (c & (a | b));
+
+        h = g;
+        g = f;
+        f = e;
+        e = d + temporary1;
+        d = c;
+        c = b;
+        b = a;
+        a = temporary1 + sum0 + majority;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+/**
+ * Hashes blocksCount consecutive blocks of Lanes messages simultaneously. Vector holds Lanes 32 bit words.
+ * Blocks of message i start at blocks + i * stride, its state is 8 words at states + i * 8.
+ */
+template<std::size_t Lanes, class Vector>
+inline __attribute__((always_inline)) void sha256Lanes(std::uint32_t *states, const unsigned char *blocks,
+                                                       std::size_t stride, std::size_t blocksCount)
+{
+    // Transposed states and blocks: words[w][lane] is w-th big endian word of block of lane.
+    std::uint32_t transposed[16][Lanes];
+    Vector state[8], block[16];
+    for(std::size_t stateIndex = 0; stateIndex < 8; ++stateIndex)
+    {
+        for(std::size_t lane = 0; lane < Lanes; ++lane)
+        {
+            transposed[stateIndex][lane] = states[lane * 8 + stateIndex];
+        }
+        std::memcpy(&state[stateIndex], transposed[stateIndex], sizeof(Vector));
+    }
+
+    for(std::size_t blockIndex = 0; blockIndex < blocksCount; ++blockIndex)
+    {
+        for(std::size_t lane = 0; lane < Lanes; ++lane)
+        {
+            const unsigned char *laneBlock = blocks + lane * stride + blockIndex * sha256BlockSize;
+            for(std::size_t wordIndex = 0; wordIndex < 16; ++wordIndex)
+            {
+                transposed[wordIndex][lane] = loadBigEndian(laneBlock + wordIndex * 4);
+            }
+        }
+        for(std::size_t wordIndex = 0; wordIndex < 16; ++wordIndex)
+        {
+            std::memcpy(&block[wordIndex], transposed[wordIndex], sizeof(Vector));
+        }
+        sha256Compress(block, state);
+    }
+
+    for(std::size_t stateIndex = 0; stateIndex < 8; ++stateIndex)
+    {
+        std::memcpy(transposed[stateIndex], &state[stateIndex], sizeof(Vector));
+        for(std::size_t lane = 0; lane < Lanes; ++lane)
+        {
+            states[lane * 8 + stateIndex] = transposed[stateIndex][lane];
+        }
+    }
+}
+
+/**
+ * Hashes messages by groups of Lanes with vector kernel and returns the number of hashed messages.
+ * The rest of them (fewer than Lanes) is left to the caller.
+ */
+template<std::size_t Lanes, class Vector>
+inline __attribute__((always_inline)) std::size_t sha256Groups(std::uint32_t *states, const unsigned char *blocks,
+                                                               std::size_t stride, std::size_t blocksCount,
+                                                               std::size_t count)
+{
+    std::size_t messageIndex = 0;
+    for(; messageIndex + Lanes <= count; messageIndex += Lanes)
+    {
+        sha256Lanes<Lanes, Vector>(states + messageIndex * 8, blocks + messageIndex * stride, stride, blocksCount);
+    }
+    return(messageIndex);
+}
+
+void sha256CompressScalar(std::uint32_t *states, const unsigned char *blocks, std::size_t stride,
+                          std::size_t blocksCount, std::size_t count)
+{
+    sha256Groups<1, std::uint32_t>(states, blocks, stride, blocksCount, count);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/**
+ * SHA extensions keep state in two registers in order ABEF and CDGH, each instruction sha256rnds2
+ * performs two rounds and instructions sha256msg1/sha256msg2 compute four words of message schedule.
+ */
+__attribute__((target("sha,sse4.1")))
+void sha256CompressShaNi(std::uint32_t *states, const unsigned char *blocks, std::size_t stride,
+                         std::size_t blocksCount, std::size_t count)
+{
+    const __m128i byteSwapMask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    for(std::size_t messageIndex = 0; messageIndex < count; ++messageIndex)
+    {
+        std::uint32_t *state = states + messageIndex * 8;
+        const __m128i dcba = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(state)), 0xb1);
+        const __m128i efgh = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(state + 4)), 0x1b);
+        __m128i abef = _mm_alignr_epi8(dcba, efgh, 8);
+        __m128i cdgh = _mm_blend_epi16(efgh, dcba, 0xf0);
+
+        for(std::size_t blockIndex = 0; blockIndex < blocksCount; ++blockIndex)
+        {
+            const unsigned char *block = blocks + messageIndex * stride + blockIndex * sha256BlockSize;
+            const __m128i savedAbef = abef, savedCdgh = cdgh;
+            __m128i words[4];
+            #pragma GCC unroll 16
+            for(unsigned int quarter = 0; quarter < 16; ++quarter)
+            {
+                __m128i &current = words[quarter % 4];
+                if(quarter < 4)
+                {
+                    current = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(block + quarter * 16)),
+                                               byteSwapMask);
+                }
+                else
+                {
+                    // Words w[i..i+3] from w[i-16..i-13] (current), w[i-15..i-12], w[i-7..i-4] and w[i-4..i-1].
+                    const __m128i &next = words[(quarter + 1) % 4];
+                    const __m128i &previous2 = words[(quarter + 2) % 4], &previous1 = words[(quarter + 3) % 4];
+                    current = _mm_add_epi32(_mm_sha256msg1_epu32(current, next),
+                                            _mm_alignr_epi8(previous1, previous2, 4));
+                    current = _mm_sha256msg2_epu32(current, previous1);
+                }
+                __m128i message = _mm_add_epi32(current,
+                    _mm_loadu_si128(reinterpret_cast<const __m128i *>(sha256Constants + quarter * 4)));
+                cdgh = _mm_sha256rnds2_epu32(cdgh, abef, message);
+                message = _mm_shuffle_epi32(message, 0x0e);
+                abef = _mm_sha256rnds2_epu32(abef, cdgh, message);
+            }
+            abef = _mm_add_epi32(abef, savedAbef);
+            cdgh = _mm_add_epi32(cdgh, savedCdgh);
+        }
+
+        const __m128i feba = _mm_shuffle_epi32(abef, 0x1b);
+        const __m128i dchg = _mm_shuffle_epi32(cdgh, 0xb1);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(state), _mm_blend_epi16(feba, dchg, 0xf0));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(state + 4), _mm_alignr_epi8(dchg, feba, 8));
+    }
+}
+
+/**
+ * Hashes messages left after the last full group of vector lanes one by one, with SHA extensions if CPU
+ * supports them, because a partially filled vector would be no faster than a single lane.
+ */
+void sha256CompressRemainder(std::uint32_t *states, const unsigned char *blocks, std::size_t stride,
+                             std::size_t blocksCount, std::size_t count)
+{
+    if(getCpuFeatures().sha)
+    {
+        sha256CompressShaNi(states, blocks, stride, blocksCount, count);
+    }
+    else
+    {
+        sha256CompressScalar(states, blocks, stride, blocksCount, count);
+    }
+}
+
+__attribute__((target("avx2")))
+void sha256CompressAVX2(std::uint32_t *states, const unsigned char *blocks, std::size_t stride,
+                        std::size_t blocksCount, std::size_t count)
+{
+    typedef std::uint32_t Vector __attribute__((vector_size(32)));
+    const std::size_t groupedCount = sha256Groups<8, Vector>(states, blocks, stride, blocksCount, count);
+    sha256CompressRemainder(states + groupedCount * 8, blocks + groupedCount * stride, stride, blocksCount,
+                            count - groupedCount);
+}
+
+__attribute__((target("avx512f")))
+void sha256CompressAVX512(std::uint32_t *states, const unsigned char *blocks, std::size_t stride,
+                          std::size_t blocksCount, std::size_t count)
+{
+    typedef std::uint32_t Vector __attribute__((vector_size(64)));
+    const std::size_t groupedCount = sha256Groups<16, Vector>(states, blocks, stride, blocksCount, count);
+    sha256CompressRemainder(states + groupedCount * 8, blocks + groupedCount * stride, stride, blocksCount,
+                            count - groupedCount);
+}
+#endif
+
+}
+
+Sha256Kernel getBestSha256Kernel()
+{
+    // Full groups of sixteen lanes of AVX-512 are faster than SHA extensions, which hash one message at a time,
+    // and messages left after the last group are hashed with SHA extensions anyway. Eight lanes of AVX2
+    // are slower than SHA extensions even for full groups.
+    const CpuFeatures &features = getCpuFeatures();
+    if(features.avx512)
+    {
+        return(Sha256Kernel::AVX512);
+    }
+    if(features.sha)
+    {
+        return(Sha256Kernel::ShaNi);
+    }
+    if(features.avx2)
+    {
+        return(Sha256Kernel::AVX2);
+    }
+    return(Sha256Kernel::Scalar);
+}
+
+bool isSha256KernelSupported(Sha256Kernel kernel)
+{
+    switch(kernel)
+    {
+        case Sha256Kernel::AVX512:
+            return(getCpuFeatures().avx512);
+        case Sha256Kernel::AVX2:
+            return(getCpuFeatures().avx2);
+        case Sha256Kernel::ShaNi:
+            return(getCpuFeatures().sha);
+        default:
+            return(true);
+    }
+}
+
+std::string toString(Sha256Kernel kernel)
+{
+    switch(kernel)
+    {
+        case Sha256Kernel::AVX512:
+            return("avx512");
+        case Sha256Kernel::AVX2:
+            return("avx2");
+        case Sha256Kernel::ShaNi:
+            return("sha-ni");
+        default:
+            return("scalar");
+    }
+}
+
+std::ostream &operator<<(std::ostream &stream, Sha256Kernel kernel)
+{
+    return(stream << toString(kernel));
+}
+
+Sha256Batch::Sha256Batch(std::size_t capacity, Sha256Kernel kernel):
+    kernel(kernel), capacity(capacity), count(0),
+    states(capacity * 8), pendingBlocks(capacity * 2 * sha256BlockSize), pendingSize(0), messageSize(0),
+    digests(capacity * sha256DigestSize)
+{
+    if(!isSha256KernelSupported(kernel))
+    {
+        throw std::invalid_argument("ERROR in Sha256Batch: kernel " + toString(kernel) +
+                                    " is not supported by CPU.");
+    }
+}
+
+std::size_t Sha256Batch::getCapacity() const
+{
+    return(capacity);
+}
+
+void Sha256Batch::reset(std::size_t count)
+{
+    if(count > capacity)
+    {
+        throw std::invalid_argument("ERROR in Sha256Batch: number of messages exceeds capacity.");
+    }
+    this->count = count;
+    for(std::size_t messageIndex = 0; messageIndex < count; ++messageIndex)
+    {
+        std::copy_n(sha256InitialState, 8, states.begin() + messageIndex * 8);
+    }
+    pendingSize = 0;
+    messageSize = 0;
+}
+
+void Sha256Batch::copyState(const Sha256Batch &other)
+{
+    if(other.count > capacity)
+    {
+        throw std::invalid_argument("ERROR in Sha256Batch: number of messages exceeds capacity.");
+    }
+    count = other.count;
+    std::copy_n(other.states.begin(), count * 8, states.begin());
+    for(std::size_t messageIndex = 0; messageIndex < count && other.pendingSize > 0; ++messageIndex)
+    {
+        std::copy_n(other.pendingBlocks.begin() + messageIndex * sha256BlockSize, other.pendingSize,
+                    pendingBlocks.begin() + messageIndex * sha256BlockSize);
+    }
+    pendingSize = other.pendingSize;
+    messageSize = other.messageSize;
+}
+
+void Sha256Batch::compress(const unsigned char *blocks, std::size_t stride, std::size_t blocksCount)
+{
+    switch(kernel)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        case Sha256Kernel::AVX512:
+            sha256CompressAVX512(states.data(), blocks, stride, blocksCount, count);
+            break;
+        case Sha256Kernel::AVX2:
+            sha256CompressAVX2(states.data(), blocks, stride, blocksCount, count);
+            break;
+        case Sha256Kernel::ShaNi:
+            sha256CompressShaNi(states.data(), blocks, stride, blocksCount, count);
+            break;
+#endif
+        default:
+            sha256CompressScalar(states.data(), blocks, stride, blocksCount, count);
+            break;
+    }
+}
+
+void Sha256Batch::update(const unsigned char *parts, std::size_t stride, std::size_t size)
+{
+    messageSize += size;
+    std::size_t offset = 0;
+
+    // At first incomplete block from previous calls is completed, then whole blocks are hashed
+    // directly from input and the rest is buffered.
+    if(pendingSize > 0)
+    {
+        const std::size_t appendedSize = std::min(size, sha256BlockSize - pendingSize);
+        for(std::size_t messageIndex = 0; messageIndex < count; ++messageIndex)
+        {
+            std::copy_n(parts + messageIndex * stride, appendedSize,
+                        pendingBlocks.begin() + messageIndex * sha256BlockSize + pendingSize);
+        }
+        pendingSize += appendedSize;
+        offset = appendedSize;
+        if(pendingSize < sha256BlockSize)
+        {
+            return;
+        }
+        compress(pendingBlocks.data(), sha256BlockSize, 1);
+        pendingSize = 0;
+    }
+
+    const std::size_t blocksCount = (size - offset) / sha256BlockSize;
+    if(blocksCount > 0)
+    {
+        compress(parts + offset, stride, blocksCount);
+        offset += blocksCount * sha256BlockSize;
+    }
+
+    pendingSize = size - offset;
+    for(std::size_t messageIndex = 0; messageIndex < count && pendingSize > 0; ++messageIndex)
+    {
+        std::copy_n(parts + messageIndex * stride + offset, pendingSize,
+                    pendingBlocks.begin() + messageIndex * sha256BlockSize);
+    }
+}
+
+const unsigned char *Sha256Batch::finish()
+{
+    // Padding is the same for all messages: marker byte, zeros and 64 bit big endian length in bits,
+    // which takes one or two blocks. Pending buffer is reused with stride of two blocks.
+    const std::size_t paddedSize = pendingSize + 9 <= sha256BlockSize ? sha256BlockSize : 2 * sha256BlockSize;
+    const std::uint64_t messageBits = messageSize * 8;
+    for(std::size_t messageIndex = count; messageIndex > 0; --messageIndex)
+    {
+        const auto pending = pendingBlocks.begin() + (messageIndex - 1) * sha256BlockSize;
+        const auto padded = pendingBlocks.begin() + (messageIndex - 1) * 2 * sha256BlockSize;
+        // Messages are moved to their new positions from the last one, so that they are not overwritten.
+        std::copy_backward(pending, pending + pendingSize, padded + pendingSize);
+        padded[pendingSize] = 0x80;
+        std::fill(padded + pendingSize + 1, padded + paddedSize - 8, 0);
+        for(std::size_t byteIndex = 0; byteIndex < 8; ++byteIndex)
+        {
+            padded[paddedSize - 1 - byteIndex] = static_cast<unsigned char>(messageBits >> (8 * byteIndex));
+        }
+    }
+    compress(pendingBlocks.data(), 2 * sha256BlockSize, paddedSize / sha256BlockSize);
+
+    for(std::size_t messageIndex = 0; messageIndex < count; ++messageIndex)
+    {
+        unsigned char *digest = digests.data() + messageIndex * sha256DigestSize;
+        for(std::size_t byteIndex = 0; byteIndex < sha256DigestSize; ++byteIndex)
+        {
+            digest[byteIndex] = static_cast<unsigned char>(states[messageIndex * 8 + byteIndex / 4] >>
+                                                           (24 - 8 * (byteIndex % 4)));
+        }
+    }
+    pendingSize = 0;
+    return(digests.data());
+}
+
+void Sha256Batch::finish(const unsigned char *expectedDigest, boost::dynamic_bitset<> &matches)
+{
+    const unsigned char *digest = finish();
+    matches.resize(count);
+    for(std::size_t messageIndex = 0; messageIndex < count; ++messageIndex, digest += sha256DigestSize)
+    {
+        matches[messageIndex] = std::equal(digest, digest + sha256DigestSize, expectedDigest);
+    }
+}
+
+void sha256Batch(const unsigned char *messages, std::size_t stride, std::size_t size, std::size_t count,
+                 const unsigned char *expectedDigest, boost::dynamic_bitset<> &matches, Sha256Kernel kernel)
+{
+    Sha256Batch batch(count, kernel);
+    batch.reset(count);
+    batch.update(messages, stride, size);
+    batch.finish(expectedDigest, matches);
+}
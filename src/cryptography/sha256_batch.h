@@ -0,0 +1,109 @@
+#ifndef SHA256_BATCH_H
+#define SHA256_BATCH_H
+
+#include <boost/dynamic_bitset.hpp>
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * Size of SHA256 digest in bytes.
+ */
+constexpr std::size_t sha256DigestSize = 32;
+
+/**
+ * Kernels of multi-buffer SHA256. ShaNi kernel hashes messages one by one with SHA extensions of x86,
+ * AVX2 and AVX512 kernels hash 8 and 16 messages simultaneously in SIMD lanes. Messages left after the last
+ * full group of lanes are hashed one by one, with SHA extensions if CPU supports them.
+ */
+enum class Sha256Kernel
+{
+    Scalar,
+    ShaNi,
+    AVX2,
+    AVX512
+};
+
+/**
+ * Returns the fastest kernel supported by current CPU.
+ */
+Sha256Kernel getBestSha256Kernel();
+
+/**
+ * Returns true if given kernel can be executed on current CPU.
+ */
+bool isSha256KernelSupported(Sha256Kernel kernel);
+
+std::string toString(Sha256Kernel kernel);
+std::ostream &operator<<(std::ostream &stream, Sha256Kernel kernel);
+
+/**
+ * class Sha256Batch computes SHA256 of several messages of the same length at once. Messages are fed
+ * by parts like with gcry_md_write, but all messages receive a part of the same size in one call,
+ * so partial blocks are buffered uniformly and whole blocks are hashed in SIMD lanes right from input.
+ */
+class Sha256Batch
+{
+private:
+    const Sha256Kernel kernel;
+    const std::size_t capacity;
+    std::size_t count;
+
+    // Intermediate hash values of each message (8 words per message), buffered data of incomplete block
+    // of each message (the same number of bytes for all messages) and the length of messages fed so far.
+    std::vector<std::uint32_t> states;
+    std::vector<unsigned char> pendingBlocks;
+    std::size_t pendingSize;
+    std::uint64_t messageSize;
+    std::vector<unsigned char> digests;
+
+    void compress(const unsigned char *blocks, std::size_t stride, std::size_t blocksCount);
+public:
+    /**
+     * Creates a batch of at most capacity messages. Kernel must be supported by current CPU.
+     */
+    explicit Sha256Batch(std::size_t capacity, Sha256Kernel kernel = getBestSha256Kernel());
+
+    std::size_t getCapacity() const;
+
+    /**
+     * Starts hashing of count (not more than capacity) new messages.
+     */
+    void reset(std::size_t count);
+
+    /**
+     * Appends size bytes to each message: data of message i starts at parts + i * stride.
+     */
+    void update(const unsigned char *parts, std::size_t stride, std::size_t size);
+
+    /**
+     * Replaces state of hashing by state of other batch, so that messages with common beginning could be
+     * hashed by feeding the beginning once and continuing from its state for each message.
+     */
+    void copyState(const Sha256Batch &other);
+
+    /**
+     * Finishes hashing and returns digests of all messages, digest i starts at i * sha256DigestSize.
+     * Buffer is valid until the next call of finish.
+     */
+    const unsigned char *finish();
+
+    /**
+     * Finishes hashing and compares digests with expectedDigest: bit i of matches is set if digest
+     * of message i is equal to it.
+     */
+    void finish(const unsigned char *expectedDigest, boost::dynamic_bitset<> &matches);
+};
+
+/**
+ * Computes SHA256 of count messages of the same size at once (message i starts at messages + i * stride)
+ * and compares them with expectedDigest. Bit i of matches is set if digest of message i is equal to it.
+ */
+void sha256Batch(const unsigned char *messages, std::size_t stride, std::size_t size, std::size_t count,
+                 const unsigned char *expectedDigest, boost::dynamic_bitset<> &matches,
+                 Sha256Kernel kernel = getBestSha256Kernel());
+
+#endif
@@ -0,0 +1,45 @@
+#include "daemon_client.h"
+
+#include <boost/filesystem.hpp>
+
+#include <stdexcept>
+
+#include "daemon_protocol.h"
+
+int runDaemonJob(const std::string &socketName, int priority, const std::vector<std::string> &arguments,
+                 std::ostream &output, std::ostream &errors)
+{
+    LineConnection connection(connectUnixSocket(socketName));
+    bool isSent = connection.writeLine("directory " + escapeLine(boost::filesystem::current_path().string())) &&
+                  connection.writeLine("priority " + std::to_string(priority));
+    for(const std::string &argument: arguments)
+    {
+        isSent = isSent && connection.writeLine("argument " + escapeLine(argument));
+    }
+    if(!isSent || !connection.writeLine("run"))
+    {
+        throw std::runtime_error("ERROR in runDaemonJob: failed sending job to daemon");
+    }
+
+    std::string line;
+    while(connection.readLine(line))
+    {
+        const std::size_t separatorPosition = line.find(' ');
+        const std::string kind = line.substr(0, separatorPosition);
+        const std::string text = separatorPosition != std::string::npos ?
+                                 unescapeLine(line.substr(separatorPosition + 1)) : "";
+        if(kind == "output")
+        {
+            output << text << std::endl;
+        }
+        else if(kind == "errors")
+        {
+            errors << text << std::endl;
+        }
+        else if(kind == "exit")
+        {
+            return(std::stoi(text));
+        }
+    }
+    throw std::runtime_error("ERROR in runDaemonJob: daemon has closed connection before the end of the job");
+}
@@ -0,0 +1,16 @@
+#ifndef DAEMON_CLIENT_H
+#define DAEMON_CLIENT_H
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+/**
+ * Sends job with given command line arguments to daemon on Unix socket and prints streams of the job into output
+ * and errors as they come, so the job looks like a search run by this process. Returns exit code of the job.
+ * Throws std::runtime_error, if there is no daemon or it has closed connection before the end of the job.
+ */
+int runDaemonJob(const std::string &socketName, int priority, const std::vector<std::string> &arguments,
+                 std::ostream &output, std::ostream &errors);
+
+#endif
@@ -0,0 +1,201 @@
+#include "daemon_protocol.h"
+
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+
+sockaddr_un getSocketAddress(const std::string &socketName, const std::string &functionName)
+{
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if(socketName.empty() || socketName.size() >= sizeof(address.sun_path))
+    {
+        throw std::runtime_error("ERROR in " + functionName + ": name of socket " + socketName +
+                                 " is empty or too long");
+    }
+    std::memcpy(address.sun_path, socketName.c_str(), socketName.size());
+    return(address);
+}
+
+}
+
+std::string escapeLine(const std::string &text)
+{
+    std::string line;
+    line.reserve(text.size());
+    for(const char character: text)
+    {
+        if(character == '\\')
+        {
+            line += "\\\\";
+        }
+        else if(character == '\n')
+        {
+            line += "\\n";
+        }
+        else
+        {
+            line += character;
+        }
+    }
+    return(line);
+}
+
+std::string unescapeLine(const std::string &line)
+{
+    std::string text;
+    text.reserve(line.size());
+    for(std::size_t position = 0; position < line.size(); ++position)
+    {
+        if(line[position] == '\\' && position + 1 < line.size())
+        {
+            ++position;
+            text += line[position] == 'n' ? '\n' : line[position];
+        }
+        else
+        {
+            text += line[position];
+        }
+    }
+    return(text);
+}
+
+int listenUnixSocket(const std::string &socketName)
+{
+    const sockaddr_un address = getSocketAddress(socketName, "listenUnixSocket");
+    const int listeningSocket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if(listeningSocket < 0)
+    {
+        throw std::runtime_error(std::string("ERROR in listenUnixSocket: ") + std::strerror(errno));
+    }
+
+    // Socket of running daemon accepts connections, so only socket of stopped one is removed.
+    // Other files are never removed, binding just fails on them.
+    struct stat fileStatus;
+    const int probeSocket = ::stat(socketName.c_str(), &fileStatus) == 0 && S_ISSOCK(fileStatus.st_mode) ?
+                            ::socket(AF_UNIX, SOCK_STREAM, 0) : -1;
+    if(probeSocket >= 0)
+    {
+        const bool isDaemonRunning = ::connect(probeSocket, reinterpret_cast<const sockaddr *>(&address),
+                                               sizeof(address)) == 0;
+        ::close(probeSocket);
+        if(isDaemonRunning)
+        {
+            ::close(listeningSocket);
+            throw std::runtime_error("ERROR in listenUnixSocket: another daemon is running on " + socketName);
+        }
+        ::unlink(socketName.c_str());
+    }
+
+    // Jobs run with permissions of the daemon, so socket is created accessible only by its user (connecting
+    // requires write permission). Umask is the only way to set mode of socket file before anybody could connect.
+    const mode_t previousUmask = ::umask(S_IRWXG | S_IRWXO | S_IXUSR);
+    const bool isBound = ::bind(listeningSocket, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == 0;
+    ::umask(previousUmask);
+    if(!isBound || ::listen(listeningSocket, SOMAXCONN) != 0)
+    {
+        const std::string reason = std::strerror(errno);
+        ::close(listeningSocket);
+        throw std::runtime_error("ERROR in listenUnixSocket: " + reason);
+    }
+    return(listeningSocket);
+}
+
+int connectUnixSocket(const std::string &socketName)
+{
+    const sockaddr_un address = getSocketAddress(socketName, "connectUnixSocket");
+    const int connectedSocket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if(connectedSocket < 0)
+    {
+        throw std::runtime_error(std::string("ERROR in connectUnixSocket: ") + std::strerror(errno));
+    }
+    if(::connect(connectedSocket, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0)
+    {
+        const std::string reason = std::strerror(errno);
+        ::close(connectedSocket);
+        throw std::runtime_error("ERROR in connectUnixSocket: " + reason);
+    }
+    return(connectedSocket);
+}
+
+bool isPeerOfSameUser(int connectedSocket)
+{
+    ucred peerCredentials;
+    socklen_t credentialsSize = sizeof(peerCredentials);
+    return(::getsockopt(connectedSocket, SOL_SOCKET, SO_PEERCRED, &peerCredentials, &credentialsSize) == 0 &&
+           peerCredentials.uid == ::geteuid());
+}
+
+LineConnection::LineConnection(int socket):
+    socket(socket)
+{}
+
+LineConnection::~LineConnection()
+{
+    ::close(socket);
+}
+
+bool LineConnection::readLine(std::string &line)
+{
+    std::size_t newlinePosition;
+    while((newlinePosition = readBuffer.find('\n')) == std::string::npos)
+    {
+        char buffer[4096];
+        const ssize_t readSize = ::recv(socket, buffer, sizeof(buffer), 0);
+        if(readSize < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(readSize <= 0)
+        {
+            return(false);
+        }
+        readBuffer.append(buffer, readSize);
+    }
+    line = readBuffer.substr(0, newlinePosition);
+    readBuffer.erase(0, newlinePosition + 1);
+    return(true);
+}
+
+bool LineConnection::writeLine(const std::string &line)
+{
+    const std::string data = line + '\n';
+    std::lock_guard<std::mutex> lock(writeMutex);
+    for(std::size_t sentSize = 0; sentSize < data.size();)
+    {
+        // Closed connection fails the write instead of killing the process by SIGPIPE.
+        const ssize_t size = ::send(socket, data.data() + sentSize, data.size() - sentSize, MSG_NOSIGNAL);
+        if(size < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(size <= 0)
+        {
+            return(false);
+        }
+        sentSize += size;
+    }
+    return(true);
+}
+
+bool LineConnection::waitForClose(int timeoutMilliseconds)
+{
+    // POLLRDHUP is reported, when the peer has closed connection (or shut down its writing), while data sent
+    // by the peer doesn't wake polling up, so it is never read here.
+    pollfd connectionPoll = {socket, POLLRDHUP, 0};
+    if(::poll(&connectionPoll, 1, timeoutMilliseconds) <= 0)
+    {
+        return(false);
+    }
+    return((connectionPoll.revents & (POLLRDHUP | POLLHUP | POLLERR | POLLNVAL)) != 0);
+}
@@ -0,0 +1,75 @@
+#ifndef DAEMON_PROTOCOL_H
+#define DAEMON_PROTOCOL_H
+
+#include <string>
+#include <mutex>
+
+/*
+ * Protocol of daemon is line based. Client sends a job as lines "directory PATH" (its working directory),
+ * "priority P", "argument ARGUMENT" for each command line argument and "run". Daemon answers with lines
+ * "output LINE" and "errors LINE" of standard output and standard error of the job, while it is running,
+ * and with the final line "exit CODE". Backslashes and newlines inside lines are escaped.
+ */
+
+/**
+ * Replaces backslashes with "\\" and newlines with "\n", so the text fits into a single line of protocol.
+ */
+std::string escapeLine(const std::string &text);
+
+/**
+ * Restores text escaped by escapeLine.
+ */
+std::string unescapeLine(const std::string &line);
+
+/**
+ * Creates Unix socket listening on given name, which only the user of the process can connect to (mode 0600).
+ * Stale socket of stopped daemon is replaced. Throws std::runtime_error, if the socket can't be created.
+ */
+int listenUnixSocket(const std::string &socketName);
+
+/**
+ * Returns true, if peer of connected Unix socket runs as the same (effective) user as the process.
+ */
+bool isPeerOfSameUser(int connectedSocket);
+
+/**
+ * Connects to Unix socket of given name. Throws std::runtime_error, if there is no daemon on it.
+ */
+int connectUnixSocket(const std::string &socketName);
+
+/**
+ * class LineConnection reads and writes lines of protocol on connected socket, which it owns.
+ * Lines could be written by several threads at once, each of them is sent as a whole.
+ */
+class LineConnection
+{
+private:
+    const int socket;
+    std::string readBuffer;
+    std::mutex writeMutex;
+
+public:
+    explicit LineConnection(int socket);
+    ~LineConnection();
+
+    LineConnection(const LineConnection &) = delete;
+    LineConnection &operator=(const LineConnection &) = delete;
+
+    /**
+     * Reads the next line without newline. Returns false, if connection is closed or broken.
+     */
+    bool readLine(std::string &line);
+
+    /**
+     * Sends line followed by newline. Returns false, if connection is closed or broken.
+     */
+    bool writeLine(const std::string &line);
+
+    /**
+     * Waits up to timeout for the peer to close its end of connection. Returns true, if connection is closed
+     * or broken. Data sent by the peer is left unread.
+     */
+    bool waitForClose(int timeoutMilliseconds);
+};
+
+#endif
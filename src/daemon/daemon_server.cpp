@@ -0,0 +1,339 @@
+#include "daemon_server.h"
+
+#include <sstream>
+#include <streambuf>
+#include <thread>
+#include <list>
+#include <utility>
+#include <exception>
+#include <stdexcept>
+#include <cstdlib>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "daemon_protocol.h"
+#include "../search/work_stealing_scheduler.h"
+
+namespace
+{
+
+// Stream buffer, which sends each line written into it as a line of protocol of given kind. If connection is broken,
+// the job is interrupted, as nobody is waiting for its results. Lines are written by output thread of the search,
+// progress thread and workers, so writing is serialized.
+class ConnectionStreamBuffer: public std::streambuf
+{
+private:
+    LineConnection &connection;
+    const std::string kind;
+    std::atomic<bool> &interrupted;
+    std::string line;
+    std::mutex mutex;
+
+    void sendLine()
+    {
+        if(!connection.writeLine(kind + " " + escapeLine(line)))
+        {
+            interrupted = true;
+        }
+        line.clear();
+    }
+
+protected:
+    int_type overflow(int_type character) override
+    {
+        if(traits_type::eq_int_type(character, traits_type::eof()))
+        {
+            return(traits_type::not_eof(character));
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        if(traits_type::to_char_type(character) == '\n')
+        {
+            sendLine();
+        }
+        else
+        {
+            line += traits_type::to_char_type(character);
+        }
+        return(character);
+    }
+
+    std::streamsize xsputn(const char *data, std::streamsize size) override
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for(std::streamsize position = 0; position < size; ++position)
+        {
+            if(data[position] == '\n')
+            {
+                sendLine();
+            }
+            else
+            {
+                line += data[position];
+            }
+        }
+        return(size);
+    }
+
+    // Flushed part of line is sent at once, e.g. the last line without newline.
+    int sync() override
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(!line.empty())
+        {
+            sendLine();
+        }
+        return(0);
+    }
+
+public:
+    ConnectionStreamBuffer(LineConnection &connection, const std::string &kind, std::atomic<bool> &interrupted):
+        connection(connection), kind(kind), interrupted(interrupted)
+    {}
+};
+
+// Sends text collected in stream as lines of protocol of given kind.
+void sendText(LineConnection &connection, const std::string &kind, const std::string &text)
+{
+    std::istringstream textInput(text);
+    std::string line;
+    while(std::getline(textInput, line))
+    {
+        connection.writeLine(kind + " " + escapeLine(line));
+    }
+}
+
+// Sends message to the client and finishes its job as failed.
+void rejectJob(LineConnection &connection, const std::string &message)
+{
+    connection.writeLine("errors " + escapeLine(message));
+    connection.writeLine("exit " + std::to_string(EXIT_FAILURE));
+}
+
+}
+
+DaemonServer::DaemonServer(const std::string &socketName, WorkStealingScheduler &scheduler, Program program):
+    socketName(socketName), scheduler(scheduler), program(std::move(program)), stopping(false)
+{}
+
+void DaemonServer::run(const std::atomic<bool> &stopRequested)
+{
+    const int listeningSocket = listenUnixSocket(socketName);
+    std::thread jobsThread(&DaemonServer::runJobs, this);
+
+    // Connections are accepted in this thread and read in their own ones, which are joined, when they have finished.
+    struct ConnectionThread
+    {
+        std::thread thread;
+        std::shared_ptr<std::atomic<bool>> finished;
+    };
+    std::list<ConnectionThread> connectionThreads;
+    while(!stopRequested)
+    {
+        pollfd listeningPoll = {listeningSocket, POLLIN, 0};
+        if(::poll(&listeningPoll, 1, 100) > 0)
+        {
+            const int connectedSocket = ::accept(listeningSocket, nullptr, nullptr);
+            // Mode of socket already keeps other users out, peer is checked in case socket is made accessible
+            // (e.g. its directory is mounted elsewhere or mode is changed).
+            if(connectedSocket >= 0 && !isPeerOfSameUser(connectedSocket))
+            {
+                LineConnection connection(connectedSocket);
+                rejectJob(connection, "ERROR: Daemon accepts jobs only from its own user.");
+            }
+            else if(connectedSocket >= 0)
+            {
+                // Client, which doesn't send its job, can't hold the daemon at stop.
+                const timeval receiveTimeout = {10, 0};
+                ::setsockopt(connectedSocket, SOL_SOCKET, SO_RCVTIMEO, &receiveTimeout, sizeof(receiveTimeout));
+                std::shared_ptr<LineConnection> connection(new LineConnection(connectedSocket));
+                std::shared_ptr<std::atomic<bool>> finished(new std::atomic<bool>(false));
+                connectionThreads.push_back({std::thread([this, connection, finished]()
+                                                         {
+                                                             acceptJob(connection);
+                                                             *finished = true;
+                                                         }),
+                                             finished});
+            }
+        }
+        for(auto connectionThread = connectionThreads.begin(); connectionThread != connectionThreads.end();)
+        {
+            if(*connectionThread->finished)
+            {
+                connectionThread->thread.join();
+                connectionThread = connectionThreads.erase(connectionThread);
+            }
+            else
+            {
+                ++connectionThread;
+            }
+        }
+    }
+    ::close(listeningSocket);
+    ::unlink(socketName.c_str());
+
+    // Jobs, which are still being estimated, are rejected by the closed queue.
+    for(const std::shared_ptr<DaemonJob> &job: jobs.close())
+    {
+        rejectJob(*job->connection, "ERROR: Daemon is stopped before the job is run.");
+    }
+    {
+        std::lock_guard<std::mutex> lock(runningJobMutex);
+        stopping = true;
+        if(runningJob)
+        {
+            runningJob->interrupted = true;
+        }
+    }
+    jobsThread.join();
+    for(ConnectionThread &connectionThread: connectionThreads)
+    {
+        connectionThread.thread.join();
+    }
+}
+
+void DaemonServer::acceptJob(std::shared_ptr<LineConnection> connection)
+{
+    std::shared_ptr<DaemonJob> job(new DaemonJob());
+    job->connection = connection;
+    std::string line;
+    while(true)
+    {
+        if(!connection->readLine(line))
+        {
+            return;
+        }
+        if(line == "run")
+        {
+            break;
+        }
+        const std::size_t separatorPosition = line.find(' ');
+        const std::string kind = line.substr(0, separatorPosition);
+        const std::string value = separatorPosition != std::string::npos ?
+                                  unescapeLine(line.substr(separatorPosition + 1)) : "";
+        try
+        {
+            if(kind == "directory")
+            {
+                job->workingDirectory = value;
+            }
+            else if(kind == "priority")
+            {
+                job->priority = std::stoi(value);
+            }
+            else if(kind == "argument")
+            {
+                job->arguments.push_back(value);
+            }
+            else
+            {
+                throw std::invalid_argument(kind);
+            }
+        }
+        catch(const std::exception &)
+        {
+            rejectJob(*connection, "ERROR: Daemon has got malformed job line \"" + line + "\".");
+            return;
+        }
+    }
+
+    // Estimation prints nothing, unless the job has already finished by it (e.g. options are wrong).
+    std::ostringstream output, errors;
+    ProgramContext context(output, errors, job->interrupted);
+    context.workingDirectory = job->workingDirectory;
+    context.estimateOnly = true;
+    int exitCode;
+    bool isFinished = false;
+    try
+    {
+        exitCode = program(job->arguments, context);
+    }
+    catch(const ProgramExit &programExit)
+    {
+        exitCode = programExit.getExitCode();
+        isFinished = true;
+    }
+    catch(const std::exception &error)
+    {
+        errors << "ERROR: " << error.what() << "." << std::endl;
+        exitCode = EXIT_FAILURE;
+    }
+    if(isFinished || exitCode != EXIT_SUCCESS)
+    {
+        sendText(*connection, "output", output.str());
+        sendText(*connection, "errors", errors.str());
+        connection->writeLine("exit " + std::to_string(exitCode));
+        return;
+    }
+
+    job->estimatedSize = context.estimatedSize;
+    if(!jobs.push(job))
+    {
+        rejectJob(*connection, "ERROR: Daemon is stopped before the job is run.");
+    }
+}
+
+void DaemonServer::runJobs()
+{
+    while(std::shared_ptr<DaemonJob> job = jobs.pop())
+    {
+        {
+            // Job taken just before stop is interrupted at once.
+            std::lock_guard<std::mutex> lock(runningJobMutex);
+            runningJob = job;
+            if(stopping)
+            {
+                job->interrupted = true;
+            }
+        }
+
+        // Client, which has gone, is waiting for nothing, so its job is interrupted, even if it prints nothing
+        // (otherwise it would also hold all jobs in queue).
+        std::atomic<bool> isJobRunning(true);
+        std::thread disconnectionThread([&job, &isJobRunning]()
+                                        {
+                                            while(isJobRunning)
+                                            {
+                                                if(job->connection->waitForClose(100))
+                                                {
+                                                    job->interrupted = true;
+                                                    return;
+                                                }
+                                            }
+                                        });
+
+        int exitCode;
+        {
+            ConnectionStreamBuffer outputBuffer(*job->connection, "output", job->interrupted),
+                                   errorsBuffer(*job->connection, "errors", job->interrupted);
+            std::ostream output(&outputBuffer), errors(&errorsBuffer);
+            ProgramContext context(output, errors, job->interrupted);
+            context.scheduler = &scheduler;
+            context.workingDirectory = job->workingDirectory;
+            context.calibratedBackends = &calibratedBackends;
+            try
+            {
+                exitCode = program(job->arguments, context);
+            }
+            catch(const ProgramExit &programExit)
+            {
+                exitCode = programExit.getExitCode();
+            }
+            catch(const std::exception &error)
+            {
+                errors << "ERROR: " << error.what() << "." << std::endl;
+                exitCode = EXIT_FAILURE;
+            }
+            output.flush();
+            errors.flush();
+        }
+        isJobRunning = false;
+        disconnectionThread.join();
+        job->connection->writeLine("exit " + std::to_string(exitCode));
+
+        std::lock_guard<std::mutex> lock(runningJobMutex);
+        runningJob.reset();
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef DAEMON_SERVER_H
+#define DAEMON_SERVER_H
+
+#include <string>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstddef>
+
+#include "program_context.h"
+#include "job_queue.h"
+
+class WorkStealingScheduler;
+
+/**
+ * class DaemonServer accepts jobs on Unix socket and runs them by program one by one on threads of scheduler,
+ * which are created once and kept between jobs, as well as calibrated backends of cryptography. So a small job
+ * costs only parsing of its files and its search.
+ * Each job is estimated (options and files are parsed, searched passwords are counted) in the thread of its
+ * connection and waits in queue ordered by priority and estimation. Output of a running job is streamed
+ * to its client line by line, and the job is interrupted, as soon as its client disconnects.
+ */
+class DaemonServer
+{
+private:
+    const std::string socketName;
+    WorkStealingScheduler &scheduler;
+    const Program program;
+
+    JobQueue jobs;
+    std::map<std::size_t, CryptoBackends> calibratedBackends;
+    std::mutex runningJobMutex;
+    std::shared_ptr<DaemonJob> runningJob;
+    bool stopping;
+
+    void acceptJob(std::shared_ptr<LineConnection> connection);
+    void runJobs();
+
+public:
+    DaemonServer(const std::string &socketName, WorkStealingScheduler &scheduler, Program program);
+
+    /**
+     * Serves jobs until stopRequested is set. Then jobs in queue are rejected, the running one is interrupted
+     * and socket is removed. Throws std::runtime_error, if socket can't be created.
+     */
+    void run(const std::atomic<bool> &stopRequested);
+};
+
+#endif
@@ -0,0 +1,70 @@
+#include "job_queue.h"
+
+#include <tuple>
+
+bool JobQueue::RunsLater::operator()(const std::shared_ptr<DaemonJob> &job,
+                                     const std::shared_ptr<DaemonJob> &otherJob) const
+{
+    if(job->priority != otherJob->priority)
+    {
+        return(job->priority < otherJob->priority);
+    }
+    return(std::make_tuple(job->estimatedSize, job->sequence) >
+           std::make_tuple(otherJob->estimatedSize, otherJob->sequence));
+}
+
+JobQueue::JobQueue():
+    nextSequence(0), closed(false)
+{}
+
+bool JobQueue::push(std::shared_ptr<DaemonJob> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(closed)
+        {
+            return(false);
+        }
+        job->sequence = nextSequence++;
+        jobs.push(std::move(job));
+    }
+    jobPushed.notify_one();
+    return(true);
+}
+
+std::shared_ptr<DaemonJob> JobQueue::pop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    jobPushed.wait(lock, [this]()
+                   {
+                       return(closed || !jobs.empty());
+                   });
+    if(closed)
+    {
+        return(nullptr);
+    }
+    std::shared_ptr<DaemonJob> job = jobs.top();
+    jobs.pop();
+    return(job);
+}
+
+std::vector<std::shared_ptr<DaemonJob>> JobQueue::close()
+{
+    std::vector<std::shared_ptr<DaemonJob>> remainingJobs;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        for(; !jobs.empty(); jobs.pop())
+        {
+            remainingJobs.push_back(jobs.top());
+        }
+    }
+    jobPushed.notify_all();
+    return(remainingJobs);
+}
+
+std::size_t JobQueue::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return(jobs.size());
+}
@@ -0,0 +1,76 @@
+#ifndef JOB_QUEUE_H
+#define JOB_QUEUE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <queue>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+#include "../search/candidate_source.h"
+
+class LineConnection;
+
+/**
+ * Job accepted by daemon: command line arguments of the search with working directory of client, which they are
+ * resolved against, and connection, which results are streamed into.
+ */
+struct DaemonJob
+{
+    std::vector<std::string> arguments;
+    std::string workingDirectory;
+    int priority = 0;
+    // Number of passwords searched by the job.
+    KeyspaceIndex estimatedSize = 0;
+    // Order of jobs in queue, it is set by queue.
+    std::uint64_t sequence = 0;
+    std::shared_ptr<LineConnection> connection;
+    // Set, when the job should stop: client has gone or daemon is stopping.
+    std::atomic<bool> interrupted{false};
+};
+
+/**
+ * class JobQueue keeps jobs waiting for threads of daemon. Jobs of higher priority are taken first, jobs
+ * of the same priority with less passwords are taken first (so small jobs never wait for large ones
+ * of the same priority) and jobs of the same priority and size are taken in order of arrival.
+ */
+class JobQueue
+{
+private:
+    struct RunsLater
+    {
+        bool operator()(const std::shared_ptr<DaemonJob> &job, const std::shared_ptr<DaemonJob> &otherJob) const;
+    };
+
+    std::priority_queue<std::shared_ptr<DaemonJob>, std::vector<std::shared_ptr<DaemonJob>>, RunsLater> jobs;
+    std::uint64_t nextSequence;
+    bool closed;
+    mutable std::mutex mutex;
+    std::condition_variable jobPushed;
+
+public:
+    JobQueue();
+
+    /**
+     * Adds job to queue. Returns false, if queue is closed and job is not added.
+     */
+    bool push(std::shared_ptr<DaemonJob> job);
+
+    /**
+     * Waits for a job and takes the first one. Returns nullptr, when queue is closed.
+     */
+    std::shared_ptr<DaemonJob> pop();
+
+    /**
+     * Closes queue and returns jobs, which have not been taken, in order they would be taken.
+     */
+    std::vector<std::shared_ptr<DaemonJob>> close();
+
+    std::size_t size() const;
+};
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef PROGRAM_CONTEXT_H
+#define PROGRAM_CONTEXT_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <atomic>
+#include <ostream>
+#include <functional>
+#include <cstddef>
+
+#include "../cryptography/crypto_backend.h"
+#include "../search/candidate_source.h"
+
+class WorkStealingScheduler;
+
+/**
+ * Environment of a single run of the program with given command line arguments: in a process of its own
+ * or as a job of daemon. Passwords are printed into output, warnings, errors and progress into errors.
+ */
+struct ProgramContext
+{
+    std::ostream &output;
+    std::ostream &errors;
+    // Set, when the search should stop and save its checkpoint (by signal or when client of job has gone).
+    std::atomic<bool> &interrupted;
+    // Warm threads of daemon. If it is not set, threads are created as options of the run require.
+    WorkStealingScheduler *scheduler = nullptr;
+    // Directory, which relative names of files are resolved against. If it is empty, the current one is used.
+    std::string workingDirectory;
+    // Signals are handled only by run in a process of its own.
+    bool handleSignals = false;
+    // If it is set, the run only parses options and files and sets estimatedSize to number of searched passwords.
+    bool estimateOnly = false;
+    KeyspaceIndex estimatedSize = 0;
+    // Backends calibrated by previous runs for texts of the same size, if they should be reused.
+    std::map<std::size_t, CryptoBackends> *calibratedBackends = nullptr;
+
+    ProgramContext(std::ostream &output, std::ostream &errors, std::atomic<bool> &interrupted):
+        output(output), errors(errors), interrupted(interrupted)
+    {}
+};
+
+/**
+ * Thrown by a run instead of exiting the process, so that daemon survives failures of its jobs.
+ */
+class ProgramExit
+{
+private:
+    int exitCode;
+
+public:
+    explicit ProgramExit(int exitCode):
+        exitCode(exitCode)
+    {}
+
+    int getExitCode() const
+    {
+        return(exitCode);
+    }
+};
+
+/**
+ * Run of the program: returns exit code or throws ProgramExit.
+ */
+using Program = std::function<int(const std::vector<std::string> &arguments, ProgramContext &context)>;
+
+#endif
@@ -0,0 +1,186 @@
+#include "generate_cipher_file.h"
+
+#include <gcrypt.h>
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <random>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+#include <limits>
+#include <cctype>
+#include <type_traits>
+#include <cstdio>
+
+#include "../cryptography/md5_batch.h"
+#include "../cryptography/des_bitslice.h"
+#include "../cryptography/sha256_batch.h"
+#include "../util/gcry_exception.h"
+
+namespace
+{
+
+// Text is generated, hashed and encrypted by chunks of whole blocks.
+constexpr std::size_t chunkSize = 1 << 20;
+
+typedef std::unique_ptr<std::remove_pointer<gcry_cipher_hd_t>::type, void (*)(gcry_cipher_hd_t)> CipherHandle;
+typedef std::unique_ptr<std::remove_pointer<gcry_md_hd_t>::type, void (*)(gcry_md_hd_t)> HashHandle;
+
+CipherHandle openCipher(const std::string &password)
+{
+    // Libgcrypt uses 24 bytes key, so EDE2 key is extended by its first DES key.
+    unsigned char key[tripleDesEde2KeySize + tripleDesBlockSize];
+    static_assert(md5DigestSize == tripleDesEde2KeySize, "MD5 of password is a key of 3DES(EDE2)");
+    gcry_md_hash_buffer(GCRY_MD_MD5, key, password.data(), password.size());
+    std::copy_n(key, tripleDesBlockSize, key + tripleDesEde2KeySize);
+
+    gcry_cipher_hd_t cipher;
+    processGcryError(gcry_cipher_open(&cipher, GCRY_CIPHER_3DES, GCRY_CIPHER_MODE_CBC, 0));
+    CipherHandle cipherHandle(cipher, gcry_cipher_close);
+    processGcryError(gcry_cipher_setkey(cipher, key, sizeof(key)));
+    return(cipherHandle);
+}
+
+// Fills bytes with pseudorandom ones. Bytes are taken from numbers in the same order on any platform,
+// so the same seed gives the same file everywhere.
+void fillRandom(std::mt19937_64 &generator, unsigned char *bytes, std::size_t size)
+{
+    for(std::size_t index = 0; index < size; index += 8)
+    {
+        const std::uint64_t value = generator();
+        for(std::size_t byteIndex = 0; byteIndex < 8 && index + byteIndex < size; ++byteIndex)
+        {
+            bytes[index + byteIndex] = static_cast<unsigned char>(value >> (8 * byteIndex));
+        }
+    }
+}
+
+}
+
+bool generateCipherFile(const std::string &fileName, const CipherFileParameters &parameters,
+                        const std::atomic<bool> *interrupted)
+{
+    if(!parameters.padding && (parameters.textSize == 0 || parameters.textSize % tripleDesBlockSize != 0))
+    {
+        throw std::runtime_error("ERROR in generateCipherFile: size of text without padding must be a positive "
+                                 "multiple of " + std::to_string(tripleDesBlockSize) + " bytes");
+    }
+    const std::size_t paddingSize = parameters.padding ?
+                                    tripleDesBlockSize - parameters.textSize % tripleDesBlockSize : 0;
+    if(parameters.textSize > std::numeric_limits<std::uint64_t>::max() - paddingSize)
+    {
+        throw std::runtime_error("ERROR in generateCipherFile: size of text is too large");
+    }
+    const std::uint64_t paddedSize = parameters.textSize + paddingSize;
+
+    std::mt19937_64 generator(parameters.seed);
+    unsigned char initialValue[tripleDesBlockSize];
+    fillRandom(generator, initialValue, sizeof(initialValue));
+
+    const CipherHandle cipher = openCipher(parameters.password);
+    processGcryError(gcry_cipher_setiv(cipher.get(), initialValue, sizeof(initialValue)));
+    gcry_md_hd_t sha256;
+    processGcryError(gcry_md_open(&sha256, GCRY_MD_SHA256, 0));
+    const HashHandle sha256Handle(sha256, gcry_md_close);
+
+    std::ofstream output(fileName, std::ios_base::binary | std::ios_base::trunc);
+    output.write(reinterpret_cast<const char *>(initialValue), sizeof(initialValue));
+
+    // CBC chains blocks between calls of encryption, so chunks are encrypted as one text.
+    std::vector<unsigned char> text(std::min<std::uint64_t>(chunkSize, paddedSize)), cipherText(text.size());
+    for(std::uint64_t offset = 0; offset < paddedSize && output; offset += text.size())
+    {
+        const std::size_t size = static_cast<std::size_t>(std::min<std::uint64_t>(text.size(), paddedSize - offset));
+        fillRandom(generator, text.data(), size);
+        if(offset + size > parameters.textSize)
+        {
+            std::fill(text.begin() + (size - paddingSize), text.begin() + size,
+                      static_cast<unsigned char>(paddingSize));
+        }
+        gcry_md_write(sha256, text.data(), size);
+        processGcryError(gcry_cipher_encrypt(cipher.get(), cipherText.data(), size, text.data(), size));
+        output.write(reinterpret_cast<const char *>(cipherText.data()), size);
+
+        if(interrupted != nullptr && *interrupted)
+        {
+            output.close();
+            std::remove(fileName.c_str());
+            return(false);
+        }
+    }
+
+    output.write(reinterpret_cast<const char *>(gcry_md_read(sha256, GCRY_MD_SHA256)), sha256DigestSize);
+    output.flush();
+    if(!output)
+    {
+        throw std::runtime_error("ERROR in generateCipherFile: can't write cipher file " + fileName);
+    }
+    return(true);
+}
+
+std::vector<std::string> generateCipherCorpus(const std::string &fileName, const CipherFileParameters &parameters,
+                                              std::size_t filesCount, const std::atomic<bool> *interrupted)
+{
+    std::vector<std::string> fileNames;
+    CipherFileParameters fileParameters = parameters;
+    for(std::size_t index = 0; index < filesCount; ++index)
+    {
+        const std::string corpusFileName = getCorpusFileName(fileName, index, filesCount);
+        fileParameters.seed = parameters.seed + index;
+        if(!generateCipherFile(corpusFileName, fileParameters, interrupted))
+        {
+            break;
+        }
+        fileNames.push_back(corpusFileName);
+    }
+    return(fileNames);
+}
+
+std::string getCorpusFileName(const std::string &fileName, std::size_t index, std::size_t filesCount)
+{
+    if(filesCount == 1)
+    {
+        return(fileName);
+    }
+    const std::size_t width = std::to_string(filesCount - 1).size();
+    std::ostringstream corpusFileName;
+    corpusFileName << fileName << '.' << std::setw(width) << std::setfill('0') << index;
+    return(corpusFileName.str());
+}
+
+std::uint64_t parseByteSize(const std::string &size)
+{
+    std::size_t digitsCount = 0;
+    while(digitsCount < size.size() && size[digitsCount] >= '0' && size[digitsCount] <= '9')
+    {
+        ++digitsCount;
+    }
+    unsigned int shift = 0;
+    if(digitsCount + 1 == size.size())
+    {
+        const std::string suffixes = "KMG";
+        const std::size_t suffixIndex = suffixes.find(static_cast<char>(std::toupper(size.back())));
+        if(suffixIndex == std::string::npos)
+        {
+            throw std::invalid_argument("unknown suffix of size " + size);
+        }
+        shift = 10 * static_cast<unsigned int>(suffixIndex + 1);
+    }
+    else if(digitsCount != size.size())
+    {
+        throw std::invalid_argument("malformed size " + size);
+    }
+    if(digitsCount == 0 || digitsCount > 19)
+    {
+        throw std::invalid_argument("malformed size " + size);
+    }
+
+    const std::uint64_t value = std::stoull(size.substr(0, digitsCount));
+    if(value > std::numeric_limits<std::uint64_t>::max() >> shift)
+    {
+        throw std::invalid_argument("too large size " + size);
+    }
+    return(value << shift);
+}
@@ -0,0 +1,55 @@
+#ifndef GENERATE_CIPHER_FILE_H
+#define GENERATE_CIPHER_FILE_H
+
+#include <string>
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * Parameters of synthetic cipher file. Original text consists of textSize pseudorandom bytes generated from seed,
+ * which are padded by PKCS#5/7 if padding is set (otherwise textSize must be a multiple of 3DES block size).
+ */
+struct CipherFileParameters
+{
+    std::string password;
+    std::uint64_t textSize = 1024;
+    bool padding = false;
+    std::uint64_t seed = 0;
+};
+
+/**
+ * Writes file in the format read by parseFile: initial value generated from seed, original text encrypted
+ * by 3DES(EDE2) in CBC mode with keys got from MD5 of password, and SHA256 of original text (with padding).
+ * Text is generated, encrypted and written by chunks, so file can be much larger than memory.
+ * If interrupted is given and gets set, generation stops between chunks, partially written file is removed
+ * and false is returned.
+ * Throws std::runtime_error if parameters are invalid or file can't be written and CryptoException if
+ * encryption fails.
+ */
+bool generateCipherFile(const std::string &fileName, const CipherFileParameters &parameters,
+                        const std::atomic<bool> *interrupted = nullptr);
+
+/**
+ * Writes filesCount files of corpus with the same password and size. Files are named by getCorpusFileName
+ * and the seed of each file is the seed of parameters plus index of file, so files of corpus differ.
+ * Returns names of written files, which are fewer than filesCount, if generation is interrupted.
+ */
+std::vector<std::string> generateCipherCorpus(const std::string &fileName, const CipherFileParameters &parameters,
+                                              std::size_t filesCount, const std::atomic<bool> *interrupted = nullptr);
+
+/**
+ * Returns name of index-th (from zero) file of corpus of filesCount (at least one) files: fileName itself
+ * for a single file, otherwise fileName followed by dot and index, padded by zeros to the same width
+ * (e.g. "file.bin.007").
+ */
+std::string getCorpusFileName(const std::string &fileName, std::size_t index, std::size_t filesCount);
+
+/**
+ * Parses size of text in bytes with optional binary suffix K, M or G (e.g. "64K" or "2G").
+ * Throws std::invalid_argument if size is malformed.
+ */
+std::uint64_t parseByteSize(const std::string &size);
+
+#endif
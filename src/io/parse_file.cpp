@@ -1,11 +1,11 @@
 #include "parse_file.h"
 
-#include <fstream>
 #include <sstream>
+#include <memory>
+#include <stdexcept>
 
 #include <boost/filesystem.hpp>
-
-#include "../util/make_shared_array.h"
+#include <boost/iostreams/device/mapped_file.hpp>
 
 ParsedFile parseFile(const std::string& fileName, std::size_t initialValueSize, std::size_t shaCheckSumSize)
 {
@@ -24,26 +24,28 @@ ParsedFile parseFile(const std::string& fileName, std::size_t initialValueSize,
         throw std::runtime_error(errorMessage.str());
     }
     
-    std::ifstream fileToParse;
-    // Setting up exception to be thrown.
-    fileToParse.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    fileToParse.open(fileName, std::ios_base::binary);
+    // Mapping is shared by views of all fields and is unmapped, when the last copy of them is destroyed.
+    // Failure of mapping throws std::ios_base::failure.
+    const std::shared_ptr<boost::iostreams::mapped_file_source> mappedFile =
+        std::make_shared<boost::iostreams::mapped_file_source>(fileName);
+    const unsigned char *fileData = reinterpret_cast<const unsigned char *>(mappedFile->data());
+    auto makeView = [&mappedFile](const unsigned char *fieldData)
+    {
+        return(boost::shared_array<const unsigned char>(fieldData, [mappedFile](const unsigned char *) {}));
+    };
     
     ParsedFile parsedFile;
     
-    // Reading each field one by one and assigning it to parsedFile structure.
+    // Each field is a view into its part of the mapped file.
     
     parsedFile.initialValueSize = initialValueSize;
-    parsedFile.initialValue = make_shared_array<unsigned char>(parsedFile.initialValueSize);
-    fileToParse.read(reinterpret_cast<char *>(parsedFile.initialValue.get()), parsedFile.initialValueSize);
+    parsedFile.initialValue = makeView(fileData);
     
     parsedFile.contentSize = fileSize - initialValueSize - shaCheckSumSize;
-    parsedFile.content = make_shared_array<unsigned char>(parsedFile.contentSize);
-    fileToParse.read(reinterpret_cast<char *>(parsedFile.content.get()), parsedFile.contentSize);
+    parsedFile.content = makeView(fileData + initialValueSize);
     
     parsedFile.shaCheckSumSize = shaCheckSumSize;
-    parsedFile.shaCheckSum = make_shared_array<unsigned char>(parsedFile.shaCheckSumSize);
-    fileToParse.read(reinterpret_cast<char *>(parsedFile.shaCheckSum.get()), parsedFile.shaCheckSumSize);
+    parsedFile.shaCheckSum = makeView(fileData + initialValueSize + parsedFile.contentSize);
     
     return(parsedFile);
 }
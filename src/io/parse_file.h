@@ -5,15 +5,21 @@
 #include <cstddef>
 #include <string>
 
+/**
+ * Fields of cipher file. Parsed files are read-only views into memory mapped file: fields point into the mapping
+ * and any copy of them keeps it mapped.
+ */
 struct ParsedFile
 {
     // We use unsigned char to make it easier to use libgcrypt functions with current data.
-    boost::shared_array<unsigned char> initialValue, content, shaCheckSum;
+    boost::shared_array<const unsigned char> initialValue, content, shaCheckSum;
     std::size_t initialValueSize, contentSize, shaCheckSumSize;
 };
 
 /**
  * Split given file by three fields. First and third are with fixed size and second with flexible size between them.
+ * File is memory mapped instead of being read, so parsing takes constant time and pages of file in page cache are
+ * shared by all threads and processes, which check it.
  */
 ParsedFile parseFile(const std::string &fileName, std::size_t initialValueSize, std::size_t shaCheckSumSize);
 
@@ -1,69 +1,140 @@
 #include <boost/program_options.hpp>
-#include <boost/range/irange.hpp>
-#include <boost/ptr_container/ptr_vector.hpp>
 
 #include "io/parse_file.h"
+#include "io/generate_cipher_file.h"
 
 #include "cryptography/check_password.h"
+#include "cryptography/plaintext_filter.h"
+#include "cryptography/crypto_backend.h"
+
+#include "search/search_worker.h"
+#include "search/mask_keyspace.h"
+#include "search/wordlist.h"
+#include "search/rules.h"
+#include "search/markov_model.h"
+#include "search/checkpoint.h"
+#include "search/progress_reporter.h"
+#include "search/work_stealing_scheduler.h"
+
+#include "daemon/program_context.h"
+#include "daemon/daemon_server.h"
+#include "daemon/daemon_client.h"
 
-#include "util/variadic_iter_join.h"
-#include "util/cartesian_range_power.h"
 #include "util/gcry_exception.h"
+#include "util/crypto_exception.h"
 
 #include <iostream>
 #include <string>
+#include <vector>
 #include <cstdlib>
 #include <exception>
+#include <stdexcept>
+#include <memory>
+#include <algorithm>
+#include <utility>
+#include <tuple>
+#include <map>
+#include <sstream>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+
+#include <boost/filesystem.hpp>
 
 #include <gcrypt.h>
 
+#ifdef _OPENMP
 #include <omp.h>
+#endif
 
-constexpr char nextChar(char letter)
+namespace
 {
-    return(letter + 1);
-}
 
-int main(int argc, char **argv)
+// Set by SIGINT or SIGTERM, when search is checkpointed: threads skip remaining chunks, so the progress
+// could be saved and the search resumed later.
+std::atomic<bool> searchInterrupted(false);
+
+extern "C" void interruptSearch(int)
 {
-/*----------start of libgcrypt initialization section----------*/
+    searchInterrupted = true;
+}
 
-    // Version check should be the very first call because it
-    // makes sure that important subsystems are initialized.
-    if(!gcry_check_version (GCRYPT_VERSION))
-    {
-        std::cerr << "ERROR: Can't initialize libgcrypt. Version mismatch." << std::endl;
-        std::exit(EXIT_FAILURE);
-    }
+// Options of threads are shared by a run in a process of its own and by daemon, which creates threads once
+// for all its jobs.
+boost::program_options::options_description getThreadOptions(std::size_t &threadsCount, bool &pinThreads)
+{
+    boost::program_options::options_description threadOptions("Thread options");
+    threadOptions.add_options()
+        ("threads", boost::program_options::value<std::size_t>(&threadsCount)->default_value(0),
+         "Number of search threads. 0 means the number of OpenMP threads (OMP_NUM_THREADS or all CPUs).")
+        ("pin-threads", boost::program_options::bool_switch(&pinThreads)->default_value(false),
+         "Pins search threads to CPUs available for the process, so buffers of each thread are allocated "
+         "on its NUMA node and stay there.");
+    return(threadOptions);
+}
 
-    // Disable secure memory.
-    try
-    {
-        processGcryError(gcry_control(GCRYCTL_DISABLE_SECMEM, 0));
-    }
-    catch(const GcryException &gcryException)
-    {
-        std::cerr << "WARNING: Disabling secure memory failed." << std::endl;
-    }
+boost::program_options::options_description getDaemonOptions(std::string &daemonSocketName,
+                                                              std::string &clientSocketName, int &priority)
+{
+    boost::program_options::options_description daemonOptions("Daemon options");
+    daemonOptions.add_options()
+        ("daemon", boost::program_options::value<std::string>(&daemonSocketName),
+         "Runs daemon, which accepts jobs on given Unix socket and runs them one by one on its threads, which are "
+         "kept between jobs (only thread options are allowed besides it). Jobs of higher priority are run first, "
+         "jobs of the same priority with less passwords are run first. SIGINT or SIGTERM stops daemon.")
+        ("client", boost::program_options::value<std::string>(&clientSocketName),
+         "Sends other options as a job to daemon on given Unix socket and prints its passwords, warnings and "
+         "progress as if the search was run by this process. Thread options of the job are ignored.")
+        ("priority", boost::program_options::value<int>(&priority)->default_value(0),
+         "Priority of the job sent to daemon.");
+    return(daemonOptions);
+}
 
-    // Tell Libgcrypt that initialization has completed.
-    try
-    {
-        processGcryError(gcry_control (GCRYCTL_INITIALIZATION_FINISHED, 0));
-    }
-    catch(const GcryException &gcryException)
+// Critical sections of output and of checkpoint are OpenMP ones, so without OpenMP there is a single thread.
+std::size_t getThreadsCount(std::size_t threadsCount)
+{
+#ifdef _OPENMP
+    if(threadsCount == 0)
     {
-        std::cerr << "ERROR: Can't initialize libgcrypt." << std::endl;
-        std::cerr << gcryException.what() << std::endl;
-        std::exit(EXIT_FAILURE);
+        threadsCount = omp_get_max_threads();
     }
-/*----------end of libgcrypt initialization section----------*/
+#else
+    threadsCount = 1;
+#endif
+    return(threadsCount);
+}
 
+// Parses command line arguments, searches passwords and prints them. It is run by main for the process itself
+// and by daemon for each its job, so it never exits the process: failures are thrown as ProgramExit.
+int runProgram(const std::vector<std::string> &arguments, ProgramContext &context)
+{
 /*----------start of command line options parsing section----------*/
     
     // Variables to store command line options.
-    std::string cipherFileName;
-    bool printDecryptedText;
+    std::vector<std::string> cipherFileNames;
+    std::string wordlistFileName, rulesFileName;
+    std::string markovModelFileName, markovTrainingFileName;
+    std::string generatedFileName, generatedTextSize;
+    CipherFileParameters generatedFileParameters;
+    std::size_t generatedFilesCount;
+    SearchOptions searchOptions;
+    std::string mask;
+    std::vector<std::string> customCharsets(maskCustomCharsetsCount);
+    std::size_t minLength, maxLength;
+    std::string checkpointFileName;
+    unsigned int checkpointInterval;
+    unsigned int progressInterval;
+    std::size_t threadsCount;
+    bool pinThreads;
+    std::string statusFileName;
+    bool resumeSearch;
+    KeyspaceIndex shardIndex = 0, shardsCount = 0, skipCount, limitCount;
+    std::string completionRecordFileName;
+    std::vector<std::string> mergedRecordFileNames;
+    std::string knownPrefix;
+    std::size_t printablePrefixSize;
+    std::map<std::string, CryptoBackend> requestedBackends;
+    bool showBackends;
     
     try{
         // We separate help options and main options to allow users to specify help options 
@@ -78,10 +149,209 @@ int main(int argc, char **argv)
         // Another option is a bool flag, whether or not a decrypted text should be printed.
         boost::program_options::options_description mainOptions("Main options");
         mainOptions.add_options()
-            ("print-decrypted,p", boost::program_options::bool_switch(&printDecryptedText)->default_value(false),
+            ("print-decrypted,p", boost::program_options::bool_switch(&searchOptions.printDecryptedText)
+                                  ->default_value(false),
              "Prints for all acceptable password decrypted text.")
-            ("CIPHERFILE", boost::program_options::value<std::string>(&cipherFileName)->required(),
-             "Can be passed a first positional argument.\n"
+            ("chunk-size,c", boost::program_options::value<std::size_t>(&searchOptions.chunkSize)
+                             ->default_value(0),
+             "Number of consecutive passwords (or bytes of wordlist) taken by a thread at once. "
+             "0 means 4096 passwords or 1 MiB of wordlist.")
+            ("padding-prefilter", boost::program_options::bool_switch(&searchOptions.usePaddingPrefilter)
+                                  ->default_value(false),
+             "Rejects passwords, for which the last decrypted block doesn't have valid PKCS#5/7 padding, "
+             "before decrypting the whole text. If no password passes this check, the search is repeated "
+             "without it.")
+            ("des-engine", boost::program_options::value<std::string>()->default_value("bitslice")
+                           ->notifier([&searchOptions, &requestedBackends](const std::string &desEngine)
+                           {
+                               if(desEngine != "bitslice" && desEngine != "per-key" && desEngine != "gcrypt")
+                               {
+                                   throw boost::program_options::validation_error(
+                                       boost::program_options::validation_error::invalid_option_value,
+                                       "des-engine", desEngine);
+                               }
+                               searchOptions.useBitslicedDes = desEngine == "bitslice";
+                               // Value "gcrypt" is kept for compatibility, it is "per-key" with libgcrypt 3DES.
+                               if(desEngine == "gcrypt")
+                               {
+                                   requestedBackends.emplace("3des", CryptoBackend::Gcrypt);
+                               }
+                           }),
+             "Implementation of 3DES decryption: \"bitslice\" decrypts ciphertext under a batch of keys at once, "
+             "\"per-key\" decrypts it for each key separately by 3DES backend (\"gcrypt\" is \"per-key\" "
+             "with libgcrypt).")
+            ("crypto-backend", boost::program_options::value<std::string>()->default_value("auto")
+                               ->notifier([&requestedBackends](const std::string &definition)
+                               {
+                                   // Either a single backend for all stages or a list of STAGE=BACKEND.
+                                   const std::vector<std::string> stages = {"md5", "3des", "sha256"};
+                                   std::istringstream definitionInput(definition);
+                                   std::string item;
+                                   try
+                                   {
+                                       while(definition != "auto" && std::getline(definitionInput, item, ','))
+                                       {
+                                           const std::size_t separator = item.find('=');
+                                           if(separator == std::string::npos)
+                                           {
+                                               for(const std::string &stage: stages)
+                                               {
+                                                   requestedBackends[stage] = parseCryptoBackend(item);
+                                               }
+                                               continue;
+                                           }
+                                           const std::string stage = item.substr(0, separator);
+                                           if(std::find(stages.begin(), stages.end(), stage) == stages.end())
+                                           {
+                                               throw std::invalid_argument("unknown stage " + stage);
+                                           }
+                                           requestedBackends[stage] = parseCryptoBackend(item.substr(separator + 1));
+                                       }
+                                   }
+                                   catch(const std::invalid_argument &)
+                                   {
+                                       throw boost::program_options::validation_error(
+                                           boost::program_options::validation_error::invalid_option_value,
+                                           "crypto-backend", definition);
+                                   }
+                               }),
+             "Implementations of stages of checking passwords: \"auto\" chooses the fastest ones by calibration "
+             "at startup, BACKEND sets it for all stages and a list of STAGE=BACKEND (e.g. \"md5=builtin,"
+             "3des=openssl\") sets it for given stages, others are calibrated. Stages are md5, 3des (per-key engine "
+             "and confirmation of found keys) and sha256 (the same), backends are builtin, gcrypt and openssl "
+             "(if the program is built with OpenSSL).")
+            ("show-backends", boost::program_options::bool_switch(&showBackends)->default_value(false),
+             "Prints speeds measured by calibration and chosen backends into standard error.")
+            ("known-prefix", boost::program_options::value<std::string>()
+                             ->notifier([&knownPrefix](const std::string &definition)
+                             {
+                                 try
+                                 {
+                                     knownPrefix = parseKnownPrefix(definition);
+                                 }
+                                 catch(const std::invalid_argument &)
+                                 {
+                                     throw boost::program_options::validation_error(
+                                         boost::program_options::validation_error::invalid_option_value,
+                                         "known-prefix", definition);
+                                 }
+                             }),
+             "Known beginning of original texts, e.g. \"%PDF-\" or \"PK\\x03\\x04\" (\\xHH is a byte with hex code HH, "
+             "\\\\ is a backslash). Passwords are rejected by decrypting only the first blocks, the full check "
+             "confirms the rest.")
+            ("magic", boost::program_options::value<std::string>()
+                      ->notifier([&knownPrefix](const std::string &format)
+                      {
+                          try
+                          {
+                              knownPrefix = getFormatSignature(format);
+                          }
+                          catch(const std::invalid_argument &)
+                          {
+                              throw boost::program_options::validation_error(
+                                  boost::program_options::validation_error::invalid_option_value, "magic", format);
+                          }
+                      }),
+             "Format of original texts, which magic bytes are used as known beginning: "
+             "pdf, zip, png, jpeg, gzip or xml.")
+            ("printable-prefix", boost::program_options::value<std::size_t>(&printablePrefixSize)->default_value(0),
+             "Number of the first bytes of original texts, which are printable ASCII characters (e.g. of text, XML "
+             "or JSON files). Passwords are rejected by them as by known beginning. The last block of text is never "
+             "checked, as it could contain padding.")
+            ("wordlist,w", boost::program_options::value<std::string>(&wordlistFileName),
+             "Checks words of given file (one per line) instead of passwords matching the mask.")
+            ("rules,r", boost::program_options::value<std::string>(&rulesFileName),
+             "Applies each rule of given file (one per line, in hashcat syntax: l u c C t TN r d f $X ^X [ ] sXY @X) "
+             "to each word of wordlist or password matching the mask.")
+            ("mask,m", boost::program_options::value<std::string>(&mask)->default_value("?1?1?1"),
+             "Mask of passwords: each position is a literal character or a placeholder of charset: "
+             "?l (a-z), ?u (A-Z), ?d (0-9), ?h (0-9a-f), ?H (0-9A-F), ?s (specials), ?a (?l?u?d?s), ?b (all bytes), "
+             "?? (question mark) or ?1 ... ?4 (custom charsets).")
+            ("custom-charset1,1", boost::program_options::value<std::string>(&customCharsets[0])
+                                  ->default_value("?l?u?d"),
+             "Custom charset ?1. Could contain placeholders of built-in charsets.")
+            ("custom-charset2,2", boost::program_options::value<std::string>(&customCharsets[1]),
+             "Custom charset ?2.")
+            ("custom-charset3,3", boost::program_options::value<std::string>(&customCharsets[2]),
+             "Custom charset ?3.")
+            ("custom-charset4,4", boost::program_options::value<std::string>(&customCharsets[3]),
+             "Custom charset ?4.")
+            ("markov", boost::program_options::value<std::string>(&markovModelFileName),
+             "Enumerates passwords of the mask lexicographically by ranks of characters, which are ordered at each "
+             "position by probability to follow the previous one in Markov model from given file "
+             "(see --train-markov).")
+            ("train-markov", boost::program_options::value<std::string>(&markovTrainingFileName),
+             "Trains Markov model on words of the wordlist (optionally transformed by rules), writes it into given "
+             "file and exits. CIPHERFILE is not needed.")
+            ("generate", boost::program_options::value<std::string>(&generatedFileName),
+             "Generates synthetic cipher file (or corpus of files, see --generate-count) encrypted with password "
+             "given by --generate-password, writes it into given file and exits. CIPHERFILE is not needed.")
+            ("generate-password", boost::program_options::value<std::string>(&generatedFileParameters.password),
+             "Password of generated cipher files.")
+            ("generate-size", boost::program_options::value<std::string>(&generatedTextSize)->default_value("1K"),
+             "Size of pseudorandom original text of generated files in bytes, optionally with suffix K, M or G. "
+             "Without --generate-padding it must be a multiple of 8.")
+            ("generate-padding", boost::program_options::bool_switch(&generatedFileParameters.padding)
+                                 ->default_value(false),
+             "Pads original text of generated files by PKCS#5/7.")
+            ("generate-seed", boost::program_options::value<std::uint64_t>(&generatedFileParameters.seed)
+                              ->default_value(0),
+             "Seed of initial values and texts of generated files. Files of corpus use consecutive seeds.")
+            ("generate-count", boost::program_options::value<std::size_t>(&generatedFilesCount)->default_value(1),
+             "Number of generated files. Files of corpus are named by given file name followed by dot and index.")
+            ("min-len", boost::program_options::value<std::size_t>(&minLength)->default_value(0),
+             "Minimal length of passwords, which are produced by prefixes of mask. 0 means the length of mask.")
+            ("max-len", boost::program_options::value<std::size_t>(&maxLength)->default_value(0),
+             "Maximal length of passwords. 0 means the length of mask.")
+            ("checkpoint", boost::program_options::value<std::string>(&checkpointFileName),
+             "Periodically saves progress of search (completed ranges of passwords, found passwords, hash of "
+             "CIPHERFILE and description of passwords) into given file. Search could be interrupted by SIGINT "
+             "or SIGTERM and continued later with --resume.")
+            ("checkpoint-interval", boost::program_options::value<unsigned int>(&checkpointInterval)
+                                    ->default_value(60),
+             "Number of seconds between saves of checkpoint.")
+            ("stop-after", boost::program_options::value<std::size_t>(&searchOptions.stopAfter)->default_value(0),
+             "Stops search, when given number of acceptable passwords is found for each CIPHERFILE. "
+             "0 means searching all passwords.")
+            ("progress-interval", boost::program_options::value<unsigned int>(&progressInterval)->default_value(0),
+             "Prints speed, done part of passwords, ETA and imbalance of threads into standard error every given "
+             "number of seconds. 0 means no progress (or every 10 seconds with --status-file).")
+            ("status-file", boost::program_options::value<std::string>(&statusFileName),
+             "Writes status of search (the same as progress) as JSON into given file every progress interval.")
+            ("resume", boost::program_options::bool_switch(&resumeSearch)->default_value(false),
+             "Continues search saved in checkpoint file (by default CIPHERFILE.checkpoint). Passwords and other "
+             "options must be the same as in the interrupted search.")
+            ("shard", boost::program_options::value<std::string>()
+                      ->notifier([&shardIndex, &shardsCount](const std::string &shard)
+                      {
+                          // Shards are numbered from 1 in command line.
+                          std::istringstream shardInput(shard);
+                          char separator = 0;
+                          if(!(shardInput >> shardIndex >> separator >> shardsCount) || separator != '/' ||
+                             !shardInput.eof() || shardIndex == 0 || shardIndex > shardsCount)
+                          {
+                              throw boost::program_options::validation_error(
+                                  boost::program_options::validation_error::invalid_option_value, "shard", shard);
+                          }
+                          --shardIndex;
+                      }),
+             "Searches only shard I of N (in form I/N, I from 1 to N) of passwords: contiguous slices of nearly "
+             "equal size, which are computed from number of passwords, so processes on different machines search "
+             "disjoint parts without any shared state.")
+            ("skip", boost::program_options::value<KeyspaceIndex>(&skipCount)->default_value(0),
+             "Skips given number of the first passwords (bytes of wordlist).")
+            ("limit", boost::program_options::value<KeyspaceIndex>(&limitCount)->default_value(0),
+             "Searches at most given number of passwords (bytes of wordlist) after skipped ones. 0 means no limit.")
+            ("completion-record", boost::program_options::value<std::string>(&completionRecordFileName),
+             "Writes into given file checked ranges of passwords and found passwords, when search of shard "
+             "(or of the whole passwords) is completed.")
+            ("merge-records", boost::program_options::value<std::vector<std::string>>(&mergedRecordFileNames),
+             "Merges completion records of shards (option is repeated for each of them) instead of search: prints "
+             "found passwords and reports passwords, which are not covered by records. Options of passwords must "
+             "be the same as in the search.")
+            ("CIPHERFILE", boost::program_options::value<std::vector<std::string>>(&cipherFileNames),
+             "Can be passed as positional arguments. If several files are given, each password is checked "
+             "against all of them and acceptable passwords are printed after file names.\n"
              "A binary file in the following format:\n"
              "  1. \t8 bytes field with initial value for CBC mode.\n"
              "  2. \tCiphertext, encrypted by 3DES(EDE2) algorithm with keys got from MD5 from the password.\n"
@@ -89,19 +359,39 @@ int main(int argc, char **argv)
         
         // We compile all types of options into a single one for easy printing help message.
         boost::program_options::options_description allOptions(
-            "Usage: test_problem [-h|--help] | [-p|--print-decrypted] CIPHERFILE\n"
-            "Guess the password of CIPHERFILE. The password guessed is in the form [a-zA-Z0-9]{3}.\n\n"
+            "Usage: test_problem [-h|--help] | [-p|--print-decrypted] [-c|--chunk-size SIZE] [--padding-prefilter]\n"
+            "                    [--known-prefix TEXT | --magic FORMAT] [--printable-prefix BYTES]\n"
+            "                    [--des-engine bitslice|per-key] [--crypto-backend auto|BACKEND|STAGE=BACKEND,...]\n"
+            "                    [--show-backends] [-w|--wordlist FILE] [-r|--rules FILE]\n"
+            "                    [-m|--mask MASK] [-1|-2|-3|-4 CHARSET] [--markov FILE]\n"
+            "                    [--min-len LENGTH] [--max-len LENGTH]\n"
+            "                    [--checkpoint FILE] [--checkpoint-interval SECONDS] [--resume]\n"
+            "                    [--threads N] [--pin-threads] [--stop-after N]\n"
+            "                    [--progress-interval SECONDS] [--status-file FILE]\n"
+            "                    [--shard I/N | --skip COUNT --limit COUNT] [--completion-record FILE]\n"
+            "                    [--merge-records FILE]... CIPHERFILE...\n"
+            "       test_problem --daemon SOCKET [--threads N] [--pin-threads]\n"
+            "       test_problem --client SOCKET [--priority P] [options of search]... CIPHERFILE...\n"
+            "       test_problem --train-markov FILE -w|--wordlist FILE [-r|--rules FILE]\n"
+            "       test_problem --generate FILE --generate-password PASSWORD [--generate-size SIZE]\n"
+            "                    [--generate-padding] [--generate-seed SEED] [--generate-count N]\n"
+            "Guess the password of each CIPHERFILE. The password guessed is a word of wordlist or is in the form\n"
+            "given by mask, by default it is [a-zA-Z0-9]{3}, optionally transformed by rules.\n\n"
             "All options");
+        std::string daemonSocketName, clientSocketName;
+        int priority;
+        mainOptions.add(getThreadOptions(threadsCount, pinThreads));
         allOptions.add(mainOptions);
+        allOptions.add(getDaemonOptions(daemonSocketName, clientSocketName, priority));
         allOptions.add(helpOptions);
         
         // Option CIPHERFILE can be (and even should be) used as positional.
         boost::program_options::positional_options_description positionalMainOptions;
-        positionalMainOptions.add("CIPHERFILE", 1);
+        positionalMainOptions.add("CIPHERFILE", -1);
         
         // First time parsing, we look only for help options, allowing unregistered options.
         boost::program_options::variables_map parsedOptions;
-        boost::program_options::store(boost::program_options::command_line_parser(argc, argv)
+        boost::program_options::store(boost::program_options::command_line_parser(arguments)
                                       .options(helpOptions).allow_unregistered().run(),
                                       parsedOptions);
         boost::program_options::notify(parsedOptions);
@@ -109,128 +399,792 @@ int main(int argc, char **argv)
         // Printing help message and exiting.
         if(parsedOptions.count("help"))
         {
-            std::cout << allOptions << std::endl;
-            std::exit(EXIT_SUCCESS);
+            context.output << allOptions << std::endl;
+            throw ProgramExit(EXIT_SUCCESS);
         }
         
         // Second time we look only for main options
         // (if help options have been found we should already exited the program).
-        boost::program_options::store(boost::program_options::command_line_parser(argc, argv)
+        boost::program_options::store(boost::program_options::command_line_parser(arguments)
                                       .options(mainOptions).positional(positionalMainOptions).run(),
                                       parsedOptions);
         boost::program_options::notify(parsedOptions);
+        
+        if(parsedOptions.count("shard") && (!parsedOptions["skip"].defaulted() || !parsedOptions["limit"].defaulted()))
+        {
+            throw boost::program_options::error("option '--shard' can't be used with '--skip' or '--limit'");
+        }
+        if(parsedOptions.count("known-prefix") && parsedOptions.count("magic"))
+        {
+            throw boost::program_options::error("option '--known-prefix' can't be used with '--magic'");
+        }
+        if(parsedOptions.count("markov") && parsedOptions.count("wordlist"))
+        {
+            throw boost::program_options::error("option '--markov' can't be used with '--wordlist'");
+        }
+        if(parsedOptions.count("train-markov") && !parsedOptions.count("wordlist"))
+        {
+            throw boost::program_options::error("option '--train-markov' requires option '--wordlist'");
+        }
+        if(parsedOptions.count("generate") && !parsedOptions.count("generate-password"))
+        {
+            throw boost::program_options::error("option '--generate' requires option '--generate-password'");
+        }
+        if(parsedOptions.count("generate") && generatedFilesCount == 0)
+        {
+            throw boost::program_options::error("option '--generate-count' must be positive");
+        }
+        if(parsedOptions.count("generate"))
+        {
+            try
+            {
+                generatedFileParameters.textSize = parseByteSize(generatedTextSize);
+            }
+            catch(const std::invalid_argument &)
+            {
+                throw boost::program_options::invalid_option_value(generatedTextSize);
+            }
+        }
+        // Cipher files are not needed only for training of Markov model and generation of cipher files.
+        if(cipherFileNames.empty() && !parsedOptions.count("train-markov") && !parsedOptions.count("generate"))
+        {
+            throw boost::program_options::required_option("CIPHERFILE");
+        }
     }
     catch(const boost::program_options::error &parsingProgramOptionsError)
     {
-        std::cerr << "ERROR: Failed parsing command line arguments." << std::endl;
-        std::cerr << parsingProgramOptionsError.what() << "." << std::endl;
-        std::exit(EXIT_FAILURE);
+        context.errors << "ERROR: Failed parsing command line arguments." << std::endl;
+        context.errors << parsingProgramOptionsError.what() << "." << std::endl;
+        throw ProgramExit(EXIT_FAILURE);
     }
 /*----------end of command line options parsing section----------*/
 
-    // Reading and parsing provided CIPHERFILE.
+    // Names of files are printed as given, while files are opened relative to working directory of the run
+    // (of client for jobs of daemon).
+    auto resolvePath = [&context](const std::string &fileName)
+    {
+        if(context.workingDirectory.empty())
+        {
+            return(fileName);
+        }
+        return(boost::filesystem::absolute(fileName, context.workingDirectory).string());
+    };
+
+    // Generation of synthetic cipher files for benchmarks and scale tests doesn't search anything.
+    if(!generatedFileName.empty())
+    {
+        if(context.estimateOnly)
+        {
+            context.estimatedSize = generatedFilesCount;
+            return(EXIT_SUCCESS);
+        }
+        // Partially written file is removed, when generation is interrupted (e.g. by signal or by daemon).
+        if(context.handleSignals)
+        {
+            std::signal(SIGINT, interruptSearch);
+            std::signal(SIGTERM, interruptSearch);
+        }
+        try
+        {
+            const std::vector<std::string> generatedFileNames =
+                generateCipherCorpus(resolvePath(generatedFileName), generatedFileParameters, generatedFilesCount,
+                                     &context.interrupted);
+            if(generatedFileNames.size() < generatedFilesCount)
+            {
+                context.errors << "WARNING: Generation is interrupted, " << generatedFileNames.size() << " of "
+                               << generatedFilesCount << " cipher files are generated." << std::endl;
+                return(EXIT_FAILURE);
+            }
+            context.output << "Generated " << generatedFilesCount << " cipher files starting with "
+                           << getCorpusFileName(generatedFileName, 0, generatedFilesCount) << "." << std::endl;
+        }
+        catch(const std::exception &error)
+        {
+            context.errors << "ERROR: Failed generating cipher file " << generatedFileName << "." << std::endl;
+            context.errors << error.what() << "." << std::endl;
+            throw ProgramExit(EXIT_FAILURE);
+        }
+        return(EXIT_SUCCESS);
+    }
+
+    // Constructing source of passwords: words of memory mapped wordlist or keyspace of passwords matching the mask,
+    // by default it is [a-zA-Z0-9]{3}. Both of them are index addressable, so we are able to split them into chunks,
+    // which threads of work stealing scheduler take, without any single thread producing passwords for others.
+    std::unique_ptr<CandidateSource> passwordCandidates;
+    if(!wordlistFileName.empty())
+    {
+        try
+        {
+            passwordCandidates.reset(new Wordlist(resolvePath(wordlistFileName)));
+        }
+        catch(const std::exception &error)
+        {
+            context.errors << "ERROR: Failed opening wordlist " << wordlistFileName << "." << std::endl;
+            context.errors << error.what() << "." << std::endl;
+            throw ProgramExit(EXIT_FAILURE);
+        }
+    }
+    else
+    {
+        // Markov model only orders characters of mask positions, so passwords stay index addressable.
+        std::unique_ptr<MarkovModel> markovModel;
+        if(!markovModelFileName.empty())
+        {
+            try
+            {
+                markovModel.reset(new MarkovModel(MarkovModel::load(resolvePath(markovModelFileName))));
+            }
+            catch(const std::exception &error)
+            {
+                context.errors << "ERROR: Failed reading Markov model " << markovModelFileName << "." << std::endl;
+                context.errors << error.what() << "." << std::endl;
+                throw ProgramExit(EXIT_FAILURE);
+            }
+        }
+        try
+        {
+            const std::vector<std::string> maskCharsets = parseMask(mask, customCharsets);
+            passwordCandidates.reset(new MaskKeyspace(maskCharsets,
+                                                      minLength != 0 ? minLength : maskCharsets.size(),
+                                                      maxLength != 0 ? maxLength : maskCharsets.size(),
+                                                      markovModel.get()));
+        }
+        catch(const std::exception &error)
+        {
+            context.errors << "ERROR: Failed constructing passwords from mask \"" << mask << "\"." << std::endl;
+            context.errors << error.what() << "." << std::endl;
+            throw ProgramExit(EXIT_FAILURE);
+        }
+    }
+    
+    // Rules are applied by each thread to candidates of its chunk, so base source is split between threads as usual.
+    if(!rulesFileName.empty())
+    {
+        std::vector<Rule> rules;
+        try
+        {
+            rules = loadRules(resolvePath(rulesFileName));
+        }
+        catch(const std::exception &error)
+        {
+            context.errors << "ERROR: Failed reading rules from " << rulesFileName << "." << std::endl;
+            context.errors << error.what() << "." << std::endl;
+            throw ProgramExit(EXIT_FAILURE);
+        }
+        passwordCandidates.reset(new RuledCandidateSource(std::move(passwordCandidates), std::move(rules)));
+    }
+    if(searchOptions.chunkSize == 0)
+    {
+        searchOptions.chunkSize = passwordCandidates->getDefaultChunkSize();
+    }
+    
+    // Training of Markov model is a separate run over candidates of wordlist, it doesn't search anything.
+    // Daemon trains in the job itself, not in its estimation.
+    if(!markovTrainingFileName.empty())
+    {
+        if(context.estimateOnly)
+        {
+            context.estimatedSize = passwordCandidates->size();
+            return(EXIT_SUCCESS);
+        }
+        try
+        {
+            MarkovModel markovModel;
+            const std::uint64_t wordsCount = markovModel.addCandidates(*passwordCandidates);
+            markovModel.save(resolvePath(markovTrainingFileName));
+            context.output << "Markov model is trained on " << wordsCount << " words and written into "
+                           << markovTrainingFileName << "." << std::endl;
+        }
+        catch(const std::exception &error)
+        {
+            context.errors << "ERROR: Failed training Markov model " << markovTrainingFileName << "." << std::endl;
+            context.errors << error.what() << "." << std::endl;
+            throw ProgramExit(EXIT_FAILURE);
+        }
+        return(EXIT_SUCCESS);
+    }
+    
+    // Reading and parsing provided CIPHERFILEs.
     const std::size_t initialValueSize = 8, shaCheckSumSize = 32;
-    ParsedFile parsedFile;
+    std::vector<SearchTarget> targets;
+    std::vector<ParsedFile> parsedFiles;
+    for(const std::string &cipherFileName: cipherFileNames)
+    {
+        try
+        {
+            parsedFiles.push_back(parseFile(resolvePath(cipherFileName), initialValueSize, shaCheckSumSize));
+        }
+        catch(const std::exception &error)
+        {
+            context.errors << "ERROR: Failed parsing given " << cipherFileName << " file." << std::endl;
+            context.errors << error.what() << "." << std::endl;
+            throw ProgramExit(EXIT_FAILURE);
+        }
+        targets.push_back({cipherFileName, parsedFiles.back(), targets.size()});
+    }
+    searchOptions.printFileNames = targets.size() > 1;
+    
+    // Different CPUs are fastest with different libraries, so backends of stages, which are not given
+    // in command line, are chosen by short calibration on texts of the size of the largest cipher file.
+    // Daemon calibrates once for each size of texts. Estimation of a job doesn't need backends at all.
     try
     {
-        parsedFile = parseFile(cipherFileName, initialValueSize, shaCheckSumSize);
+        if(requestedBackends.size() < 3 && !context.estimateOnly)
+        {
+            std::size_t textSize = 0;
+            for(const ParsedFile &parsedFile: parsedFiles)
+            {
+                textSize = std::max(textSize, parsedFile.contentSize);
+            }
+            if(context.calibratedBackends != nullptr && context.calibratedBackends->count(textSize))
+            {
+                searchOptions.cryptoBackends = context.calibratedBackends->at(textSize);
+            }
+            else
+            {
+                searchOptions.cryptoBackends = calibrateCryptoBackends(textSize,
+                                                                       showBackends ? &context.errors : nullptr);
+                if(context.calibratedBackends != nullptr)
+                {
+                    (*context.calibratedBackends)[textSize] = searchOptions.cryptoBackends;
+                }
+            }
+        }
     }
-    catch(const std::exception &error)
+    catch(const CryptoException &cryptoException)
     {
-        std::cerr << "ERROR: Failed parsing given " << cipherFileName << " file." << std::endl;
-        std::cerr << error.what() << "." << std::endl;
-        std::exit(EXIT_FAILURE);
+        context.errors << "ERROR: Failed calibrating cryptography backends." << std::endl;
+        context.errors << cryptoException.what() << std::endl;
+        throw ProgramExit(EXIT_FAILURE);
+    }
+    for(const auto &requestedBackend: requestedBackends)
+    {
+        CryptoBackend &stageBackend = requestedBackend.first == "md5" ? searchOptions.cryptoBackends.md5 :
+                                      requestedBackend.first == "3des" ? searchOptions.cryptoBackends.tripleDes :
+                                      searchOptions.cryptoBackends.sha256;
+        stageBackend = requestedBackend.second;
+    }
+    if(showBackends)
+    {
+        context.errors << "Crypto backends: " << searchOptions.cryptoBackends << std::endl;
+    }
+    
+    // Padding prefilter is possible only if ciphertexts of all files consist of whole blocks.
+    for(const SearchTarget &target: targets)
+    {
+        if(searchOptions.usePaddingPrefilter && !CheckPassword::isPaddingPrefilterApplicable(target.parsedFile))
+        {
+            context.errors << "WARNING: Ciphertext in " << target.fileName << " doesn't consist of whole blocks."
+                           << std::endl;
+            context.errors << "         Padding prefilter is disabled!" << std::endl;
+            searchOptions.usePaddingPrefilter = false;
+        }
+    }
+    
+    // Known beginning must fit into each ciphertext, otherwise no password could be acceptable for it.
+    searchOptions.plaintextFilter = PlaintextFilter(knownPrefix, printablePrefixSize);
+    for(const SearchTarget &target: targets)
+    {
+        if(!searchOptions.plaintextFilter.isEmpty() &&
+           !CheckPassword::isPlaintextFilterApplicable(target.parsedFile, searchOptions.plaintextFilter))
+        {
+            context.errors << "ERROR: Ciphertext in " << target.fileName << " doesn't consist of whole blocks "
+                           << "or is shorter than known beginning." << std::endl;
+            throw ProgramExit(EXIT_FAILURE);
+        }
     }
     
-    // Constructing allowed chars by joining following three ranges, we get [a-zA-Z0-9].
-    // NOTICE: We use nextChar function to have end including range.
-    //         This function increase char by 1, so applying it to the last char '\xf7' in ASCII chart will result
-    //         -128, because of the overflow, and it will probably break boost::irange,
-    //         as first argument will be greater than the second one.
-    auto allowedCharsForPasswordRange = join(boost::irange('a', nextChar('z')),
-                                             boost::irange('A', nextChar('Z')),
-                                             boost::irange('0', nextChar('9')));
-    
-    // Entering parallel section. Here we go with a single thread through foreach loop.
-    // We cant use omp for directive, because we iterate through forward traversal range.
-    // To exploit multithreading, we use tasks, for evaluating loop body.
-    #pragma omp parallel
-    #pragma omp single nowait
-    {
-        // Setting up cryptography algorithms. In the following for loop we will create tasks, to be evaluated by
-        // threads. Each thread need to use object of class CheckPassword, but such objects are not thread safe.
-        // To overcome such difficulty we create an collection with number of objects equaled to number of threads.
-        // Each thread use its identity as an index to get its object and work with it exclusively.
-        // NOTICE: Objects of CheckPassword class are not assignable, due to their inner structure.
-        //         They all store scoped_arrays and some constants. To allow to use multiple objects of that class
-        //         we have to store it in a collection, but it is problematic to store not assignable objects.
-        //         To overpass such difficulty we allocate all needed objects in a heap and store pointers to them in 
-        //         a special vector: boost::ptr_vector.
-        boost::ptr_vector<CheckPassword> ciphersForMultithread;
+    // Searched slice of candidate indices: a shard or a range given by skip and limit. Both are computed
+    // from indices only, so independent processes get disjoint slices without enumerating candidates before them.
+    KeyspaceIndex searchFirst = 0, searchLast = passwordCandidates->size();
+    if(shardsCount != 0)
+    {
+        std::tie(searchFirst, searchLast) = getShardRange(passwordCandidates->size(), shardIndex, shardsCount);
+    }
+    else
+    {
+        searchFirst = std::min<KeyspaceIndex>(skipCount, passwordCandidates->size());
+        if(limitCount != 0 && limitCount < searchLast - searchFirst)
+        {
+            searchLast = searchFirst + limitCount;
+        }
+    }
+    
+    // Daemon orders jobs by number of searched passwords before running them.
+    if(context.estimateOnly)
+    {
+        context.estimatedSize = searchLast - searchFirst;
+        return(EXIT_SUCCESS);
+    }
+    
+    // Checkpoint binds progress to the cipher file and passwords, so it is never applied to another search.
+    // Completion records of shards have the same format and binding, so they are merged in the same way.
+    Checkpoint currentSearch;
+    auto loadMatchingCheckpoint = [&context, &resolvePath, &currentSearch, &targets](const std::string &fileName)
+    {
+        Checkpoint savedCheckpoint;
         try
         {
-            for(int threadIndex = 0; threadIndex < omp_get_max_threads(); ++threadIndex)
+            savedCheckpoint = Checkpoint::load(resolvePath(fileName));
+        }
+        catch(const std::exception &error)
+        {
+            context.errors << "ERROR: Failed reading checkpoint " << fileName << "." << std::endl;
+            context.errors << error.what() << "." << std::endl;
+            throw ProgramExit(EXIT_FAILURE);
+        }
+        if(savedCheckpoint.filesHash != currentSearch.filesHash)
+        {
+            context.errors << "ERROR: Checkpoint " << fileName << " was saved for other cipher files." << std::endl;
+            throw ProgramExit(EXIT_FAILURE);
+        }
+        if(savedCheckpoint.candidatesDescription != currentSearch.candidatesDescription ||
+           savedCheckpoint.candidatesSize != currentSearch.candidatesSize)
+        {
+            context.errors << "ERROR: Checkpoint " << fileName << " was saved for other passwords "
+                           << "(mask, wordlist or rules)." << std::endl;
+            throw ProgramExit(EXIT_FAILURE);
+        }
+        if(savedCheckpoint.plaintextFilterDescription != currentSearch.plaintextFilterDescription)
+        {
+            context.errors << "ERROR: Checkpoint " << fileName << " was saved for other known beginning of texts."
+                           << std::endl;
+            throw ProgramExit(EXIT_FAILURE);
+        }
+        for(const AcceptablePassword &acceptablePassword: savedCheckpoint.acceptablePasswords)
+        {
+            if(acceptablePassword.target >= targets.size())
+            {
+                context.errors << "ERROR: Checkpoint " << fileName << " contains password of unknown cipher file."
+                               << std::endl;
+                throw ProgramExit(EXIT_FAILURE);
+            }
+        }
+        return(savedCheckpoint);
+    };
+    // Passwords found before are checked once more, so that decrypted text could be printed.
+    auto printSavedPasswords = [&context, &targets, &searchOptions]
+                               (const std::vector<AcceptablePassword> &acceptablePasswords)
+    {
+        for(const AcceptablePassword &acceptablePassword: acceptablePasswords)
+        {
+            const SearchTarget &target = targets[acceptablePassword.target];
+            CheckPassword checkPassword(target.parsedFile, false, PlaintextFilter(), searchOptions.cryptoBackends);
+            if(checkPassword.isPasswordAcceptable(acceptablePassword.password))
             {
-                ciphersForMultithread.push_back(new CheckPassword(parsedFile));
+                if(searchOptions.printFileNames)
+                {
+                    context.output << target.fileName << ":";
+                }
+                context.output << acceptablePassword.password << std::endl;
+                if(searchOptions.printDecryptedText)
+                {
+                    context.output << checkPassword.getDecryptedText() << std::endl;
+                }
             }
         }
+    };
+    
+    if(resumeSearch || !checkpointFileName.empty() || !completionRecordFileName.empty() ||
+       !mergedRecordFileNames.empty())
+    {
+        try
+        {
+            currentSearch.filesHash = computeFilesHash(parsedFiles);
+        }
         catch(const GcryException &gcryException)
         {
-            std::cerr << "ERROR: Failed in initializing libgcrypt." << std::endl;
-            std::cerr << gcryException.what() << std::endl;
-            std::exit(EXIT_FAILURE);
+            context.errors << "ERROR: Failed computing hash of cipher files." << std::endl;
+            context.errors << gcryException.what() << std::endl;
+            throw ProgramExit(EXIT_FAILURE);
+        }
+        currentSearch.candidatesDescription = passwordCandidates->getDescription();
+        currentSearch.candidatesSize = passwordCandidates->size();
+        currentSearch.usePaddingPrefilter = searchOptions.usePaddingPrefilter;
+        currentSearch.plaintextFilterDescription = searchOptions.plaintextFilter.getDescription();
+    }
+    
+    // Merging completion records of shards: found passwords are printed and indices, which are not covered
+    // by any record, are reported. Nothing is searched.
+    if(!mergedRecordFileNames.empty())
+    {
+        Checkpoint mergedRecords = currentSearch;
+        for(const std::string &recordFileName: mergedRecordFileNames)
+        {
+            const Checkpoint record = loadMatchingCheckpoint(recordFileName);
+            for(const auto &range: record.completed.getRanges())
+            {
+                mergedRecords.completed.add(range.first, range.second);
+            }
+            for(const AcceptablePassword &acceptablePassword: record.acceptablePasswords)
+            {
+                if(std::find(mergedRecords.acceptablePasswords.begin(), mergedRecords.acceptablePasswords.end(),
+                             acceptablePassword) == mergedRecords.acceptablePasswords.end())
+                {
+                    mergedRecords.acceptablePasswords.push_back(acceptablePassword);
+                }
+            }
+        }
+        printSavedPasswords(mergedRecords.acceptablePasswords);
+        
+        const auto missingRanges = mergedRecords.completed.getMissing(0, passwordCandidates->size());
+        if(!missingRanges.empty())
+        {
+            context.errors << "WARNING: Records don't cover passwords with indices";
+            for(const auto &range: missingRanges)
+            {
+                context.errors << " [" << range.first << ", " << range.second << ")";
+            }
+            context.errors << "." << std::endl;
+            return(EXIT_FAILURE);
+        }
+        return(EXIT_SUCCESS);
+    }
+    
+    // On resume, passwords found before are printed again and the search continues with the pass it was
+    // interrupted in (with or without padding prefilter). Without checkpoint file progress is only collected:
+    // found passwords show targets, which need the pass without padding prefilter, and suppress passwords found
+    // twice, and completed ranges are written into completion record.
+    const bool isPaddingPrefilterRequested = searchOptions.usePaddingPrefilter;
+    if(checkpointFileName.empty() && resumeSearch)
+    {
+        checkpointFileName = cipherFileNames.front() + ".checkpoint";
+    }
+    Checkpoint checkpoint = currentSearch;
+    if(resumeSearch)
+    {
+        checkpoint = loadMatchingCheckpoint(checkpointFileName);
+        searchOptions.usePaddingPrefilter = checkpoint.usePaddingPrefilter;
+        printSavedPasswords(checkpoint.acceptablePasswords);
+    }
+    else if(!checkpointFileName.empty() && boost::filesystem::exists(resolvePath(checkpointFileName)))
+    {
+        context.errors << "ERROR: Checkpoint " << checkpointFileName << " already exists." << std::endl;
+        context.errors << "       Use --resume to continue the search saved in it or remove it." << std::endl;
+        throw ProgramExit(EXIT_FAILURE);
+    }
+    
+    CheckpointRecorder checkpointRecorder(checkpoint, checkpointFileName.empty() ? "" : resolvePath(checkpointFileName),
+                                          std::chrono::seconds(checkpointInterval));
+    if(!checkpointFileName.empty() && context.handleSignals)
+    {
+        std::signal(SIGINT, interruptSearch);
+        std::signal(SIGTERM, interruptSearch);
+    }
+    
+    // Returns targets, for which no password has been found yet.
+    auto getTargetsWithoutPasswords = [&targets, &checkpointRecorder]()
+    {
+        const std::vector<AcceptablePassword> acceptablePasswords =
+            checkpointRecorder.getCheckpoint().acceptablePasswords;
+        std::vector<SearchTarget> remainingTargets;
+        for(const SearchTarget &target: targets)
+        {
+            if(std::none_of(acceptablePasswords.begin(), acceptablePasswords.end(),
+                            [&target](const AcceptablePassword &acceptablePassword)
+                            {
+                                return(acceptablePassword.target == target.index);
+                            }))
+            {
+                remainingTargets.push_back(target);
+            }
+        }
+        return(remainingTargets);
+    };
+    
+    // Daemon runs jobs on its warm threads, otherwise threads are created for this run.
+    std::unique_ptr<WorkStealingScheduler> ownScheduler;
+    if(context.scheduler == nullptr)
+    {
+        ownScheduler.reset(new WorkStealingScheduler(getThreadsCount(threadsCount), pinThreads));
+    }
+    WorkStealingScheduler &scheduler = context.scheduler != nullptr ? *context.scheduler : *ownScheduler;
+    
+    // Candidates are split into chunks of consecutive indices. Each thread starts with a contiguous range
+    // of chunks and steals halves of ranges of others, when it has finished its own, so the load is balanced,
+    // while scheduling overhead is paid once per chunk.
+    // Only the searched slice is split and with checkpoint only parts of chunks, which were not completed before,
+    // are processed.
+    auto searchPasswords = [&context, &passwordCandidates, &checkpointRecorder, &scheduler, searchFirst, searchLast,
+                            progressInterval, &statusFileName, &resolvePath]
+                           (const std::vector<SearchTarget> &searchedTargets, const SearchOptions &searchOptions)
+    {
+        const KeyspaceIndex chunksCount = (searchLast - searchFirst + searchOptions.chunkSize - 1) /
+                                          searchOptions.chunkSize;
+        const KeyspaceRanges completedRanges = checkpointRecorder.getCheckpoint().completed;
+        
+        // Threads count their progress, which is aggregated and reported by a separate thread.
+        std::unique_ptr<ProgressReporter> progressReporter;
+        if(progressInterval != 0 || !statusFileName.empty())
+        {
+            KeyspaceIndex missingIndices = 0;
+            for(const auto &range: completedRanges.getMissing(searchFirst, searchLast))
+            {
+                missingIndices += range.second - range.first;
+            }
+            progressReporter.reset(new ProgressReporter(scheduler.getThreadsCount(), searchLast - searchFirst,
+                                                        searchLast - searchFirst - missingIndices,
+                                                        std::chrono::seconds(progressInterval != 0 ?
+                                                                             progressInterval : 10),
+                                                        progressInterval != 0 ? &context.errors : nullptr,
+                                                        statusFileName.empty() ? "" :
+                                                        resolvePath(statusFileName)));
+            progressReporter->start();
         }
         
-        // Iterating through all possible passwords of fixed size.
-        const int passwordLength = 3;
-       
-        for(auto passwordInVector: CartesianPowerRange(allowedCharsForPasswordRange, passwordLength))
-        {
-            #pragma omp task
-            {
-                // Transform our picked password into a string and, if it acceptable, print it.
-                std::string password(passwordInVector.begin(), passwordInVector.end());
-                // Using thread identity to get a reference to CheckPassword object
-                // and use it exclusively (each thread works with different objects)
-                auto &checkPassword = ciphersForMultithread[omp_get_thread_num()];
-                bool isPasswordAcceptable;
+        // Acceptable passwords are printed by output thread of the channel, which also tells workers to stop,
+        // when enough of them are found.
+        ResultChannel resultChannel(searchedTargets, searchOptions, context.output);
+        
+        // Failure of a thread stops others at their next chunk and is reported once, after all of them have finished.
+        std::atomic<bool> workerFailed(false);
+        try
+        {
+            scheduler.run(chunksCount, [&](std::size_t threadIndex, WorkStealingScheduler::Tasks &tasks)
+            {
+                ThreadProgress *threadProgress = nullptr;
+                if(progressReporter)
+                {
+                    threadProgress = &progressReporter->getThreadProgress(threadIndex);
+                }
+                
+                // Each thread need to use its own object of class CheckPassword, because such objects are not
+                // thread safe. Constructing them in the thread (after it is pinned) makes each thread to allocate
+                // and own its buffers on its NUMA node, and use them for all chunks it processes.
+                std::unique_ptr<SearchWorker> searchWorker;
                 try
                 {
-                    isPasswordAcceptable = checkPassword.isPasswordAcceptable(password);
+                    searchWorker.reset(new SearchWorker(searchedTargets, *passwordCandidates, searchOptions,
+                                                        resultChannel, &checkpointRecorder, threadProgress));
                 }
-                catch(const GcryException &gcryException)
+                catch(...)
                 {
-                    // If something went wring in cryptography algorithms, we just skip this picked password
-                    // and print this warning.
-                    std::cerr << "WARNING: Processing password \"" << password 
-                              << "\" some exceptions appeared." << std::endl;
-                    std::cerr << "         Skipping current password!" << std::endl;
-                    std::cerr << gcryException.what() << std::endl;
-                    isPasswordAcceptable = false;
+                    workerFailed = true;
+                    throw;
                 }
                 
-                // We print all acceptable passwords, even if there would be multiple of them.
-                // Such may happened, if different decrypted messages have SHA256 collision.
-                if(isPasswordAcceptable)
+                // After interruption or cancellation the remaining chunks are not taken.
+                KeyspaceIndex chunkIndex;
+                while(!context.interrupted && !workerFailed && !resultChannel.isCancelled() &&
+                      tasks.next(chunkIndex))
                 {
-                    // Putting printing into critical section will make output clear, and wouldn't mess up
-                    // output of different threads.
-                    #pragma omp critical
+                    const KeyspaceIndex first = searchFirst + chunkIndex * searchOptions.chunkSize;
+                    const KeyspaceIndex last = std::min<KeyspaceIndex>(first + searchOptions.chunkSize, searchLast);
+                    for(const auto &range: completedRanges.getMissing(first, last))
                     {
-                        std::cout << password << std::endl;
-                        
-                        // Print decrypted text if needed
-                        if(printDecryptedText)
-                        {
-                            std::cout << checkPassword.getDecryptedText() << std::endl;
-                        }
+                        searchWorker->processChunk(range.first, range.second);
                     }
                 }
-            }
+            });
+        }
+        catch(const CryptoException &cryptoException)
+        {
+            context.errors << "ERROR: Failed in initializing cryptography backends." << std::endl;
+            context.errors << cryptoException.what() << std::endl;
+            throw ProgramExit(EXIT_FAILURE);
+        }
+    };
+    
+    // Saves progress, if search is checkpointed. Failure is not fatal, as passwords are already printed.
+    auto saveCheckpoint = [&context, &checkpointRecorder, &checkpointFileName]()
+    {
+        if(checkpointFileName.empty())
+        {
+            return;
+        }
+        try
+        {
+            checkpointRecorder.save();
+        }
+        catch(const std::exception &error)
+        {
+            context.errors << "WARNING: Failed saving checkpoint " << checkpointFileName << "." << std::endl;
+            context.errors << "         " << error.what() << "." << std::endl;
+        }
+    };
+    
+    // Resumed pass without requested padding prefilter is the fallback pass, which searches only targets,
+    // for which nothing was found with prefilter.
+    if(isPaddingPrefilterRequested && !searchOptions.usePaddingPrefilter)
+    {
+        searchPasswords(getTargetsWithoutPasswords(), searchOptions);
+    }
+    else
+    {
+        searchPasswords(targets, searchOptions);
+    }
+    
+    // If nothing was found with padding prefilter for some files, they are probably not padded with PKCS#5/7,
+    // so we fall back to the full check of all passwords for them.
+    const std::vector<SearchTarget> remainingTargets = getTargetsWithoutPasswords();
+    if(searchOptions.usePaddingPrefilter && !remainingTargets.empty() && !context.interrupted)
+    {
+        for(const SearchTarget &target: remainingTargets)
+        {
+            context.errors << "WARNING: No password gives PKCS#5/7 padded text, " << target.fileName
+                           << " is probably not padded." << std::endl;
+        }
+        context.errors << "         Repeating search without padding prefilter!" << std::endl;
+        searchOptions.usePaddingPrefilter = false;
+        checkpointRecorder.restartWithoutPaddingPrefilter();
+        searchPasswords(remainingTargets, searchOptions);
+    }
+    saveCheckpoint();
+    
+    // Job of daemon could be interrupted without checkpoint, e.g. when daemon is stopped.
+    if(context.interrupted && checkpointFileName.empty())
+    {
+        context.errors << "WARNING: Search is interrupted." << std::endl;
+        return(EXIT_FAILURE);
+    }
+    if(context.interrupted)
+    {
+        context.errors << "WARNING: Search is interrupted, its progress is saved into " << checkpointFileName << "."
+                       << std::endl;
+        context.errors << "         Run with --resume to continue it!" << std::endl;
+        return(EXIT_FAILURE);
+    }
+    
+    // Completion record is written only for the whole slice, so merged records never cover unchecked passwords.
+    if(!completionRecordFileName.empty())
+    {
+        try
+        {
+            checkpointRecorder.getCheckpoint().save(resolvePath(completionRecordFileName));
+        }
+        catch(const std::exception &error)
+        {
+            context.errors << "ERROR: Failed writing completion record " << completionRecordFileName << "."
+                           << std::endl;
+            context.errors << error.what() << "." << std::endl;
+            throw ProgramExit(EXIT_FAILURE);
         }
-        
-        #pragma omp taskwait
     }
 
-    return 0;
+    return(EXIT_SUCCESS);
+}
+
+}
+
+int main(int argc, char **argv)
+{
+/*----------start of libgcrypt initialization section----------*/
+
+    // Version check should be the very first call because it
+    // makes sure that important subsystems are initialized.
+    if(!gcry_check_version (GCRYPT_VERSION))
+    {
+        std::cerr << "ERROR: Can't initialize libgcrypt. Version mismatch." << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+
+    // Disable secure memory.
+    try
+    {
+        processGcryError(gcry_control(GCRYCTL_DISABLE_SECMEM, 0));
+    }
+    catch(const GcryException &gcryException)
+    {
+        std::cerr << "WARNING: Disabling secure memory failed." << std::endl;
+    }
+
+    // Tell Libgcrypt that initialization has completed.
+    try
+    {
+        processGcryError(gcry_control (GCRYCTL_INITIALIZATION_FINISHED, 0));
+    }
+    catch(const GcryException &gcryException)
+    {
+        std::cerr << "ERROR: Can't initialize libgcrypt." << std::endl;
+        std::cerr << gcryException.what() << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+/*----------end of libgcrypt initialization section----------*/
+
+
+    const std::vector<std::string> arguments(argv + 1, argv + argc);
+    
+    // Options of daemon are looked for first: daemon accepts only thread options besides its socket,
+    // while client sends all other options to daemon as they are.
+    std::string daemonSocketName, clientSocketName;
+    int priority;
+    std::size_t threadsCount;
+    bool pinThreads;
+    std::vector<std::string> jobArguments;
+    try
+    {
+        // Parsed options refer to descriptions, so they are kept until options are stored.
+        const boost::program_options::options_description daemonOptions =
+            getDaemonOptions(daemonSocketName, clientSocketName, priority);
+        const boost::program_options::options_description threadOptions = getThreadOptions(threadsCount, pinThreads);
+        boost::program_options::variables_map parsedOptions;
+        const boost::program_options::parsed_options parsedDaemonOptions =
+            boost::program_options::command_line_parser(arguments).options(daemonOptions).allow_unregistered().run();
+        boost::program_options::store(parsedDaemonOptions, parsedOptions);
+        boost::program_options::notify(parsedOptions);
+        jobArguments = boost::program_options::collect_unrecognized(parsedDaemonOptions.options,
+                                                                    boost::program_options::include_positional);
+        if(parsedOptions.count("daemon") && parsedOptions.count("client"))
+        {
+            throw boost::program_options::error("option '--daemon' can't be used with '--client'");
+        }
+        if(parsedOptions.count("daemon"))
+        {
+            boost::program_options::store(boost::program_options::command_line_parser(jobArguments)
+                                          .options(threadOptions).run(),
+                                          parsedOptions);
+            boost::program_options::notify(parsedOptions);
+        }
+    }
+    catch(const boost::program_options::error &parsingProgramOptionsError)
+    {
+        std::cerr << "ERROR: Failed parsing command line arguments." << std::endl;
+        std::cerr << parsingProgramOptionsError.what() << "." << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+    
+    // Daemon keeps its threads and calibrated backends for all jobs, until it is stopped by SIGINT or SIGTERM.
+    if(!daemonSocketName.empty())
+    {
+        std::signal(SIGINT, interruptSearch);
+        std::signal(SIGTERM, interruptSearch);
+        WorkStealingScheduler scheduler(getThreadsCount(threadsCount), pinThreads);
+        try
+        {
+            DaemonServer daemonServer(daemonSocketName, scheduler, runProgram);
+            daemonServer.run(searchInterrupted);
+        }
+        catch(const std::exception &error)
+        {
+            std::cerr << "ERROR: Failed running daemon on " << daemonSocketName << "." << std::endl;
+            std::cerr << error.what() << "." << std::endl;
+            std::exit(EXIT_FAILURE);
+        }
+        return(EXIT_SUCCESS);
+    }
+    
+    if(!clientSocketName.empty())
+    {
+        try
+        {
+            return(runDaemonJob(clientSocketName, priority, jobArguments, std::cout, std::cerr));
+        }
+        catch(const std::exception &error)
+        {
+            std::cerr << "ERROR: Failed running job on daemon " << clientSocketName << "." << std::endl;
+            std::cerr << error.what() << "." << std::endl;
+            std::exit(EXIT_FAILURE);
+        }
+    }
+    
+    ProgramContext context(std::cout, std::cerr, searchInterrupted);
+    context.handleSignals = true;
+    try
+    {
+        return(runProgram(arguments, context));
+    }
+    catch(const ProgramExit &programExit)
+    {
+        return(programExit.getExitCode());
+    }
 }
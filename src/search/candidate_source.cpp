@@ -0,0 +1,92 @@
+#include "candidate_source.h"
+
+#include <algorithm>
+
+CandidateBatch::CandidateBatch(std::size_t capacity, std::size_t stride):
+    capacity(capacity), stride(stride), arena(),
+    storage(nullptr), candidates(nullptr), lengths(nullptr),
+    count(0)
+{
+    arena.reset(ScratchArena::getArraySize<unsigned char>(capacity * stride) +
+                ScratchArena::getArraySize<const unsigned char *>(capacity) +
+                ScratchArena::getArraySize<std::size_t>(capacity));
+    storage = arena.allocate<unsigned char>(capacity * stride);
+    candidates = arena.allocate<const unsigned char *>(capacity);
+    lengths = arena.allocate<std::size_t>(capacity);
+}
+
+std::size_t CandidateBatch::size() const
+{
+    return(count);
+}
+
+bool CandidateBatch::full() const
+{
+    return(count == capacity);
+}
+
+void CandidateBatch::clear()
+{
+    count = 0;
+}
+
+std::size_t CandidateBatch::getCapacity() const
+{
+    return(capacity);
+}
+
+std::size_t CandidateBatch::getStride() const
+{
+    return(stride);
+}
+
+unsigned char *CandidateBatch::getSlot()
+{
+    return(storage + count * stride);
+}
+
+void CandidateBatch::push(const unsigned char *candidate, std::size_t length)
+{
+    candidates[count] = candidate;
+    lengths[count] = length;
+    ++count;
+}
+
+std::size_t CandidateBatch::getFreeSlotsCount() const
+{
+    return(capacity - count);
+}
+
+void CandidateBatch::pushSlots(std::size_t count, std::size_t length)
+{
+    for(std::size_t index = 0; index < count; ++index)
+    {
+        candidates[this->count + index] = storage + (this->count + index) * stride;
+        lengths[this->count + index] = length;
+    }
+    this->count += count;
+}
+
+boost::string_view CandidateBatch::operator[](std::size_t index) const
+{
+    return(boost::string_view(reinterpret_cast<const char *>(candidates[index]), lengths[index]));
+}
+
+const unsigned char *const *CandidateBatch::getCandidates() const
+{
+    return(candidates);
+}
+
+const std::size_t *CandidateBatch::getLengths() const
+{
+    return(lengths);
+}
+
+std::pair<KeyspaceIndex, KeyspaceIndex> getShardRange(KeyspaceIndex size, KeyspaceIndex shardIndex,
+                                                      KeyspaceIndex shardsCount)
+{
+    // The first size % shardsCount shards are one index longer, computing bounds this way never overflows.
+    const KeyspaceIndex shardSize = size / shardsCount, longShardsCount = size % shardsCount;
+    const KeyspaceIndex first = shardIndex * shardSize + std::min(shardIndex, longShardsCount);
+    return(std::make_pair(first, first + shardSize + (shardIndex < longShardsCount ? 1 : 0)));
+}
@@ -0,0 +1,140 @@
+#ifndef CANDIDATE_SOURCE_H
+#define CANDIDATE_SOURCE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+#include <boost/utility/string_view.hpp>
+
+#include "../util/scratch_arena.h"
+
+/**
+ * Index of a candidate in a candidate source. 64 bits are enough for any keyspace we are able to enumerate.
+ */
+typedef std::uint64_t KeyspaceIndex;
+
+/**
+ * class CandidateBatch is a reusable batch of password candidates, which are checked at once.
+ * Candidates are kept string_view like as pointers with lengths: generated candidates are written into
+ * storage of the batch (fixed stride slot per candidate), while candidates, which already exist in memory
+ * (e.g. words of memory mapped wordlist), are referenced without copying.
+ * Storage, pointers and lengths are arrays of arena of the batch, each of them starts at a cache line,
+ * so batches of different workers never share a line.
+ */
+class CandidateBatch
+{
+private:
+    const std::size_t capacity, stride;
+    ScratchArena arena;
+    unsigned char *storage;
+    const unsigned char **candidates;
+    std::size_t *lengths;
+    std::size_t count;
+
+public:
+    /**
+     * Creates a batch of at most capacity candidates, generated ones could be up to stride characters long.
+     */
+    CandidateBatch(std::size_t capacity, std::size_t stride);
+
+    // Arrays point into arena of the batch, so it can't be copied.
+    CandidateBatch(const CandidateBatch &) = delete;
+    CandidateBatch &operator=(const CandidateBatch &) = delete;
+
+    std::size_t size() const;
+    bool full() const;
+    void clear();
+
+    std::size_t getCapacity() const;
+    std::size_t getStride() const;
+
+    /**
+     * Returns storage slot of the next candidate, which is added by push(getSlot(), length).
+     */
+    unsigned char *getSlot();
+
+    /**
+     * Adds candidate, which stays valid until the batch is checked. Batch must not be full.
+     */
+    void push(const unsigned char *candidate, std::size_t length);
+
+    std::size_t getFreeSlotsCount() const;
+
+    /**
+     * Adds count candidates of the same length, which have been written into consecutive storage slots
+     * starting from getSlot(). Count must not exceed getFreeSlotsCount(). Generators fill the batch this way
+     * without a call per candidate.
+     */
+    void pushSlots(std::size_t count, std::size_t length);
+
+    boost::string_view operator[](std::size_t index) const;
+
+    const unsigned char *const *getCandidates() const;
+    const std::size_t *getLengths() const;
+};
+
+/**
+ * class CandidateCursor enumerates candidates of some part of CandidateSource into batches.
+ * Cursors are not thread safe, each thread should use its own one.
+ */
+class CandidateCursor
+{
+public:
+    virtual ~CandidateCursor() = default;
+
+    /**
+     * Positions cursor at the beginning of part of candidate source with indices [first, last).
+     */
+    virtual void seek(KeyspaceIndex first, KeyspaceIndex last) = 0;
+
+    /**
+     * Appends candidates of the current part into batch until it is full. Returns false, if the part is exhausted.
+     */
+    virtual bool fill(CandidateBatch &batch) = 0;
+};
+
+/**
+ * class CandidateSource is an index addressable source of password candidates. Indices [0, size()) could be
+ * split into contiguous parts processed independently by different threads, but unlike keyspace an index does not
+ * have to address exactly one candidate: e.g. indices of wordlist are byte offsets in it.
+ */
+class CandidateSource
+{
+public:
+    virtual ~CandidateSource() = default;
+
+    virtual KeyspaceIndex size() const = 0;
+
+    /**
+     * Returns maximal length of candidates, which are generated into storage of batch.
+     */
+    virtual std::size_t getMaxLength() const = 0;
+
+    /**
+     * Returns number of indices in a part, which is worth to be processed by a thread at once.
+     */
+    virtual KeyspaceIndex getDefaultChunkSize() const = 0;
+
+    /**
+     * Returns description, which identifies candidates and their indices: sources with equal descriptions
+     * produce the same candidates for the same indices. It is used to check, that a saved progress of search
+     * belongs to the same attack.
+     */
+    virtual std::string getDescription() const = 0;
+
+    virtual std::unique_ptr<CandidateCursor> cursor() const = 0;
+};
+
+/**
+ * Returns range [first, last) of shard shardIndex (counted from 0) of shardsCount contiguous shards of indices
+ * [0, size), sizes of which differ at most by one. Shards are computed from size only, so that independent
+ * processes get disjoint slices covering the whole candidate source.
+ */
+std::pair<KeyspaceIndex, KeyspaceIndex> getShardRange(KeyspaceIndex size, KeyspaceIndex shardIndex,
+                                                      KeyspaceIndex shardsCount);
+
+#endif
@@ -0,0 +1,348 @@
+#include "checkpoint.h"
+
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <sstream>
+#include <iterator>
+#include <stdexcept>
+#include <cstdio>
+#include <cstdint>
+
+#include <gcrypt.h>
+
+#include "../util/gcry_exception.h"
+
+namespace
+{
+
+const char checkpointHeader[] = "test_problem-checkpoint 2";
+
+std::string encodeHex(const unsigned char *data, std::size_t size)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string encoded;
+    for(std::size_t index = 0; index < size; ++index)
+    {
+        encoded.push_back(digits[data[index] >> 4]);
+        encoded.push_back(digits[data[index] & 0xf]);
+    }
+    return(encoded);
+}
+
+std::string encodeHex(const std::string &text)
+{
+    return(encodeHex(reinterpret_cast<const unsigned char *>(text.data()), text.size()));
+}
+
+int decodeHexDigit(char digit)
+{
+    if(digit >= '0' && digit <= '9')
+    {
+        return(digit - '0');
+    }
+    if(digit >= 'a' && digit <= 'f')
+    {
+        return(digit - 'a' + 10);
+    }
+    throw std::runtime_error(std::string("Invalid hex digit '") + digit + "'");
+}
+
+std::string decodeHex(const std::string &encoded)
+{
+    if(encoded.size() % 2 != 0)
+    {
+        throw std::runtime_error("Hex string \"" + encoded + "\" has odd length");
+    }
+    std::string text;
+    for(std::size_t index = 0; index < encoded.size(); index += 2)
+    {
+        text.push_back(static_cast<char>(decodeHexDigit(encoded[index]) * 16 + decodeHexDigit(encoded[index + 1])));
+    }
+    return(text);
+}
+
+/**
+ * Reads line "key values..." and returns its values. Throws std::runtime_error if line has another key.
+ */
+std::istringstream readField(std::istream &input, const std::string &key)
+{
+    std::string line;
+    if(!std::getline(input, line) || line.compare(0, key.size() + 1, key + " ") != 0)
+    {
+        throw std::runtime_error("Expected field \"" + key + "\"");
+    }
+    return(std::istringstream(line.substr(key.size() + 1)));
+}
+
+template<typename T>
+T readValue(std::istream &input, const std::string &key)
+{
+    T value;
+    std::istringstream values = readField(input, key);
+    if(!(values >> value) || !(values >> std::ws).eof())
+    {
+        throw std::runtime_error("Invalid value of field \"" + key + "\"");
+    }
+    return(value);
+}
+
+}
+
+bool AcceptablePassword::operator==(const AcceptablePassword &other) const
+{
+    return(target == other.target && password == other.password);
+}
+
+void KeyspaceRanges::add(KeyspaceIndex first, KeyspaceIndex last)
+{
+    if(first >= last)
+    {
+        return;
+    }
+
+    // Range, which starts before or at first, is merged with the new one, if they overlap or touch.
+    auto range = ranges.upper_bound(first);
+    if(range != ranges.begin() && std::prev(range)->second >= first)
+    {
+        --range;
+        first = range->first;
+        last = std::max(last, range->second);
+        range = ranges.erase(range);
+    }
+    // And so are all ranges, which start inside the new one or right after it.
+    while(range != ranges.end() && range->first <= last)
+    {
+        last = std::max(last, range->second);
+        range = ranges.erase(range);
+    }
+    ranges.emplace_hint(range, first, last);
+}
+
+std::vector<std::pair<KeyspaceIndex, KeyspaceIndex>> KeyspaceRanges::getMissing(KeyspaceIndex first,
+                                                                                KeyspaceIndex last) const
+{
+    std::vector<std::pair<KeyspaceIndex, KeyspaceIndex>> missing;
+    auto range = ranges.upper_bound(first);
+    if(range != ranges.begin() && std::prev(range)->second > first)
+    {
+        first = std::prev(range)->second;
+    }
+    for(; range != ranges.end() && range->first < last && first < last; ++range)
+    {
+        if(first < range->first)
+        {
+            missing.emplace_back(first, range->first);
+        }
+        first = std::max(first, range->second);
+    }
+    if(first < last)
+    {
+        missing.emplace_back(first, last);
+    }
+    return(missing);
+}
+
+KeyspaceIndex KeyspaceRanges::count() const
+{
+    KeyspaceIndex total = 0;
+    for(const auto &range: ranges)
+    {
+        total += range.second - range.first;
+    }
+    return(total);
+}
+
+std::vector<std::pair<KeyspaceIndex, KeyspaceIndex>> KeyspaceRanges::getRanges() const
+{
+    return(std::vector<std::pair<KeyspaceIndex, KeyspaceIndex>>(ranges.begin(), ranges.end()));
+}
+
+void KeyspaceRanges::clear()
+{
+    ranges.clear();
+}
+
+void Checkpoint::save(const std::string &fileName) const
+{
+    const std::string temporaryFileName = fileName + ".tmp";
+    {
+        std::ofstream output(temporaryFileName, std::ios_base::binary | std::ios_base::trunc);
+        output << checkpointHeader << "\n";
+        output << "files-sha256 " << filesHash << "\n";
+        output << "candidates " << encodeHex(candidatesDescription) << "\n";
+        output << "size " << candidatesSize << "\n";
+        output << "padding-prefilter " << (usePaddingPrefilter ? 1 : 0) << "\n";
+        output << "plaintext-filter " << encodeHex(plaintextFilterDescription) << "\n";
+        output << "completed";
+        for(const auto &range: completed.getRanges())
+        {
+            output << " " << range.first << " " << range.second;
+        }
+        output << "\n";
+        for(const AcceptablePassword &acceptablePassword: acceptablePasswords)
+        {
+            output << "found " << acceptablePassword.target << " " << encodeHex(acceptablePassword.password) << "\n";
+        }
+        output.flush();
+        if(!output)
+        {
+            throw std::runtime_error("Can't write checkpoint into " + temporaryFileName);
+        }
+    }
+
+    // Rename replaces the old checkpoint at once, so interrupted saving never leaves a partially written one.
+    if(std::rename(temporaryFileName.c_str(), fileName.c_str()) != 0)
+    {
+        std::remove(temporaryFileName.c_str());
+        throw std::runtime_error("Can't replace checkpoint " + fileName);
+    }
+}
+
+Checkpoint Checkpoint::load(const std::string &fileName)
+{
+    std::ifstream input(fileName, std::ios_base::binary);
+    if(!input)
+    {
+        throw std::runtime_error("Can't open checkpoint " + fileName);
+    }
+
+    try
+    {
+        std::string header;
+        if(!std::getline(input, header) || header != checkpointHeader)
+        {
+            throw std::runtime_error("Unknown format");
+        }
+
+        Checkpoint checkpoint;
+        checkpoint.filesHash = readValue<std::string>(input, "files-sha256");
+        checkpoint.candidatesDescription = decodeHex(readValue<std::string>(input, "candidates"));
+        checkpoint.candidatesSize = readValue<KeyspaceIndex>(input, "size");
+        checkpoint.usePaddingPrefilter = readValue<int>(input, "padding-prefilter") != 0;
+        checkpoint.plaintextFilterDescription = decodeHex(readValue<std::string>(input, "plaintext-filter"));
+
+        std::string line;
+        if(!std::getline(input, line) || line.compare(0, 9, "completed") != 0)
+        {
+            throw std::runtime_error("Expected field \"completed\"");
+        }
+        std::istringstream rangesInput(line.substr(9));
+        const std::vector<KeyspaceIndex> ranges((std::istream_iterator<KeyspaceIndex>(rangesInput)),
+                                                std::istream_iterator<KeyspaceIndex>());
+        if(!rangesInput.eof() || ranges.size() % 2 != 0)
+        {
+            throw std::runtime_error("Invalid value of field \"completed\"");
+        }
+        for(std::size_t index = 0; index < ranges.size(); index += 2)
+        {
+            if(ranges[index] >= ranges[index + 1] || ranges[index + 1] > checkpoint.candidatesSize)
+            {
+                throw std::runtime_error("Invalid completed range");
+            }
+            checkpoint.completed.add(ranges[index], ranges[index + 1]);
+        }
+
+        // Password could be empty (e.g. produced by rule), so its hex is optional.
+        while(input.peek() != std::ifstream::traits_type::eof())
+        {
+            AcceptablePassword acceptablePassword;
+            std::istringstream values = readField(input, "found");
+            if(!(values >> acceptablePassword.target))
+            {
+                throw std::runtime_error("Invalid value of field \"found\"");
+            }
+            std::string encodedPassword;
+            values >> encodedPassword;
+            acceptablePassword.password = decodeHex(encodedPassword);
+            checkpoint.acceptablePasswords.push_back(acceptablePassword);
+        }
+        return(checkpoint);
+    }
+    catch(const std::runtime_error &error)
+    {
+        throw std::runtime_error("Malformed checkpoint " + fileName + ": " + error.what());
+    }
+}
+
+std::string computeFilesHash(const std::vector<ParsedFile> &parsedFiles)
+{
+    gcry_md_hd_t hash;
+    processGcryError(gcry_md_open(&hash, GCRY_MD_SHA256, 0));
+    for(const ParsedFile &parsedFile: parsedFiles)
+    {
+        // Sizes of fields are hashed too, so that different splits of the same bytes into files differ.
+        for(const std::uint64_t fieldSize: {parsedFile.initialValueSize, parsedFile.contentSize,
+                                            parsedFile.shaCheckSumSize})
+        {
+            gcry_md_write(hash, &fieldSize, sizeof(fieldSize));
+        }
+        gcry_md_write(hash, parsedFile.initialValue.get(), parsedFile.initialValueSize);
+        gcry_md_write(hash, parsedFile.content.get(), parsedFile.contentSize);
+        gcry_md_write(hash, parsedFile.shaCheckSum.get(), parsedFile.shaCheckSumSize);
+    }
+    const std::string filesHash = encodeHex(gcry_md_read(hash, GCRY_MD_SHA256), gcry_md_get_algo_dlen(GCRY_MD_SHA256));
+    gcry_md_close(hash);
+    return(filesHash);
+}
+
+CheckpointRecorder::CheckpointRecorder(const Checkpoint &checkpoint, const std::string &fileName,
+                                       std::chrono::steady_clock::duration interval):
+    checkpoint(checkpoint), fileName(fileName), interval(interval), lastSaveTime(std::chrono::steady_clock::now())
+{}
+
+void CheckpointRecorder::recordCompleted(KeyspaceIndex first, KeyspaceIndex last)
+{
+    #pragma omp critical(checkpoint)
+    {
+        checkpoint.completed.add(first, last);
+        if(!fileName.empty() && std::chrono::steady_clock::now() - lastSaveTime >= interval)
+        {
+            // Exception can't leave critical section, and failed save shouldn't stop the search anyway,
+            // the next one will be tried after the interval.
+            lastSaveTime = std::chrono::steady_clock::now();
+            try
+            {
+                checkpoint.save(fileName);
+            }
+            catch(const std::exception &error)
+            {
+                std::cerr << "WARNING: Failed saving checkpoint " << fileName << "." << std::endl;
+                std::cerr << "         " << error.what() << "." << std::endl;
+            }
+        }
+    }
+}
+
+bool CheckpointRecorder::recordAcceptablePassword(std::size_t target, const std::string &password)
+{
+    const AcceptablePassword acceptablePassword = {target, password};
+    bool isNew = false;
+    #pragma omp critical(checkpoint)
+    {
+        const std::vector<AcceptablePassword> &passwords = checkpoint.acceptablePasswords;
+        isNew = std::find(passwords.begin(), passwords.end(), acceptablePassword) == passwords.end();
+        if(isNew)
+        {
+            checkpoint.acceptablePasswords.push_back(acceptablePassword);
+        }
+    }
+    return(isNew);
+}
+
+void CheckpointRecorder::save()
+{
+    checkpoint.save(fileName);
+    lastSaveTime = std::chrono::steady_clock::now();
+}
+
+void CheckpointRecorder::restartWithoutPaddingPrefilter()
+{
+    checkpoint.usePaddingPrefilter = false;
+    checkpoint.completed.clear();
+}
+
+Checkpoint CheckpointRecorder::getCheckpoint() const
+{
+    return(checkpoint);
+}
@@ -0,0 +1,132 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <utility>
+#include <cstddef>
+
+#include "../io/parse_file.h"
+#include "candidate_source.h"
+
+/**
+ * class KeyspaceRanges is a set of indices stored as disjoint ranges [first, last). Adjacent and overlapping
+ * ranges are merged, so a set of chunks completed by threads in almost sequential order stays small.
+ */
+class KeyspaceRanges
+{
+private:
+    // Maps first index of each range to its last index.
+    std::map<KeyspaceIndex, KeyspaceIndex> ranges;
+
+public:
+    void add(KeyspaceIndex first, KeyspaceIndex last);
+
+    /**
+     * Returns ranges of indices from [first, last), which are not in this set.
+     */
+    std::vector<std::pair<KeyspaceIndex, KeyspaceIndex>> getMissing(KeyspaceIndex first, KeyspaceIndex last) const;
+
+    /**
+     * Returns total number of indices in the set.
+     */
+    KeyspaceIndex count() const;
+
+    std::vector<std::pair<KeyspaceIndex, KeyspaceIndex>> getRanges() const;
+
+    void clear();
+};
+
+/**
+ * Password found for cipher file with index target among all cipher files of the search.
+ */
+struct AcceptablePassword
+{
+    std::size_t target;
+    std::string password;
+
+    bool operator==(const AcceptablePassword &other) const;
+};
+
+/**
+ * Progress of a search, which could be saved and resumed later. It is bound to the cipher files and candidates
+ * by hash of the files and description of candidate source, and stores completed ranges of candidate indices
+ * and passwords found in them.
+ */
+struct Checkpoint
+{
+    std::string filesHash;
+    std::string candidatesDescription;
+    KeyspaceIndex candidatesSize;
+    // Whether the search is in the pass with padding prefilter (the pass without it follows, if nothing is found).
+    bool usePaddingPrefilter;
+    // Description of plaintext filter, as passwords rejected by it are not searched again.
+    std::string plaintextFilterDescription;
+    KeyspaceRanges completed;
+    std::vector<AcceptablePassword> acceptablePasswords;
+
+    /**
+     * Writes checkpoint into a temporary file and renames it into fileName, so the file is replaced atomically
+     * and always contains a complete checkpoint. Throws std::runtime_error on failure.
+     */
+    void save(const std::string &fileName) const;
+
+    /**
+     * Reads checkpoint written by save. Throws std::runtime_error if file can't be read or is malformed.
+     */
+    static Checkpoint load(const std::string &fileName);
+};
+
+/**
+ * Returns hex encoded SHA256 of all fields of parsed cipher files in their order.
+ */
+std::string computeFilesHash(const std::vector<ParsedFile> &parsedFiles);
+
+/**
+ * class CheckpointRecorder collects progress of search from all threads and saves it periodically.
+ * If file name is empty, progress is only collected (e.g. for completion record of shard) and never saved.
+ * Functions recording progress are thread safe, others must not be called while search is running.
+ */
+class CheckpointRecorder
+{
+private:
+    Checkpoint checkpoint;
+    const std::string fileName;
+    const std::chrono::steady_clock::duration interval;
+    std::chrono::steady_clock::time_point lastSaveTime;
+
+public:
+    CheckpointRecorder(const Checkpoint &checkpoint, const std::string &fileName,
+                       std::chrono::steady_clock::duration interval);
+
+    /**
+     * Marks range of indices as checked. If interval since the last save has passed, checkpoint is saved,
+     * failure of such save is only reported into std::cerr. Passwords found in the range should be recorded before.
+     */
+    void recordCompleted(KeyspaceIndex first, KeyspaceIndex last);
+
+    /**
+     * Returns false, if the password has been already recorded (it was found in a chunk, which was interrupted
+     * before completion), so it shouldn't be reported again.
+     */
+    bool recordAcceptablePassword(std::size_t target, const std::string &password);
+
+    /**
+     * Saves checkpoint right now. Throws std::runtime_error on failure.
+     */
+    void save();
+
+    /**
+     * Starts the pass without padding prefilter from scratch, found passwords are kept.
+     */
+    void restartWithoutPaddingPrefilter();
+
+    /**
+     * Returns copy of current state.
+     */
+    Checkpoint getCheckpoint() const;
+};
+
+#endif
@@ -0,0 +1,211 @@
+#include "markov_model.h"
+
+#include <fstream>
+#include <stdexcept>
+#include <algorithm>
+#include <limits>
+#include <memory>
+
+#include "candidate_source.h"
+
+namespace
+{
+
+// File starts with the magic, which is followed by number of positions. Each position is number of its non-zero
+// counters and the counters themselves: previous character (2 bytes, 256 for the start), character (1 byte)
+// and count (4 bytes). Integers are little endian.
+const char markovModelMagic[4] = {'M', 'K', 'V', '1'};
+
+void writeInteger(std::ostream &output, std::uint32_t value, std::size_t size)
+{
+    for(std::size_t byteIndex = 0; byteIndex < size; ++byteIndex)
+    {
+        output.put(static_cast<char>(value >> (8 * byteIndex) & 0xff));
+    }
+}
+
+std::uint32_t readInteger(std::istream &input, std::size_t size)
+{
+    std::uint32_t value = 0;
+    for(std::size_t byteIndex = 0; byteIndex < size; ++byteIndex)
+    {
+        const int byte = input.get();
+        if(byte == std::istream::traits_type::eof())
+        {
+            throw std::runtime_error("unexpected end of file");
+        }
+        value |= static_cast<std::uint32_t>(byte) << (8 * byteIndex);
+    }
+    return(value);
+}
+
+}
+
+MarkovModel::MarkovModel():
+    counts(), positionCounts()
+{}
+
+void MarkovModel::addCount(std::size_t position, std::size_t previous, unsigned char character, std::uint32_t count)
+{
+    if(position >= counts.size())
+    {
+        counts.resize(position + 1);
+        positionCounts.resize(position + 1, std::array<std::uint64_t, 256>());
+    }
+    if(counts[position].empty())
+    {
+        counts[position].resize(previousCount * 256, 0);
+    }
+
+    // Counters saturate instead of wrapping around, order of characters is all that matters.
+    std::uint32_t &counter = counts[position][previous * 256 + character];
+    counter += std::min(count, std::numeric_limits<std::uint32_t>::max() - counter);
+    positionCounts[position][character] += count;
+}
+
+void MarkovModel::addWord(const char *word, std::size_t length)
+{
+    std::size_t previous = 256;
+    for(std::size_t position = 0; position < length; ++position)
+    {
+        const unsigned char character = static_cast<unsigned char>(word[position]);
+        addCount(std::min(position, markovModelPositions - 1), previous, character, 1);
+        previous = character;
+    }
+}
+
+std::uint64_t MarkovModel::addCandidates(const CandidateSource &candidates)
+{
+    std::uint64_t candidatesCount = 0;
+    CandidateBatch batch(4096, candidates.getMaxLength());
+    std::unique_ptr<CandidateCursor> cursor = candidates.cursor();
+    cursor->seek(0, candidates.size());
+    bool hasMore = true;
+    while(hasMore)
+    {
+        batch.clear();
+        hasMore = cursor->fill(batch);
+        for(std::size_t index = 0; index < batch.size(); ++index)
+        {
+            addWord(batch[index].data(), batch[index].size());
+        }
+        candidatesCount += batch.size();
+    }
+    return(candidatesCount);
+}
+
+std::uint32_t MarkovModel::getCount(std::size_t position, int previous, unsigned char character) const
+{
+    position = std::min(position, markovModelPositions - 1);
+    if(position >= counts.size() || counts[position].empty())
+    {
+        return(0);
+    }
+    const std::size_t previousIndex = previous < 0 ? 256 : static_cast<std::size_t>(previous);
+    return(counts[position][previousIndex * 256 + character]);
+}
+
+std::string MarkovModel::orderCharset(const std::string &charset, std::size_t position, int previous) const
+{
+    position = std::min(position, markovModelPositions - 1);
+    const std::array<std::uint64_t, 256> noCounts = {};
+    const std::array<std::uint64_t, 256> &characterCounts = position < positionCounts.size() ?
+                                                            positionCounts[position] : noCounts;
+    std::string orderedCharset = charset;
+    std::stable_sort(orderedCharset.begin(), orderedCharset.end(),
+                     [this, position, previous, &characterCounts](char character, char otherCharacter)
+                     {
+                         const unsigned char byte = static_cast<unsigned char>(character),
+                                             otherByte = static_cast<unsigned char>(otherCharacter);
+                         const std::uint32_t count = getCount(position, previous, byte),
+                                             otherCount = getCount(position, previous, otherByte);
+                         if(count != otherCount)
+                         {
+                             return(count > otherCount);
+                         }
+                         return(characterCounts[byte] > characterCounts[otherByte]);
+                     });
+    return(orderedCharset);
+}
+
+void MarkovModel::save(const std::string &fileName) const
+{
+    std::ofstream output(fileName, std::ios_base::binary | std::ios_base::trunc);
+    output.write(markovModelMagic, sizeof(markovModelMagic));
+    writeInteger(output, static_cast<std::uint32_t>(counts.size()), 4);
+    for(const std::vector<std::uint32_t> &positionCounters: counts)
+    {
+        writeInteger(output, static_cast<std::uint32_t>(
+            std::count_if(positionCounters.begin(), positionCounters.end(), [](std::uint32_t count)
+                          {
+                              return(count != 0);
+                          })), 4);
+        for(std::size_t counterIndex = 0; counterIndex < positionCounters.size(); ++counterIndex)
+        {
+            if(positionCounters[counterIndex] != 0)
+            {
+                writeInteger(output, static_cast<std::uint32_t>(counterIndex / 256), 2);
+                writeInteger(output, static_cast<std::uint32_t>(counterIndex % 256), 1);
+                writeInteger(output, positionCounters[counterIndex], 4);
+            }
+        }
+    }
+    output.flush();
+    if(!output)
+    {
+        throw std::runtime_error("ERROR in MarkovModel::save: can't write Markov model into " + fileName);
+    }
+}
+
+MarkovModel MarkovModel::load(const std::string &fileName)
+{
+    std::ifstream input(fileName, std::ios_base::binary);
+    if(!input)
+    {
+        throw std::runtime_error("ERROR in MarkovModel::load: can't open Markov model " + fileName);
+    }
+
+    MarkovModel model;
+    try
+    {
+        char magic[sizeof(markovModelMagic)];
+        if(!input.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), markovModelMagic))
+        {
+            throw std::runtime_error("unknown format");
+        }
+        const std::uint32_t positionsCount = readInteger(input, 4);
+        if(positionsCount > markovModelPositions)
+        {
+            throw std::runtime_error("too many positions");
+        }
+        for(std::uint32_t position = 0; position < positionsCount; ++position)
+        {
+            const std::uint32_t countersCount = readInteger(input, 4);
+            if(countersCount > previousCount * 256)
+            {
+                throw std::runtime_error("too many counters");
+            }
+            for(std::uint32_t counterIndex = 0; counterIndex < countersCount; ++counterIndex)
+            {
+                const std::uint32_t previous = readInteger(input, 2);
+                const std::uint32_t character = readInteger(input, 1);
+                const std::uint32_t count = readInteger(input, 4);
+                if(previous >= previousCount)
+                {
+                    throw std::runtime_error("invalid previous character");
+                }
+                model.addCount(position, previous, static_cast<unsigned char>(character), count);
+            }
+        }
+        if(input.peek() != std::istream::traits_type::eof())
+        {
+            throw std::runtime_error("unexpected data after the last position");
+        }
+    }
+    catch(const std::runtime_error &error)
+    {
+        throw std::runtime_error("ERROR in MarkovModel::load: malformed Markov model " + fileName + ": " +
+                                 error.what());
+    }
+    return(model);
+}
@@ -0,0 +1,79 @@
+#ifndef MARKOV_MODEL_H
+#define MARKOV_MODEL_H
+
+#include <string>
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+class CandidateSource;
+
+/**
+ * Number of password positions, which have their own statistics in MarkovModel. Characters of further
+ * positions are counted as characters of the last one.
+ */
+constexpr std::size_t markovModelPositions = 32;
+
+/**
+ * class MarkovModel keeps statistics of real passwords: how many times each character follows each character
+ * at each position (the first character of password follows its start). It is trained on a wordlist once
+ * and saved into a compact binary file, which keeps only counters met in training.
+ * Model orders charsets of mask positions from the most probable character to the least probable one,
+ * so passwords are enumerated lexicographically by ranks of their characters (as in per-position Markov mode
+ * of hashcat): probable characters are tried first at each position, but an earlier position always dominates
+ * the later ones, so the order is not sorted by probability of the whole password.
+ */
+class MarkovModel
+{
+private:
+    // Number of characters, which could precede a character: all bytes and the start of password.
+    static constexpr std::size_t previousCount = 257;
+
+    // counts[position][previous * 256 + character], previous is 256 for the start of password.
+    // Only positions met in training have counters.
+    std::vector<std::vector<std::uint32_t>> counts;
+    // Number of times each character is met at position after any character.
+    std::vector<std::array<std::uint64_t, 256>> positionCounts;
+
+    void addCount(std::size_t position, std::size_t previous, unsigned char character, std::uint32_t count);
+
+public:
+    MarkovModel();
+
+    /**
+     * Counts characters of word.
+     */
+    void addWord(const char *word, std::size_t length);
+
+    /**
+     * Counts characters of all candidates of source (e.g. of wordlist transformed by rules).
+     * Returns number of counted candidates.
+     */
+    std::uint64_t addCandidates(const CandidateSource &candidates);
+
+    /**
+     * Returns how many times character follows previous character at position. Previous character
+     * is -1 for the first position.
+     */
+    std::uint32_t getCount(std::size_t position, int previous, unsigned char character) const;
+
+    /**
+     * Returns characters of charset ordered from the most probable to follow previous character (-1 for
+     * the start of password) at position to the least probable one. Characters, which never follow it in training,
+     * are ordered by their frequency at position, and the rest of them keep their order in charset.
+     */
+    std::string orderCharset(const std::string &charset, std::size_t position, int previous) const;
+
+    /**
+     * Writes model into binary file. Throws std::runtime_error if it can't be written.
+     */
+    void save(const std::string &fileName) const;
+
+    /**
+     * Reads model written by save. Throws std::runtime_error if file can't be read or is malformed.
+     */
+    static MarkovModel load(const std::string &fileName);
+};
+
+#endif
@@ -0,0 +1,497 @@
+#include "mask_keyspace.h"
+
+#include <sstream>
+#include <iomanip>
+#include <limits>
+#include <stdexcept>
+#include <algorithm>
+#include <array>
+#include <utility>
+#include <cstring>
+#include <cstdint>
+
+#include "markov_model.h"
+
+namespace
+{
+
+std::string makeCharRange(char first, char last)
+{
+    std::string range;
+    for(int letter = static_cast<unsigned char>(first); letter <= static_cast<unsigned char>(last); ++letter)
+    {
+        range.push_back(static_cast<char>(letter));
+    }
+    return(range);
+}
+
+/**
+ * Returns characters of built-in charset with given placeholder symbol or empty string if there is no such one.
+ */
+std::string getBuiltInCharset(char symbol)
+{
+    switch(symbol)
+    {
+        case 'l':
+            return(makeCharRange('a', 'z'));
+        case 'u':
+            return(makeCharRange('A', 'Z'));
+        case 'd':
+            return(makeCharRange('0', '9'));
+        case 'h':
+            return(makeCharRange('0', '9') + makeCharRange('a', 'f'));
+        case 'H':
+            return(makeCharRange('0', '9') + makeCharRange('A', 'F'));
+        case 's':
+            return(" !\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~");
+        case 'a':
+            return(getBuiltInCharset('l') + getBuiltInCharset('u') + getBuiltInCharset('d') + getBuiltInCharset('s'));
+        case 'b':
+            return(makeCharRange('\x00', '\xff'));
+        case '?':
+            return("?");
+        default:
+            return(std::string());
+    }
+}
+
+/**
+ * Adapts MaskKeyspaceCursor to the interface of candidate sources: each password is copied
+ * from the odometer buffer into the next slot of batch.
+ */
+class MaskCandidateCursor: public CandidateCursor
+{
+private:
+    MaskKeyspaceCursor cursor;
+    std::vector<char> password;
+    std::size_t passwordLength;
+    KeyspaceIndex passwordIndex, last;
+
+public:
+    explicit MaskCandidateCursor(const MaskKeyspace &keyspace):
+        cursor(keyspace), password(keyspace.getMaxLength()), passwordLength(0), passwordIndex(0), last(0)
+    {}
+
+    void seek(KeyspaceIndex first, KeyspaceIndex last) override
+    {
+        // Only the first password in part is decoded from its index, others are obtained by incrementing the previous.
+        this->last = last;
+        passwordIndex = first;
+        if(first < last)
+        {
+            passwordLength = cursor.seek(first, password.data());
+        }
+    }
+
+    bool fill(CandidateBatch &batch) override
+    {
+        for(; passwordIndex < last && !batch.full(); ++passwordIndex)
+        {
+            unsigned char *slot = batch.getSlot();
+            std::copy(password.begin(), password.end(), slot);
+            batch.push(slot, passwordLength);
+            passwordLength = cursor.next(password.data());
+        }
+        return(passwordIndex < last);
+    }
+};
+
+/**
+ * Cursor of MaskKeyspace, all passwords of which have length Length. Compiler unrolls loops over positions,
+ * keeps the password in registers and writes it into slot of batch by a single fixed size store,
+ * so there is no call and no loop with unknown bounds per password.
+ */
+template<std::size_t Length>
+class FixedLengthMaskCursor: public CandidateCursor
+{
+private:
+    const MaskKeyspace &keyspace;
+    std::array<std::size_t, Length> radices;
+    std::array<std::size_t, Length> digits;
+    // Indices of characters in charsets, each of them selects order of characters of the next position.
+    std::array<std::size_t, Length> indices;
+    std::array<char, Length> password;
+    KeyspaceIndex passwordIndex, last;
+
+    std::size_t getPreviousIndex(std::size_t position) const
+    {
+        return(position > 0 ? indices[position - 1] : 0);
+    }
+
+    void writePosition(std::size_t position)
+    {
+        const std::size_t previousIndex = getPreviousIndex(position);
+        password[position] = keyspace.getCharset(position, previousIndex)[digits[position]];
+        indices[position] = keyspace.getCharacterIndices(position, previousIndex)[digits[position]];
+    }
+
+    // Odometer: the last position changes for each password, carries are rare. Positions after the changed one
+    // are rewritten, as their characters depend on the previous ones.
+    void next()
+    {
+        std::size_t position = Length;
+        while(position > 0 && ++digits[position - 1] == radices[position - 1])
+        {
+            digits[--position] = 0;
+        }
+        for(position = position > 0 ? position - 1 : 0; position < Length; ++position)
+        {
+            writePosition(position);
+        }
+    }
+
+public:
+    explicit FixedLengthMaskCursor(const MaskKeyspace &keyspace):
+        keyspace(keyspace), passwordIndex(0), last(0)
+    {
+        for(std::size_t position = 0; position < Length; ++position)
+        {
+            radices[position] = keyspace.getRadix(position);
+        }
+    }
+
+    void seek(KeyspaceIndex first, KeyspaceIndex last) override
+    {
+        this->last = last;
+        passwordIndex = first;
+        if(first < last)
+        {
+            for(std::size_t position = Length; position > 0; --position)
+            {
+                digits[position - 1] = first % radices[position - 1];
+                first /= radices[position - 1];
+            }
+            for(std::size_t position = 0; position < Length; ++position)
+            {
+                writePosition(position);
+            }
+        }
+    }
+
+    bool fill(CandidateBatch &batch) override
+    {
+        const std::size_t count = static_cast<std::size_t>(
+            std::min<KeyspaceIndex>(last - passwordIndex, batch.getFreeSlotsCount()));
+        const std::size_t stride = batch.getStride();
+        unsigned char *slot = batch.getSlot();
+        // Passwords differ only by the last character until it wraps around, so they are written by a run
+        // without carries: unchanged prefix is copied and the last character is taken from its charset.
+        // The odometer is turned once per run. Password itself is not modified in the run, as reading it
+        // right after writing its byte would stall on store forwarding.
+        for(std::size_t index = 0; index < count;)
+        {
+            const std::size_t runSize = std::min(count - index, radices[Length - 1] - digits[Length - 1]);
+            const char *runCharacters = keyspace.getCharset(Length - 1, getPreviousIndex(Length - 1)) +
+                                        digits[Length - 1];
+            for(std::size_t runIndex = 0; runIndex < runSize; ++runIndex, slot += stride)
+            {
+                std::memcpy(slot, password.data(), Length - 1);
+                slot[Length - 1] = runCharacters[runIndex];
+            }
+            digits[Length - 1] += runSize - 1;
+            next();
+            index += runSize;
+        }
+        batch.pushSlots(count, Length);
+        passwordIndex += count;
+        return(passwordIndex < last);
+    }
+};
+
+template<std::size_t Length>
+std::unique_ptr<CandidateCursor> createFixedLengthMaskCursor(const MaskKeyspace &keyspace)
+{
+    return(std::unique_ptr<CandidateCursor>(new FixedLengthMaskCursor<Length>(keyspace)));
+}
+
+// Cursors of all lengths are instantiated and the one of length of keyspace is chosen at runtime.
+template<std::size_t... LengthIndices>
+std::unique_ptr<CandidateCursor> createFixedLengthMaskCursor(const MaskKeyspace &keyspace,
+                                                             std::index_sequence<LengthIndices...>)
+{
+    using CursorFactory = std::unique_ptr<CandidateCursor> (*)(const MaskKeyspace &);
+    static const CursorFactory cursorFactories[] = {&createFixedLengthMaskCursor<LengthIndices + 1>...};
+    return(cursorFactories[keyspace.getMaxLength() - 1](keyspace));
+}
+
+void appendDistinct(std::string &charset, const std::string &characters)
+{
+    for(char character: characters)
+    {
+        if(charset.find(character) == std::string::npos)
+        {
+            charset.push_back(character);
+        }
+    }
+}
+
+}
+
+std::string expandCharset(const std::string &definition)
+{
+    std::string charset;
+    for(std::size_t position = 0; position < definition.size(); ++position)
+    {
+        if(definition[position] != '?')
+        {
+            appendDistinct(charset, std::string(1, definition[position]));
+            continue;
+        }
+
+        if(++position == definition.size())
+        {
+            throw std::invalid_argument("ERROR in expandCharset: charset \"" + definition + "\" ends with '?'");
+        }
+        const std::string builtInCharset = getBuiltInCharset(definition[position]);
+        if(builtInCharset.empty())
+        {
+            throw std::invalid_argument("ERROR in expandCharset: unknown placeholder ?" +
+                                        std::string(1, definition[position]) + " in charset \"" + definition + "\"");
+        }
+        appendDistinct(charset, builtInCharset);
+    }
+    return(charset);
+}
+
+std::vector<std::string> parseMask(const std::string &mask, const std::vector<std::string> &customCharsets)
+{
+    std::vector<std::string> charsets;
+    for(std::size_t position = 0; position < mask.size(); ++position)
+    {
+        if(mask[position] != '?')
+        {
+            charsets.push_back(std::string(1, mask[position]));
+            continue;
+        }
+
+        if(++position == mask.size())
+        {
+            throw std::invalid_argument("ERROR in parseMask: mask \"" + mask + "\" ends with '?'");
+        }
+        const char symbol = mask[position];
+        if(symbol >= '1' && symbol < static_cast<char>('1' + maskCustomCharsetsCount))
+        {
+            const std::size_t customIndex = symbol - '1';
+            if(customIndex >= customCharsets.size() || customCharsets[customIndex].empty())
+            {
+                throw std::invalid_argument("ERROR in parseMask: custom charset ?" + std::string(1, symbol) +
+                                            " used in mask \"" + mask + "\" is not defined");
+            }
+            charsets.push_back(expandCharset(customCharsets[customIndex]));
+            continue;
+        }
+
+        const std::string builtInCharset = getBuiltInCharset(symbol);
+        if(builtInCharset.empty())
+        {
+            throw std::invalid_argument("ERROR in parseMask: unknown placeholder ?" + std::string(1, symbol) +
+                                        " in mask \"" + mask + "\"");
+        }
+        charsets.push_back(builtInCharset);
+    }
+    return(charsets);
+}
+
+MaskKeyspace::MaskKeyspace(const std::vector<std::string> &charsets, std::size_t minLength, std::size_t maxLength,
+                           const MarkovModel *markovModel):
+    table(), characterIndices(), offsets(), radices(), blockSizes(), orderDescription(), minLength(minLength),
+    maxLength(maxLength), lengthStarts(1, 0)
+{
+    if(minLength == 0 || minLength > maxLength || maxLength > charsets.size())
+    {
+        throw std::invalid_argument("ERROR in MaskKeyspace: password lengths should be from 1 to length of mask");
+    }
+
+    for(std::size_t position = 0; position < maxLength; ++position)
+    {
+        if(charsets[position].empty())
+        {
+            throw std::invalid_argument("ERROR in MaskKeyspace: charset of mask position is empty");
+        }
+        offsets.push_back(table.size());
+        radices.push_back(charsets[position].size());
+
+        // Model orders charset for each character of the previous position, otherwise there is a single order.
+        const bool isOrdered = markovModel != nullptr;
+        const std::size_t blocksCount = isOrdered && position > 0 ? radices[position - 1] : 1;
+        blockSizes.push_back(isOrdered ? radices[position] : 0);
+        for(std::size_t previousIndex = 0; previousIndex < blocksCount; ++previousIndex)
+        {
+            const int previous = position > 0 ? static_cast<unsigned char>(charsets[position - 1][previousIndex]) : -1;
+            const std::string block = isOrdered ? markovModel->orderCharset(charsets[position], position, previous) :
+                                      charsets[position];
+            table += block;
+            for(const char character: block)
+            {
+                characterIndices.push_back(static_cast<unsigned char>(charsets[position].find(character)));
+            }
+        }
+    }
+
+    // Ordered table is identified by its FNV-1a hash, as it could be large.
+    if(markovModel != nullptr)
+    {
+        std::uint64_t tableHash = 0xcbf29ce484222325;
+        for(const char character: table)
+        {
+            tableHash = (tableHash ^ static_cast<unsigned char>(character)) * 0x100000001b3;
+        }
+        std::ostringstream description;
+        description << " markov " << std::hex << std::setw(16) << std::setfill('0') << tableHash;
+        orderDescription = description.str();
+    }
+
+    // Number of passwords of each length is a product of radices of its positions.
+    KeyspaceIndex lengthSize = 1;
+    for(std::size_t length = 1; length <= maxLength; ++length)
+    {
+        if(lengthSize > std::numeric_limits<KeyspaceIndex>::max() / radices[length - 1])
+        {
+            throw std::overflow_error("ERROR in MaskKeyspace: size of keyspace doesn't fit into 64 bit index");
+        }
+        lengthSize *= radices[length - 1];
+        if(length < minLength)
+        {
+            continue;
+        }
+        if(lengthStarts.back() > std::numeric_limits<KeyspaceIndex>::max() - lengthSize)
+        {
+            throw std::overflow_error("ERROR in MaskKeyspace: size of keyspace doesn't fit into 64 bit index");
+        }
+        lengthStarts.push_back(lengthStarts.back() + lengthSize);
+    }
+}
+
+KeyspaceIndex MaskKeyspace::size() const
+{
+    return(lengthStarts.back());
+}
+
+std::size_t MaskKeyspace::getMinLength() const
+{
+    return(minLength);
+}
+
+std::size_t MaskKeyspace::getMaxLength() const
+{
+    return(maxLength);
+}
+
+KeyspaceIndex MaskKeyspace::getDefaultChunkSize() const
+{
+    return(4096);
+}
+
+std::string MaskKeyspace::getDescription() const
+{
+    // Charsets could contain any characters, so each of them is prefixed with its size.
+    std::string description = "mask " + std::to_string(minLength) + " " + std::to_string(maxLength);
+    for(std::size_t position = 0; position < maxLength; ++position)
+    {
+        description += " " + std::to_string(radices[position]) + ":" +
+                       table.substr(offsets[position], radices[position]);
+    }
+    return(description + orderDescription);
+}
+
+std::unique_ptr<CandidateCursor> MaskKeyspace::cursor() const
+{
+    if(minLength == maxLength && maxLength <= maxFixedMaskLength)
+    {
+        return(createFixedLengthMaskCursor(*this, std::make_index_sequence<maxFixedMaskLength>()));
+    }
+    return(std::unique_ptr<CandidateCursor>(new MaskCandidateCursor(*this)));
+}
+
+const char *MaskKeyspace::getCharset(std::size_t position, std::size_t previousIndex) const
+{
+    return(table.data() + offsets[position] + previousIndex * blockSizes[position]);
+}
+
+std::size_t MaskKeyspace::getRadix(std::size_t position) const
+{
+    return(radices[position]);
+}
+
+const unsigned char *MaskKeyspace::getCharacterIndices(std::size_t position, std::size_t previousIndex) const
+{
+    return(characterIndices.data() + offsets[position] + previousIndex * blockSizes[position]);
+}
+
+std::size_t MaskKeyspace::decode(KeyspaceIndex index, char *buffer) const
+{
+    std::size_t length = minLength;
+    while(index >= lengthStarts[length - minLength + 1])
+    {
+        ++length;
+    }
+    index -= lengthStarts[length - minLength];
+
+    // Digits (they are less than 256) are kept in buffer, until they are replaced by characters
+    // from the first position, as order of characters depends on the previous one.
+    for(std::size_t position = length; position > 0; --position)
+    {
+        buffer[position - 1] = static_cast<char>(index % radices[position - 1]);
+        index /= radices[position - 1];
+    }
+    std::size_t previousIndex = 0;
+    for(std::size_t position = 0; position < length; ++position)
+    {
+        const std::size_t tableIndex = offsets[position] + previousIndex * blockSizes[position] +
+                                       static_cast<unsigned char>(buffer[position]);
+        buffer[position] = table[tableIndex];
+        previousIndex = characterIndices[tableIndex];
+    }
+    return(length);
+}
+
+MaskKeyspaceCursor::MaskKeyspaceCursor(const MaskKeyspace &keyspace):
+    keyspace(&keyspace), digits(keyspace.getMaxLength(), 0), indices(keyspace.getMaxLength(), 0),
+    length(keyspace.getMinLength())
+{}
+
+void MaskKeyspaceCursor::writePositions(std::size_t firstPosition, char *buffer)
+{
+    for(std::size_t position = firstPosition; position < length; ++position)
+    {
+        const std::size_t previousIndex = position > 0 ? indices[position - 1] : 0;
+        buffer[position] = keyspace->getCharset(position, previousIndex)[digits[position]];
+        indices[position] = keyspace->getCharacterIndices(position, previousIndex)[digits[position]];
+    }
+}
+
+std::size_t MaskKeyspaceCursor::seek(KeyspaceIndex index, char *buffer)
+{
+    length = keyspace->decode(index, buffer);
+
+    index -= keyspace->lengthStarts[length - keyspace->minLength];
+    for(std::size_t position = length; position > 0; --position)
+    {
+        digits[position - 1] = index % keyspace->radices[position - 1];
+        index /= keyspace->radices[position - 1];
+    }
+    writePositions(0, buffer);
+    return(length);
+}
+
+std::size_t MaskKeyspaceCursor::next(char *buffer)
+{
+    for(std::size_t position = length; position > 0; --position)
+    {
+        std::size_t &digit = digits[position - 1];
+        if(++digit != keyspace->radices[position - 1])
+        {
+            // Positions after the changed one have wrapped around to their first characters.
+            writePositions(position - 1, buffer);
+            return(length);
+        }
+        digit = 0;
+    }
+
+    // All positions have wrapped around, so the next password is the first one of the next length
+    // (or of the minimal length after the last password).
+    length = length == keyspace->maxLength ? keyspace->minLength : length + 1;
+    std::fill(digits.begin(), digits.end(), 0);
+    writePositions(0, buffer);
+    return(length);
+}
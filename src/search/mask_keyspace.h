@@ -0,0 +1,147 @@
+#ifndef MASK_KEYSPACE_H
+#define MASK_KEYSPACE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+#include "candidate_source.h"
+
+class MarkovModel;
+
+/**
+ * Number of custom charsets, which could be referenced in mask as ?1 ... ?4.
+ */
+constexpr std::size_t maskCustomCharsetsCount = 4;
+
+/**
+ * Maximal length of passwords, for which cursor of MaskKeyspace is specialized at compile time.
+ */
+constexpr std::size_t maxFixedMaskLength = 16;
+
+/**
+ * Expands charset definition into the set of characters. Definition consists of characters and
+ * placeholders of built-in charsets: ?l (a-z), ?u (A-Z), ?d (0-9), ?h (0-9a-f), ?H (0-9A-F),
+ * ?s (printable ASCII specials and space), ?a (?l?u?d?s), ?b (all bytes) and ?? (question mark).
+ * Repeated characters are kept only at their first occurrence, so charset contains distinct characters.
+ * Throws std::invalid_argument for unknown placeholders.
+ */
+std::string expandCharset(const std::string &definition);
+
+/**
+ * Parses hashcat style mask, e.g. "?u?l?l?d?d" or "pass?d?d". Each position of mask is either a literal
+ * character or a placeholder of built-in charset (see expandCharset) or of custom one (?1 ... ?4),
+ * which are given by definitions in customCharsets (they could contain built-in placeholders too).
+ * Returns charset of each position. Throws std::invalid_argument if mask is malformed.
+ */
+std::vector<std::string> parseMask(const std::string &mask, const std::vector<std::string> &customCharsets);
+
+/**
+ * class MaskKeyspace is an index addressable set of passwords, which match a mask. Passwords of lengths
+ * from minLength to maxLength are produced by prefixes of mask (like in hashcat increment mode), shorter
+ * passwords have smaller indices. Passwords of the same length are ordered lexicographically by positions
+ * of characters in charsets: index is a mixed radix number, the last position is its least significant digit.
+ * Characters of all positions are stored in one
+ * lookup table, so decoding is just a table lookup per position.
+ * With Markov model charset of each position is ordered separately for each character of the previous position
+ * from the most probable character to the least probable one. Index is still a mixed radix number, its digit
+ * selects a character from ordered charset of its position, so each password is still produced exactly once,
+ * and passwords are ordered lexicographically by ranks of their characters: the password of the most probable
+ * characters goes first, but rank of an earlier position dominates ranks of all later ones.
+ * If all passwords have the same length up to maxFixedMaskLength, cursor of keyspace is specialized for the length
+ * at compile time: its state is kept in fixed size arrays and each password is written into batch by a copy
+ * of fixed size, so a password costs a few cycles.
+ */
+class MaskKeyspace: public CandidateSource
+{
+private:
+    // Characters of position i, which follow character with index j in charset of position i - 1, are
+    // table[offsets[i] + j * blockSizes[i] ... + radices[i]) in order of enumeration and their indices in charset
+    // of position i are at the same places of characterIndices. Without Markov model order of characters doesn't
+    // depend on the previous one and blockSizes are 0.
+    std::string table;
+    std::vector<unsigned char> characterIndices;
+    std::vector<std::size_t> offsets, radices, blockSizes;
+    std::string orderDescription;
+    std::size_t minLength, maxLength;
+    // Passwords of length minLength + i have indices [lengthStarts[i], lengthStarts[i + 1]).
+    std::vector<KeyspaceIndex> lengthStarts;
+
+    friend class MaskKeyspaceCursor;
+public:
+    /**
+     * Creates keyspace of passwords of lengths [minLength, maxLength] from charsets of mask positions.
+     * If markovModel is given, charsets are ordered by it.
+     * Throws std::invalid_argument if lengths are not in [1, charsets.size()] or some charset is empty
+     * and std::overflow_error if size of keyspace doesn't fit into 64 bit index.
+     */
+    MaskKeyspace(const std::vector<std::string> &charsets, std::size_t minLength, std::size_t maxLength,
+                 const MarkovModel *markovModel = nullptr);
+
+    KeyspaceIndex size() const override;
+
+    std::size_t getMinLength() const;
+    std::size_t getMaxLength() const override;
+
+    KeyspaceIndex getDefaultChunkSize() const override;
+
+    std::string getDescription() const override;
+
+    /**
+     * Returns cursor, which writes passwords into storage of batch.
+     */
+    std::unique_ptr<CandidateCursor> cursor() const override;
+
+    /**
+     * Returns characters of mask position (less than getMaxLength()) in order of enumeration, if the previous
+     * position has character with index previousIndex in its charset (it is ignored for the first position).
+     * There are getRadix(position) of them.
+     */
+    const char *getCharset(std::size_t position, std::size_t previousIndex) const;
+    std::size_t getRadix(std::size_t position) const;
+
+    /**
+     * Returns indices of characters returned by getCharset in charset of position, they select charsets
+     * of the next position.
+     */
+    const unsigned char *getCharacterIndices(std::size_t position, std::size_t previousIndex) const;
+
+    /**
+     * Writes password with given index (less than size()) into buffer of at least getMaxLength() characters.
+     * Returns length of the password.
+     */
+    std::size_t decode(KeyspaceIndex index, char *buffer) const;
+};
+
+/**
+ * class MaskKeyspaceCursor enumerates passwords of MaskKeyspace sequentially into a fixed size buffer
+ * of getMaxLength() characters. It works as an odometer: only positions,
+ * which actually changed, are rewritten in the buffer.
+ */
+class MaskKeyspaceCursor
+{
+private:
+    const MaskKeyspace *keyspace;
+    std::vector<std::size_t> digits, indices;
+    std::size_t length;
+
+    // Writes characters of positions from firstPosition by their digits, they depend on the previous characters.
+    void writePositions(std::size_t firstPosition, char *buffer);
+
+public:
+    explicit MaskKeyspaceCursor(const MaskKeyspace &keyspace);
+
+    /**
+     * Writes password with given index into buffer and returns its length.
+     */
+    std::size_t seek(KeyspaceIndex index, char *buffer);
+
+    /**
+     * Transforms password in buffer into the next one and returns its length. Buffer must contain password
+     * written by previous call of seek or next. Wraps around to the first password after the last one.
+     */
+    std::size_t next(char *buffer);
+};
+
+#endif
@@ -0,0 +1,200 @@
+#include "progress_reporter.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <cstdio>
+
+namespace
+{
+
+std::string formatDuration(double seconds)
+{
+    const std::uint64_t totalSeconds = static_cast<std::uint64_t>(seconds);
+    std::ostringstream stream;
+    stream << totalSeconds / 3600 << ":" << std::setw(2) << std::setfill('0') << totalSeconds / 60 % 60 << ":"
+           << std::setw(2) << std::setfill('0') << totalSeconds % 60;
+    return(stream.str());
+}
+
+}
+
+ThreadProgress::ThreadProgress():
+    candidates(0), indices(0)
+{}
+
+void ThreadProgress::addCandidates(std::uint64_t count)
+{
+    // Only the owning thread writes the counter, so plain load and store are enough.
+    candidates.store(candidates.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+}
+
+void ThreadProgress::addIndices(KeyspaceIndex count)
+{
+    indices.store(indices.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+}
+
+double ProgressStatus::getDonePercent() const
+{
+    return(totalIndices == 0 ? 100.0 : 100.0 * doneIndices / totalIndices);
+}
+
+std::ostream &operator<<(std::ostream &stream, const ProgressStatus &status)
+{
+    stream << (status.finished ? "Finished: " : "Progress: ") << std::fixed << std::setprecision(2)
+           << status.getDonePercent() << "% (" << status.doneIndices << "/" << status.totalIndices << "), "
+           << static_cast<std::uint64_t>(status.candidatesPerSecond) << " passwords/s, "
+           << "elapsed " << formatDuration(status.elapsedSeconds) << ", ETA "
+           << (status.etaSeconds < 0 ? std::string("unknown") : formatDuration(status.etaSeconds)) << ", "
+           << status.threadCandidates.size() << " threads, imbalance " << std::setprecision(0)
+           << status.imbalancePercent << "%";
+    return(stream);
+}
+
+void writeJson(std::ostream &stream, const ProgressStatus &status)
+{
+    stream << std::fixed << std::setprecision(2)
+           << "{\"elapsed_seconds\": " << status.elapsedSeconds
+           << ", \"done\": " << status.doneIndices
+           << ", \"total\": " << status.totalIndices
+           << ", \"percent\": " << status.getDonePercent()
+           << ", \"candidates_per_second\": " << status.candidatesPerSecond
+           << ", \"eta_seconds\": ";
+    if(status.etaSeconds < 0)
+    {
+        stream << "null";
+    }
+    else
+    {
+        stream << status.etaSeconds;
+    }
+    stream << ", \"thread_candidates\": [";
+    for(std::size_t threadIndex = 0; threadIndex < status.threadCandidates.size(); ++threadIndex)
+    {
+        stream << (threadIndex == 0 ? "" : ", ") << status.threadCandidates[threadIndex];
+    }
+    stream << "], \"imbalance_percent\": " << status.imbalancePercent
+           << ", \"finished\": " << (status.finished ? "true" : "false") << "}\n";
+}
+
+ProgressReporter::ProgressReporter(std::size_t threadsCount, KeyspaceIndex totalIndices,
+                                   KeyspaceIndex initialDoneIndices, std::chrono::steady_clock::duration interval,
+                                   std::ostream *stream, const std::string &statusFileName):
+    interval(interval), stream(stream), statusFileName(statusFileName), totalIndices(totalIndices),
+    initialDoneIndices(initialDoneIndices), threadProgresses(threadsCount),
+    threadsCount(threadsCount), startTime(std::chrono::steady_clock::now()), lastReportTime(startTime),
+    lastThreadCandidates(threadsCount, 0), stopRequested(false)
+{}
+
+ProgressReporter::~ProgressReporter()
+{
+    stop();
+}
+
+ThreadProgress &ProgressReporter::getThreadProgress(std::size_t threadIndex)
+{
+    return(threadProgresses[threadIndex]);
+}
+
+void ProgressReporter::start()
+{
+    startTime = lastReportTime = std::chrono::steady_clock::now();
+    reporterThread = std::thread(&ProgressReporter::run, this);
+}
+
+void ProgressReporter::stop()
+{
+    if(!reporterThread.joinable())
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopRequested = true;
+    }
+    stopCondition.notify_one();
+    reporterThread.join();
+    report(collect(true));
+}
+
+void ProgressReporter::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while(!stopCondition.wait_for(lock, interval, [this]()
+          {
+              return(stopRequested);
+          }))
+    {
+        report(collect(false));
+    }
+}
+
+ProgressStatus ProgressReporter::collect(bool finished)
+{
+    const auto now = std::chrono::steady_clock::now();
+    ProgressStatus status;
+    status.elapsedSeconds = std::chrono::duration<double>(now - startTime).count();
+    status.totalIndices = totalIndices;
+    status.finished = finished;
+
+    KeyspaceIndex doneIndices = 0;
+    std::uint64_t intervalCandidates = 0;
+    status.threadCandidates.resize(threadsCount);
+    for(std::size_t threadIndex = 0; threadIndex < threadsCount; ++threadIndex)
+    {
+        const std::uint64_t candidates = threadProgresses[threadIndex].candidates.load(std::memory_order_relaxed);
+        status.threadCandidates[threadIndex] = candidates - lastThreadCandidates[threadIndex];
+        intervalCandidates += status.threadCandidates[threadIndex];
+        lastThreadCandidates[threadIndex] = candidates;
+        doneIndices += threadProgresses[threadIndex].indices.load(std::memory_order_relaxed);
+    }
+    status.doneIndices = std::min(totalIndices, initialDoneIndices + doneIndices);
+
+    const double intervalSeconds = std::chrono::duration<double>(now - lastReportTime).count();
+    lastReportTime = now;
+    status.candidatesPerSecond = intervalSeconds > 0 ? intervalCandidates / intervalSeconds : 0;
+
+    // ETA is estimated by the average speed of the whole run, as chunks are completed unevenly.
+    status.etaSeconds = -1;
+    if(doneIndices != 0 && status.elapsedSeconds > 0)
+    {
+        status.etaSeconds = (totalIndices - status.doneIndices) * status.elapsedSeconds / doneIndices;
+    }
+
+    const auto minMax = std::minmax_element(status.threadCandidates.begin(), status.threadCandidates.end());
+    status.imbalancePercent = 0;
+    if(minMax.first != status.threadCandidates.end() && *minMax.second != 0)
+    {
+        status.imbalancePercent = 100.0 * (*minMax.second - *minMax.first) / *minMax.second;
+    }
+    return(status);
+}
+
+void ProgressReporter::report(const ProgressStatus &status)
+{
+    if(stream != nullptr)
+    {
+        // Status shares stream with warnings of search threads.
+        #pragma omp critical
+        {
+            *stream << status << std::endl;
+        }
+    }
+
+    if(!statusFileName.empty())
+    {
+        // Status is written into temporary file and renamed, so readers never see a partially written one.
+        // Failures are not fatal for search, the next status will be tried after the interval.
+        const std::string temporaryFileName = statusFileName + ".tmp";
+        {
+            std::ofstream output(temporaryFileName, std::ios_base::trunc);
+            writeJson(output, status);
+        }
+        if(std::rename(temporaryFileName.c_str(), statusFileName.c_str()) != 0)
+        {
+            std::remove(temporaryFileName.c_str());
+        }
+    }
+}
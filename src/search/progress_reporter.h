@@ -0,0 +1,124 @@
+#ifndef PROGRESS_REPORTER_H
+#define PROGRESS_REPORTER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <ostream>
+#include <cstdint>
+#include <cstddef>
+
+#include <boost/align/aligned_allocator.hpp>
+
+#include "candidate_source.h"
+
+/**
+ * Counters of progress of one search thread. Each thread writes only its own counters (so they are updated
+ * without locked instructions), and they take a whole cache line, so threads never write the same line.
+ * Counters are read by reporter thread at any time.
+ */
+struct alignas(64) ThreadProgress
+{
+    // Number of checked candidates.
+    std::atomic<std::uint64_t> candidates;
+    // Number of indices of candidate source in completed chunks.
+    std::atomic<KeyspaceIndex> indices;
+
+    ThreadProgress();
+
+    void addCandidates(std::uint64_t count);
+    void addIndices(KeyspaceIndex count);
+};
+
+/**
+ * Snapshot of progress of the whole search.
+ */
+struct ProgressStatus
+{
+    double elapsedSeconds;
+    // Indices of candidate source done (including ones completed before resume) and total in searched slice.
+    KeyspaceIndex doneIndices, totalIndices;
+    // Speed in the last interval.
+    double candidatesPerSecond;
+    // Estimated seconds until the end, negative if it is unknown yet.
+    double etaSeconds;
+    // Candidates checked by each thread in the last interval.
+    std::vector<std::uint64_t> threadCandidates;
+    // Difference between the busiest and the idlest threads in the last interval relative to the busiest one.
+    double imbalancePercent;
+    bool finished;
+
+    double getDonePercent() const;
+};
+
+std::ostream &operator<<(std::ostream &stream, const ProgressStatus &status);
+
+/**
+ * Writes status as JSON object.
+ */
+void writeJson(std::ostream &stream, const ProgressStatus &status);
+
+/**
+ * class ProgressReporter aggregates counters of all search threads by its own thread and reports speed,
+ * done part of searched slice, ETA and imbalance of threads every interval into stream and (or) status file
+ * as JSON. The status file is replaced atomically, so it could be read at any time.
+ */
+class ProgressReporter
+{
+private:
+    const std::chrono::steady_clock::duration interval;
+    std::ostream *stream;
+    const std::string statusFileName;
+    const KeyspaceIndex totalIndices, initialDoneIndices;
+
+    // Plain new doesn't guarantee extended alignment before C++17, so counters are allocated aligned explicitly.
+    std::vector<ThreadProgress, boost::alignment::aligned_allocator<ThreadProgress, alignof(ThreadProgress)>>
+        threadProgresses;
+    const std::size_t threadsCount;
+
+    std::chrono::steady_clock::time_point startTime, lastReportTime;
+    std::vector<std::uint64_t> lastThreadCandidates;
+
+    std::thread reporterThread;
+    std::mutex mutex;
+    std::condition_variable stopCondition;
+    bool stopRequested;
+
+    ProgressStatus collect(bool finished);
+    void report(const ProgressStatus &status);
+    void run();
+public:
+    /**
+     * Creates reporter of searched slice of totalIndices indices, initialDoneIndices of which have been done before
+     * (e.g. restored from checkpoint). If stream is null or statusFileName is empty, status isn't written there.
+     */
+    ProgressReporter(std::size_t threadsCount, KeyspaceIndex totalIndices, KeyspaceIndex initialDoneIndices,
+                     std::chrono::steady_clock::duration interval, std::ostream *stream,
+                     const std::string &statusFileName);
+    ~ProgressReporter();
+
+    ProgressReporter(const ProgressReporter &) = delete;
+    ProgressReporter &operator=(const ProgressReporter &) = delete;
+
+    /**
+     * Returns counters of thread with given index (less than threadsCount).
+     */
+    ThreadProgress &getThreadProgress(std::size_t threadIndex);
+
+    /**
+     * Starts reporting thread.
+     */
+    void start();
+
+    /**
+     * Stops reporting thread and reports final status. Called by destructor, if it hasn't been called before.
+     */
+    void stop();
+};
+
+#endif
@@ -0,0 +1,104 @@
+#include "result_channel.h"
+
+#include <chrono>
+
+#include "search_worker.h"
+
+ResultChannel::ResultChannel(const std::vector<SearchTarget> &targets, const SearchOptions &options,
+                             std::ostream &output):
+    targets(targets), options(options), output(output), foundCounts(new std::atomic<std::size_t>[targets.size()]),
+    satisfiedTargetsCount(0), cancelled(false), closed(false)
+{
+    for(std::size_t targetIndex = 0; targetIndex < targets.size(); ++targetIndex)
+    {
+        foundCounts[targetIndex] = 0;
+    }
+    outputThread = std::thread(&ResultChannel::run, this);
+}
+
+ResultChannel::~ResultChannel()
+{
+    close();
+}
+
+void ResultChannel::push(FoundPassword foundPassword)
+{
+    if(options.stopAfter != 0)
+    {
+        // Workers notice cancellation only between batches, so passwords found after the target has got
+        // enough of them are dropped, and at most stopAfter passwords are printed for each target.
+        const std::size_t foundCount = foundCounts[foundPassword.target].fetch_add(1) + 1;
+        if(foundCount > options.stopAfter)
+        {
+            return;
+        }
+        // Target is satisfied by exactly one password, so each target is counted once.
+        if(foundCount == options.stopAfter && satisfiedTargetsCount.fetch_add(1) + 1 == targets.size())
+        {
+            cancelled.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    queue.push(std::move(foundPassword));
+    // Output thread could miss notification, if it comes between check of queue and waiting,
+    // so it also wakes up periodically.
+    wakeUp.notify_one();
+}
+
+bool ResultChannel::isCancelled() const
+{
+    return(cancelled.load(std::memory_order_relaxed));
+}
+
+void ResultChannel::close()
+{
+    if(!outputThread.joinable())
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+    }
+    wakeUp.notify_one();
+    outputThread.join();
+}
+
+void ResultChannel::run()
+{
+    FoundPassword foundPassword;
+    std::unique_lock<std::mutex> lock(mutex);
+    while(true)
+    {
+        while(queue.tryPop(foundPassword))
+        {
+            print(foundPassword);
+        }
+        // Producers have finished before channel is closed, so the queue is empty for sure after this check.
+        if(closed)
+        {
+            while(queue.tryPop(foundPassword))
+            {
+                print(foundPassword);
+            }
+            return;
+        }
+        wakeUp.wait_for(lock, std::chrono::milliseconds(100));
+    }
+}
+
+void ResultChannel::print(const FoundPassword &foundPassword)
+{
+    // Only this thread writes into output during search, so lines of passwords are never mixed.
+    if(options.printFileNames)
+    {
+        output << targets[foundPassword.target].fileName << ":";
+    }
+    output << foundPassword.password << std::endl;
+
+    // Print decrypted text if needed
+    if(options.printDecryptedText)
+    {
+        output << foundPassword.decryptedText << std::endl;
+    }
+}
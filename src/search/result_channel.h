@@ -0,0 +1,85 @@
+#ifndef RESULT_CHANNEL_H
+#define RESULT_CHANNEL_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <ostream>
+#include <cstddef>
+
+#include "../util/mpsc_queue.h"
+
+struct SearchTarget;
+struct SearchOptions;
+
+/**
+ * Acceptable password found by a worker. Index of target is its position in targets of the search
+ * and decrypted text is kept only if it is printed.
+ */
+struct FoundPassword
+{
+    std::size_t target;
+    std::string password;
+    std::string decryptedText;
+};
+
+/**
+ * class ResultChannel passes acceptable passwords from search threads to its own output thread through lock-free
+ * queue, so workers never wait for each other or for output. Output thread prints passwords in the same format
+ * as before: after names of files, if options require so, and followed by decrypted texts.
+ * If options limit number of passwords (stopAfter), the channel is cancelled, when each target has got
+ * that many passwords, and workers stop the search at the next batch. Passwords found for a target after it has
+ * got that many of them are not printed.
+ */
+class ResultChannel
+{
+private:
+    const std::vector<SearchTarget> &targets;
+    const SearchOptions &options;
+    std::ostream &output;
+
+    MpscQueue<FoundPassword> queue;
+    // Number of passwords found for each target and number of targets, which have got stopAfter of them.
+    std::unique_ptr<std::atomic<std::size_t>[]> foundCounts;
+    std::atomic<std::size_t> satisfiedTargetsCount;
+    std::atomic<bool> cancelled;
+
+    std::thread outputThread;
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    bool closed;
+
+    void print(const FoundPassword &foundPassword);
+    void run();
+public:
+    /**
+     * Starts output thread, which prints into output.
+     */
+    ResultChannel(const std::vector<SearchTarget> &targets, const SearchOptions &options, std::ostream &output);
+    ~ResultChannel();
+
+    ResultChannel(const ResultChannel &) = delete;
+    ResultChannel &operator=(const ResultChannel &) = delete;
+
+    /**
+     * Passes found password to output thread or drops it, if its target has already got stopAfter passwords.
+     * Could be called by any thread.
+     */
+    void push(FoundPassword foundPassword);
+
+    /**
+     * Returns true, if enough passwords have been found and the search should stop.
+     */
+    bool isCancelled() const;
+
+    /**
+     * Prints all passed passwords and stops output thread. Called by destructor, if it hasn't been called before.
+     */
+    void close();
+};
+
+#endif
@@ -0,0 +1,360 @@
+#include "rules.h"
+
+#include <fstream>
+#include <sstream>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+
+// Number of arguments of each supported function.
+int getArgumentsCount(char code)
+{
+    switch(code)
+    {
+        case ':': case 'l': case 'u': case 'c': case 'C': case 't':
+        case 'r': case 'd': case 'f': case '[': case ']':
+            return(0);
+        case 'T': case '$': case '^': case '@':
+            return(1);
+        case 's':
+            return(2);
+        default:
+            return(-1);
+    }
+}
+
+bool isLower(unsigned char character)
+{
+    return(character >= 'a' && character <= 'z');
+}
+
+bool isUpper(unsigned char character)
+{
+    return(character >= 'A' && character <= 'Z');
+}
+
+unsigned char toLower(unsigned char character)
+{
+    return(isUpper(character) ? character - 'A' + 'a' : character);
+}
+
+unsigned char toUpper(unsigned char character)
+{
+    return(isLower(character) ? character - 'a' + 'A' : character);
+}
+
+unsigned char toggleCase(unsigned char character)
+{
+    return(isLower(character) ? toUpper(character) : toLower(character));
+}
+
+// Converts position argument 0-9, A-Z into number or returns ruleMaxResultLength for invalid one.
+std::size_t decodePosition(char position)
+{
+    if(position >= '0' && position <= '9')
+    {
+        return(position - '0');
+    }
+    if(position >= 'A' && position <= 'Z')
+    {
+        return(position - 'A' + 10);
+    }
+    return(ruleMaxResultLength);
+}
+
+/**
+ * Expands each base candidate into its variants by all rules. Base candidates are taken by batches
+ * from cursor of base source into a batch owned by this cursor, variants are written into storage
+ * of output batch. If output batch becomes full, expansion continues from the same rule on the next call.
+ */
+class RuledCandidateCursor: public CandidateCursor
+{
+private:
+    const std::vector<Rule> &rules;
+    std::unique_ptr<CandidateCursor> baseCursor;
+    CandidateBatch baseBatch;
+    std::size_t baseIndex, ruleIndex;
+    bool baseHasCandidates;
+
+public:
+    RuledCandidateCursor(const CandidateSource &base, const std::vector<Rule> &rules):
+        rules(rules), baseCursor(base.cursor()), baseBatch(64, base.getMaxLength()),
+        baseIndex(0), ruleIndex(0), baseHasCandidates(false)
+    {}
+
+    void seek(KeyspaceIndex first, KeyspaceIndex last) override
+    {
+        baseCursor->seek(first, last);
+        baseBatch.clear();
+        baseIndex = 0;
+        ruleIndex = 0;
+        baseHasCandidates = true;
+    }
+
+    bool fill(CandidateBatch &batch) override
+    {
+        while(!batch.full())
+        {
+            if(baseIndex == baseBatch.size())
+            {
+                if(!baseHasCandidates)
+                {
+                    return(false);
+                }
+                baseBatch.clear();
+                baseHasCandidates = baseCursor->fill(baseBatch);
+                baseIndex = 0;
+                continue;
+            }
+
+            const boost::string_view word = baseBatch[baseIndex];
+            unsigned char *slot = batch.getSlot();
+            const std::size_t length = rules[ruleIndex].apply(word.data(), word.size(), slot);
+            if(length != ruleRejected)
+            {
+                batch.push(slot, length);
+            }
+            if(++ruleIndex == rules.size())
+            {
+                ruleIndex = 0;
+                ++baseIndex;
+            }
+        }
+        return(baseIndex < baseBatch.size() || baseHasCandidates);
+    }
+};
+
+}
+
+Rule::Rule(const std::string &definition):
+    functions(), definition(definition)
+{
+    for(std::size_t position = 0; position < definition.size(); ++position)
+    {
+        const char code = definition[position];
+        if(code == ' ' || code == '\t')
+        {
+            continue;
+        }
+
+        const int argumentsCount = getArgumentsCount(code);
+        if(argumentsCount < 0)
+        {
+            throw std::invalid_argument("ERROR in Rule: unknown function '" + std::string(1, code) +
+                                        "' in rule \"" + definition + "\"");
+        }
+        if(position + argumentsCount >= definition.size())
+        {
+            throw std::invalid_argument("ERROR in Rule: function '" + std::string(1, code) +
+                                        "' misses arguments in rule \"" + definition + "\"");
+        }
+
+        Function function = {code, '\0', '\0'};
+        if(argumentsCount > 0)
+        {
+            function.first = definition[++position];
+        }
+        if(argumentsCount > 1)
+        {
+            function.second = definition[++position];
+        }
+        if(code == 'T' && decodePosition(function.first) == ruleMaxResultLength)
+        {
+            throw std::invalid_argument("ERROR in Rule: invalid position '" + std::string(1, function.first) +
+                                        "' in rule \"" + definition + "\"");
+        }
+        functions.push_back(function);
+    }
+}
+
+std::size_t Rule::apply(const char *word, std::size_t length, unsigned char *result) const
+{
+    if(length > ruleMaxResultLength)
+    {
+        return(ruleRejected);
+    }
+    std::copy_n(word, length, result);
+    unsigned char *end = result + length;
+
+    for(const Function &function: functions)
+    {
+        const std::size_t currentLength = end - result;
+        switch(function.code)
+        {
+            case 'l':
+                std::transform(result, end, result, toLower);
+                break;
+            case 'u':
+                std::transform(result, end, result, toUpper);
+                break;
+            case 'c':
+                std::transform(result, end, result, toLower);
+                if(currentLength > 0)
+                {
+                    result[0] = toUpper(result[0]);
+                }
+                break;
+            case 'C':
+                std::transform(result, end, result, toUpper);
+                if(currentLength > 0)
+                {
+                    result[0] = toLower(result[0]);
+                }
+                break;
+            case 't':
+                std::transform(result, end, result, toggleCase);
+                break;
+            case 'T':
+            {
+                const std::size_t position = decodePosition(function.first);
+                if(position < currentLength)
+                {
+                    result[position] = toggleCase(result[position]);
+                }
+                break;
+            }
+            case 'r':
+                std::reverse(result, end);
+                break;
+            case 'd':
+            case 'f':
+                if(2 * currentLength > ruleMaxResultLength)
+                {
+                    return(ruleRejected);
+                }
+                std::copy(result, end, end);
+                if(function.code == 'f')
+                {
+                    std::reverse(end, end + currentLength);
+                }
+                end += currentLength;
+                break;
+            case '$':
+            case '^':
+                if(currentLength == ruleMaxResultLength)
+                {
+                    return(ruleRejected);
+                }
+                if(function.code == '^')
+                {
+                    std::copy_backward(result, end, end + 1);
+                    result[0] = function.first;
+                }
+                else
+                {
+                    *end = function.first;
+                }
+                ++end;
+                break;
+            case '[':
+                if(currentLength > 0)
+                {
+                    std::copy(result + 1, end, result);
+                    --end;
+                }
+                break;
+            case ']':
+                if(currentLength > 0)
+                {
+                    --end;
+                }
+                break;
+            case 's':
+                std::replace(result, end, static_cast<unsigned char>(function.first),
+                             static_cast<unsigned char>(function.second));
+                break;
+            case '@':
+                end = std::remove(result, end, static_cast<unsigned char>(function.first));
+                break;
+            default:
+                break;
+        }
+    }
+    return(end - result);
+}
+
+const std::string &Rule::getDefinition() const
+{
+    return(definition);
+}
+
+std::vector<Rule> parseRules(std::istream &input)
+{
+    std::vector<Rule> rules;
+    std::string line;
+    for(std::size_t lineNumber = 1; std::getline(input, line); ++lineNumber)
+    {
+        if(!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+        if(line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+
+        try
+        {
+            rules.emplace_back(line);
+        }
+        catch(const std::invalid_argument &error)
+        {
+            std::ostringstream errorMessage;
+            errorMessage << error.what() << " on line " << lineNumber;
+            throw std::invalid_argument(errorMessage.str());
+        }
+    }
+
+    if(rules.empty())
+    {
+        throw std::invalid_argument("ERROR in parseRules: there are no rules");
+    }
+    return(rules);
+}
+
+std::vector<Rule> loadRules(const std::string &fileName)
+{
+    std::ifstream input(fileName);
+    if(!input)
+    {
+        throw std::runtime_error("ERROR in loadRules: can't open file " + fileName);
+    }
+    return(parseRules(input));
+}
+
+RuledCandidateSource::RuledCandidateSource(std::unique_ptr<const CandidateSource> base, std::vector<Rule> rules):
+    base(std::move(base)), rules(std::move(rules))
+{}
+
+KeyspaceIndex RuledCandidateSource::size() const
+{
+    return(base->size());
+}
+
+std::size_t RuledCandidateSource::getMaxLength() const
+{
+    return(ruleMaxResultLength);
+}
+
+KeyspaceIndex RuledCandidateSource::getDefaultChunkSize() const
+{
+    return(std::max<KeyspaceIndex>(1, base->getDefaultChunkSize() / rules.size()));
+}
+
+std::string RuledCandidateSource::getDescription() const
+{
+    std::string description = base->getDescription() + "\nrules " + std::to_string(rules.size());
+    for(const Rule &rule: rules)
+    {
+        description += "\n" + rule.getDefinition();
+    }
+    return(description);
+}
+
+std::unique_ptr<CandidateCursor> RuledCandidateSource::cursor() const
+{
+    return(std::unique_ptr<CandidateCursor>(new RuledCandidateCursor(*base, rules)));
+}
@@ -0,0 +1,99 @@
+#ifndef RULES_H
+#define RULES_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <istream>
+#include <cstddef>
+
+#include "candidate_source.h"
+
+/**
+ * Maximal length of word produced by a rule, longer results are rejected.
+ */
+constexpr std::size_t ruleMaxResultLength = 256;
+
+/**
+ * Value returned by Rule::apply for rejected words.
+ */
+constexpr std::size_t ruleRejected = static_cast<std::size_t>(-1);
+
+/**
+ * class Rule is a password mangling rule in a subset of hashcat syntax: a sequence of functions, which are
+ * applied to a word one after another. Spaces between functions are ignored. Supported functions:
+ *   :     do nothing              l     lowercase all          u     uppercase all
+ *   c     capitalize              C     invert capitalize      t     toggle case of all
+ *   TN    toggle case at N        r     reverse                d     duplicate
+ *   f     append reversed         $X    append X               ^X    prepend X
+ *   [     delete first            ]     delete last            sXY   replace all X with Y
+ *   @X    delete all X
+ * Positions N are 0-9 and A-Z for 10-35. Case functions affect ASCII letters only.
+ * Leetspeak is expressed by substitutions (e.g. "sa@ so0"), appending digits by appends (e.g. "$1 $2 $3").
+ */
+class Rule
+{
+private:
+    // Function code and up to two its arguments.
+    struct Function
+    {
+        char code, first, second;
+    };
+    std::vector<Function> functions;
+    std::string definition;
+
+public:
+    /**
+     * Parses rule. Throws std::invalid_argument if it contains unknown function or misses arguments.
+     */
+    explicit Rule(const std::string &definition);
+
+    /**
+     * Writes word transformed by the rule into result buffer of ruleMaxResultLength characters.
+     * Returns length of result or ruleRejected if word (or some intermediate result) is too long.
+     */
+    std::size_t apply(const char *word, std::size_t length, unsigned char *result) const;
+
+    const std::string &getDefinition() const;
+};
+
+/**
+ * Reads rules one per line, empty lines and lines starting with '#' are skipped.
+ * Throws std::invalid_argument if some rule is malformed (with number of line in message) or there are no rules.
+ */
+std::vector<Rule> parseRules(std::istream &input);
+
+/**
+ * Reads rules from file like parseRules. Throws std::exception if file can't be read or rules are malformed.
+ */
+std::vector<Rule> loadRules(const std::string &fileName);
+
+/**
+ * class RuledCandidateSource applies every rule to every candidate of base source. Indices are the same as of
+ * base source, so it is split between threads in the same way. Variants of base candidates are produced
+ * by each thread in its cursor right into storage of batch, so expanded candidates are never stored anywhere else.
+ */
+class RuledCandidateSource: public CandidateSource
+{
+private:
+    std::unique_ptr<const CandidateSource> base;
+    std::vector<Rule> rules;
+
+public:
+    RuledCandidateSource(std::unique_ptr<const CandidateSource> base, std::vector<Rule> rules);
+
+    KeyspaceIndex size() const override;
+
+    std::size_t getMaxLength() const override;
+
+    /**
+     * Default chunk of base source is divided by number of rules, so that a chunk takes roughly the same time.
+     */
+    KeyspaceIndex getDefaultChunkSize() const override;
+
+    std::string getDescription() const override;
+
+    std::unique_ptr<CandidateCursor> cursor() const override;
+};
+
+#endif
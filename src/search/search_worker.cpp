@@ -0,0 +1,188 @@
+#include "search_worker.h"
+
+#include <iostream>
+#include <algorithm>
+
+#include "../cryptography/md5_batch.h"
+
+#include "../util/crypto_exception.h"
+
+namespace
+{
+
+unsigned char *allocateDigests(ScratchArena &arena, std::size_t count)
+{
+    arena.reset(ScratchArena::getArraySize<unsigned char>(count * md5DigestSize));
+    return(arena.allocate<unsigned char>(count * md5DigestSize));
+}
+
+std::vector<ParsedFile> getParsedFiles(const std::vector<SearchTarget> &targets)
+{
+    std::vector<ParsedFile> parsedFiles;
+    for(const SearchTarget &target: targets)
+    {
+        parsedFiles.push_back(target.parsedFile);
+    }
+    return(parsedFiles);
+}
+
+}
+
+SearchWorker::SearchWorker(const std::vector<SearchTarget> &targets, const CandidateSource &candidates,
+                           const SearchOptions &options, ResultChannel &results,
+                           CheckpointRecorder *checkpointRecorder, ThreadProgress *threadProgress):
+    targets(targets),
+    multiTargetCheck(getParsedFiles(targets), options.usePaddingPrefilter, options.plaintextFilter,
+                     options.cryptoBackends),
+    md5Engine(createMd5Engine(options.cryptoBackends.md5)),
+    cursor(candidates.cursor()),
+    // Bitsliced 3DES processes as many keys as it has lanes, for checking keys one by one
+    // batch is only needed for computing MD5 at once.
+    batch(options.useBitslicedDes ? multiTargetCheck.getKeysBatchSize() : 64, candidates.getMaxLength()),
+    batchArena(),
+    batchDigests(allocateDigests(batchArena, batch.getCapacity())),
+    acceptableKeys(targets.size(), boost::dynamic_bitset<>(batch.getCapacity())),
+    options(options),
+    results(results),
+    checkpointRecorder(checkpointRecorder),
+    threadProgress(threadProgress),
+    acceptablePasswordsCount(0)
+{}
+
+void SearchWorker::processChunk(KeyspaceIndex first, KeyspaceIndex last)
+{
+    cursor->seek(first, last);
+    bool hasCandidates = true;
+    while(hasCandidates)
+    {
+        // Cancellation is checked between batches, so workers stop soon after enough passwords are found.
+        if(results.isCancelled())
+        {
+            return;
+        }
+        batch.clear();
+        hasCandidates = cursor->fill(batch);
+        checkBatch();
+    }
+    
+    // Chunk is recorded only when it is checked completely, so interrupted chunk is checked again after resume.
+    if(checkpointRecorder != nullptr)
+    {
+        checkpointRecorder->recordCompleted(first, last);
+    }
+    if(threadProgress != nullptr)
+    {
+        threadProgress->addIndices(last - first);
+    }
+}
+
+void SearchWorker::checkBatch()
+{
+    if(batch.size() == 0)
+    {
+        return;
+    }
+    if(threadProgress != nullptr)
+    {
+        threadProgress->addCandidates(batch.size());
+    }
+    
+    md5Engine->hashBatch(batch.getCandidates(), batch.getLengths(), batch.size(), batchDigests);
+    
+    if(options.useBitslicedDes)
+    {
+        try
+        {
+            multiTargetCheck.checkKeys(batchDigests, batch.size(), acceptableKeys);
+        }
+        catch(const CryptoException &)
+        {
+            // If something went wring in cryptography algorithms, we fall back to checking passwords one by one,
+            // which will report passwords causing problems.
+            for(boost::dynamic_bitset<> &targetAcceptableKeys: acceptableKeys)
+            {
+                targetAcceptableKeys.resize(batch.size());
+                targetAcceptableKeys.set();
+            }
+        }
+    }
+    else
+    {
+        // Keys are checked against each target by a batch call, so there are no branches on results per key.
+        for(std::size_t targetIndex = 0; targetIndex < targets.size(); ++targetIndex)
+        {
+            try
+            {
+                multiTargetCheck.getTarget(targetIndex).checkKeys(batchDigests, batch.size(),
+                                                                  acceptableKeys[targetIndex]);
+            }
+            catch(const CryptoException &)
+            {
+                acceptableKeys[targetIndex].resize(batch.size());
+                acceptableKeys[targetIndex].set();
+            }
+        }
+    }
+    
+    for(std::size_t targetIndex = 0; targetIndex < targets.size(); ++targetIndex)
+    {
+        // Acceptable keys are checked once more one by one, which keeps decrypted text (and reports exceptions).
+        const boost::dynamic_bitset<> &targetAcceptableKeys = acceptableKeys[targetIndex];
+        for(std::size_t batchIndex = targetAcceptableKeys.find_first(); batchIndex != boost::dynamic_bitset<>::npos;
+            batchIndex = targetAcceptableKeys.find_next(batchIndex))
+        {
+            // We print all acceptable passwords, even if there would be multiple of them.
+            // Such may happened, if different decrypted messages have SHA256 collision.
+            if(isBatchPasswordAcceptable(targetIndex, batchIndex))
+            {
+                reportAcceptablePassword(targetIndex, batch[batchIndex].to_string());
+            }
+        }
+    }
+}
+
+bool SearchWorker::isBatchPasswordAcceptable(std::size_t targetIndex, std::size_t batchIndex)
+{
+    try
+    {
+        return(multiTargetCheck.getTarget(targetIndex).isKeyAcceptable(batchDigests +
+                                                                       batchIndex * md5DigestSize));
+    }
+    catch(const CryptoException &cryptoException)
+    {
+        // If something went wring in cryptography algorithms, we just skip this picked password
+        // and print this warning.
+        #pragma omp critical
+        {
+            std::cerr << "WARNING: Processing password \"" << batch[batchIndex] << "\" for "
+                      << targets[targetIndex].fileName << " some exceptions appeared." << std::endl;
+            std::cerr << "         Skipping current password!" << std::endl;
+            std::cerr << cryptoException.what() << std::endl;
+        }
+        return(false);
+    }
+}
+
+std::size_t SearchWorker::getAcceptablePasswordsCount() const
+{
+    return(acceptablePasswordsCount);
+}
+
+void SearchWorker::reportAcceptablePassword(std::size_t targetIndex, const std::string &acceptablePassword)
+{
+    if(checkpointRecorder != nullptr &&
+       !checkpointRecorder->recordAcceptablePassword(targets[targetIndex].index, acceptablePassword))
+    {
+        return;
+    }
+    ++acceptablePasswordsCount;
+    
+    // Output thread prints the password, so worker only copies it (and decrypted text, which is overwritten
+    // by the next checked password) into the channel.
+    FoundPassword foundPassword = {targetIndex, acceptablePassword, std::string()};
+    if(options.printDecryptedText)
+    {
+        foundPassword.decryptedText = multiTargetCheck.getTarget(targetIndex).getDecryptedText();
+    }
+    results.push(std::move(foundPassword));
+}
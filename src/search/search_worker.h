@@ -0,0 +1,116 @@
+#ifndef SEARCH_WORKER_H
+#define SEARCH_WORKER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <ostream>
+
+#include <boost/dynamic_bitset.hpp>
+
+#include "../io/parse_file.h"
+#include "../cryptography/multi_target_check.h"
+#include "../util/scratch_arena.h"
+#include "candidate_source.h"
+#include "checkpoint.h"
+#include "progress_reporter.h"
+#include "result_channel.h"
+
+/**
+ * Options of password search, which are common for all workers.
+ */
+struct SearchOptions
+{
+    // Number of consecutive indices of candidate source processed by a worker at once.
+    std::size_t chunkSize;
+    bool printDecryptedText;
+    // Whether passwords are rejected by checking padding of the last block before full decryption.
+    bool usePaddingPrefilter;
+    // What is known about the beginning of original texts, passwords are rejected by their first blocks.
+    PlaintextFilter plaintextFilter;
+    // Whether keys of the whole batch are checked at once by bitsliced 3DES or one by one by libgcrypt.
+    bool useBitslicedDes;
+    // Whether acceptable passwords are printed after name of cipher file, as there are several of them.
+    bool printFileNames;
+    // Implementations of MD5 of batches and of 3DES and SHA256 of checking keys one by one.
+    CryptoBackends cryptoBackends;
+    // Search stops, when each target has got this number of acceptable passwords. 0 means no limit.
+    std::size_t stopAfter = 0;
+};
+
+/**
+ * Cipher file, password of which is searched.
+ */
+struct SearchTarget
+{
+    std::string fileName;
+    ParsedFile parsedFile;
+    // Index of target among all targets of the search, which identifies it in checkpoint.
+    std::size_t index;
+};
+
+/**
+ * Class SearchWorker holds all the state needed by one thread to check passwords against all targets:
+ * its own MultiTargetCheck object and buffers for the current batch of passwords.
+ * Worker processes passwords by contiguous chunks of indices of candidate source. Inside a chunk, candidates are
+ * enumerated sequentially into a reused batch (generated ones into its storage, existing ones by pointers),
+ * so there are no allocations per password.
+ * Passwords are collected in batches, MD5 of the whole batch is computed at once (by multi-buffer kernel
+ * with built-in backend) and then keys are checked against all targets (all at once with bitsliced 3DES
+ * or one by one), so MD5 and key schedule of each password are computed once for all targets.
+ * Objects of this class are not thread safe, each thread should construct its own one.
+ */
+class SearchWorker
+{
+private:
+    const std::vector<SearchTarget> &targets;
+    MultiTargetCheck multiTargetCheck;
+    std::unique_ptr<Md5Engine> md5Engine;
+    std::unique_ptr<CandidateCursor> cursor;
+    
+    CandidateBatch batch;
+    // Scratch of the worker for its batch, which is allocated once at cache line boundary, so buffers
+    // of different workers never share a line. It keeps MD5 digests of passwords of the batch.
+    ScratchArena batchArena;
+    unsigned char *batchDigests;
+    // Bit i of acceptableKeys[target] is set, if i-th password of batch passes check of the whole batch
+    // (bitsliced or one by one) against the target.
+    std::vector<boost::dynamic_bitset<>> acceptableKeys;
+    
+    const SearchOptions &options;
+    ResultChannel &results;
+    CheckpointRecorder *checkpointRecorder;
+    ThreadProgress *threadProgress;
+    
+    std::size_t acceptablePasswordsCount;
+    
+    void checkBatch();
+    bool isBatchPasswordAcceptable(std::size_t targetIndex, std::size_t batchIndex);
+    void reportAcceptablePassword(std::size_t targetIndex, const std::string &acceptablePassword);
+public:
+    /**
+     * If checkpointRecorder is given, completed chunks and acceptable passwords are recorded into it.
+     * If threadProgress is given, checked candidates and indices of completed chunks are counted in it.
+     */
+    SearchWorker(const std::vector<SearchTarget> &targets, const CandidateSource &candidates,
+                 const SearchOptions &options, ResultChannel &results,
+                 CheckpointRecorder *checkpointRecorder = nullptr, ThreadProgress *threadProgress = nullptr);
+    
+    SearchWorker(const SearchWorker &) = delete;
+    SearchWorker &operator=(const SearchWorker &) = delete;
+    
+    /**
+     * Checks all passwords with indices [first, last) in candidate source, passed in construction,
+     * and passes acceptable ones into results. If results channel is cancelled, checking stops after the current
+     * batch and the chunk isn't recorded as completed.
+     */
+    void processChunk(KeyspaceIndex first, KeyspaceIndex last);
+    
+    /**
+     * Returns number of acceptable passwords found by this worker.
+     */
+    std::size_t getAcceptablePasswordsCount() const;
+};
+
+#endif
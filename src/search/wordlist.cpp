@@ -0,0 +1,106 @@
+#include "wordlist.h"
+
+#include <cstring>
+
+#include <boost/filesystem.hpp>
+
+namespace
+{
+
+/**
+ * Enumerates words of part of wordlist. Each word is found by memchr and is referenced in place.
+ */
+class WordlistCursor: public CandidateCursor
+{
+private:
+    const char *data, *dataEnd;
+    const char *position, *partEnd;
+
+    const char *findLineEnd(const char *lineStart) const
+    {
+        const void *lineEnd = std::memchr(lineStart, '\n', dataEnd - lineStart);
+        return(lineEnd != nullptr ? static_cast<const char *>(lineEnd) : dataEnd);
+    }
+
+public:
+    explicit WordlistCursor(const Wordlist &wordlist):
+        data(wordlist.getData()), dataEnd(wordlist.getData() + wordlist.size()), position(data), partEnd(data)
+    {}
+
+    void seek(KeyspaceIndex first, KeyspaceIndex last) override
+    {
+        // Word which starts before the part belongs to previous part, even if it ends inside this one.
+        position = data + first;
+        if(first > 0 && data[first - 1] != '\n')
+        {
+            position = findLineEnd(position);
+            position += position != dataEnd ? 1 : 0;
+        }
+        partEnd = data + last;
+    }
+
+    bool fill(CandidateBatch &batch) override
+    {
+        while(position < partEnd && !batch.full())
+        {
+            const char *lineEnd = findLineEnd(position);
+            std::size_t length = lineEnd - position;
+            if(length > 0 && position[length - 1] == '\r')
+            {
+                --length;
+            }
+            if(length > 0)
+            {
+                batch.push(reinterpret_cast<const unsigned char *>(position), length);
+            }
+            position = lineEnd != dataEnd ? lineEnd + 1 : dataEnd;
+        }
+        return(position < partEnd);
+    }
+};
+
+}
+
+Wordlist::Wordlist(const std::string &fileName):
+    fileName(fileName), file(), data(nullptr), fileSize(0)
+{
+    // Empty file can't be mapped, but it is just an empty wordlist.
+    if(boost::filesystem::file_size(fileName) == 0)
+    {
+        return;
+    }
+    file.open(fileName);
+    data = file.data();
+    fileSize = file.size();
+}
+
+KeyspaceIndex Wordlist::size() const
+{
+    return(fileSize);
+}
+
+std::size_t Wordlist::getMaxLength() const
+{
+    return(0);
+}
+
+KeyspaceIndex Wordlist::getDefaultChunkSize() const
+{
+    // Chunks of wordlist are measured in bytes, one megabyte is about a hundred thousand of words.
+    return(1 << 20);
+}
+
+std::string Wordlist::getDescription() const
+{
+    return("wordlist " + std::to_string(fileSize) + " " + fileName);
+}
+
+std::unique_ptr<CandidateCursor> Wordlist::cursor() const
+{
+    return(std::unique_ptr<CandidateCursor>(new WordlistCursor(*this)));
+}
+
+const char *Wordlist::getData() const
+{
+    return(data);
+}
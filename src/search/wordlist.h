@@ -0,0 +1,52 @@
+#ifndef WORDLIST_H
+#define WORDLIST_H
+
+#include <string>
+#include <memory>
+#include <cstddef>
+
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include "candidate_source.h"
+
+/**
+ * class Wordlist is a candidate source of words of a dictionary file, one word per line (Unix or Windows
+ * line endings, empty lines are skipped). The file is memory mapped, so it could be larger than memory,
+ * and words are passed into batches as pointers into the mapping without copying.
+ * Indices of wordlist are byte offsets: a part [first, last) consists of words, which start in it,
+ * so parts are aligned to lines and any split of file checks each word exactly once.
+ */
+class Wordlist: public CandidateSource
+{
+private:
+    const std::string fileName;
+    boost::iostreams::mapped_file_source file;
+    const char *data;
+    std::size_t fileSize;
+
+public:
+    /**
+     * Maps given file into memory. Throws std::exception (filesystem or stream error) if it can't be opened.
+     */
+    explicit Wordlist(const std::string &fileName);
+
+    KeyspaceIndex size() const override;
+
+    /**
+     * Words are never copied into storage of batch, so this function returns 0.
+     */
+    std::size_t getMaxLength() const override;
+
+    KeyspaceIndex getDefaultChunkSize() const override;
+
+    /**
+     * Wordlist is identified by its file name and size.
+     */
+    std::string getDescription() const override;
+
+    std::unique_ptr<CandidateCursor> cursor() const override;
+
+    const char *getData() const;
+};
+
+#endif
@@ -0,0 +1,240 @@
+#include "work_stealing_scheduler.h"
+
+#include <boost/filesystem.hpp>
+
+#include <thread>
+#include <exception>
+#include <algorithm>
+#include <string>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+WorkStealingScheduler::Tasks::Tasks(WorkStealingScheduler &scheduler, std::size_t threadIndex):
+    scheduler(scheduler), threadIndex(threadIndex)
+{}
+
+bool WorkStealingScheduler::Tasks::next(KeyspaceIndex &task)
+{
+    TaskRange &taskRange = scheduler.taskRanges[threadIndex];
+    {
+        std::lock_guard<std::mutex> lock(taskRange.mutex);
+        if(taskRange.begin < taskRange.end)
+        {
+            task = taskRange.begin++;
+            return(true);
+        }
+    }
+    return(scheduler.steal(threadIndex, task));
+}
+
+WorkStealingScheduler::WorkStealingScheduler(std::size_t threadsCount, bool pinThreads):
+    threadsCount(std::max<std::size_t>(threadsCount, 1)), pinThreads(pinThreads),
+    threadCpus(this->threadsCount, -1), threadNodes(this->threadsCount, 0),
+    taskRanges(this->threadsCount), runBody(nullptr), runsCount(0), runningThreadsCount(0),
+    stopping(false)
+{
+    if(pinThreads)
+    {
+        const std::vector<int> cpus = getAvailableCpus();
+        for(std::size_t threadIndex = 0; threadIndex < this->threadsCount && !cpus.empty(); ++threadIndex)
+        {
+            threadCpus[threadIndex] = cpus[threadIndex % cpus.size()];
+            threadNodes[threadIndex] = getCpuNode(threadCpus[threadIndex]);
+        }
+    }
+}
+
+std::size_t WorkStealingScheduler::getThreadsCount() const
+{
+    return(threadsCount);
+}
+
+WorkStealingScheduler::~WorkStealingScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(runMutex);
+        stopping = true;
+    }
+    runStarted.notify_all();
+    for(std::thread &thread: threads)
+    {
+        thread.join();
+    }
+}
+
+void WorkStealingScheduler::run(KeyspaceIndex tasksCount, const std::function<void(std::size_t, Tasks &)> &body)
+{
+    // Tasks are split into contiguous ranges of nearly equal size.
+    for(std::size_t threadIndex = 0; threadIndex < threadsCount; ++threadIndex)
+    {
+        taskRanges[threadIndex].begin = tasksCount / threadsCount * threadIndex +
+                                        std::min<KeyspaceIndex>(threadIndex, tasksCount % threadsCount);
+        taskRanges[threadIndex].end = tasksCount / threadsCount * (threadIndex + 1) +
+                                      std::min<KeyspaceIndex>(threadIndex + 1, tasksCount % threadsCount);
+    }
+
+    std::unique_lock<std::mutex> lock(runMutex);
+    if(threads.empty())
+    {
+        for(std::size_t threadIndex = 0; threadIndex < threadsCount; ++threadIndex)
+        {
+            threads.emplace_back(&WorkStealingScheduler::runThread, this, threadIndex);
+        }
+    }
+    runBody = &body;
+    runningThreadsCount = threadsCount;
+    ++runsCount;
+    runStarted.notify_all();
+    runFinished.wait(lock, [this]()
+                     {
+                         return(runningThreadsCount == 0);
+                     });
+    runBody = nullptr;
+
+    std::exception_ptr exception;
+    std::swap(exception, firstException);
+    lock.unlock();
+    if(exception)
+    {
+        std::rethrow_exception(exception);
+    }
+}
+
+void WorkStealingScheduler::runThread(std::size_t threadIndex)
+{
+#ifdef __linux__
+    // Thread is pinned before its worker allocates anything, so the memory is placed on its node.
+    // If pinning fails (e.g. CPU has gone offline), thread just runs unpinned.
+    if(threadCpus[threadIndex] >= 0)
+    {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(threadCpus[threadIndex], &cpuSet);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+    }
+#endif
+    std::uint64_t finishedRunsCount = 0;
+    std::unique_lock<std::mutex> lock(runMutex);
+    while(true)
+    {
+        runStarted.wait(lock, [this, &finishedRunsCount]()
+                        {
+                            return(stopping || runsCount != finishedRunsCount);
+                        });
+        if(stopping)
+        {
+            return;
+        }
+        finishedRunsCount = runsCount;
+        const std::function<void(std::size_t, Tasks &)> &body = *runBody;
+        lock.unlock();
+
+        std::exception_ptr exception;
+        try
+        {
+            Tasks tasks(*this, threadIndex);
+            body(threadIndex, tasks);
+        }
+        catch(...)
+        {
+            exception = std::current_exception();
+        }
+
+        lock.lock();
+        if(exception && !firstException)
+        {
+            firstException = exception;
+        }
+        if(--runningThreadsCount == 0)
+        {
+            runFinished.notify_one();
+        }
+    }
+}
+
+bool WorkStealingScheduler::steal(std::size_t threadIndex, KeyspaceIndex &task)
+{
+    // Victims on the same node are tried first, as their tasks are continued with data in the same memory.
+    for(const bool sameNode: {true, false})
+    {
+        for(std::size_t offset = 1; offset < threadsCount; ++offset)
+        {
+            const std::size_t victimIndex = (threadIndex + offset) % threadsCount;
+            if((threadNodes[victimIndex] == threadNodes[threadIndex]) != sameNode)
+            {
+                continue;
+            }
+
+            // Only one lock is held at once, so threads stealing from each other never deadlock.
+            KeyspaceIndex stolenBegin, stolenEnd;
+            {
+                TaskRange &victimRange = taskRanges[victimIndex];
+                std::lock_guard<std::mutex> lock(victimRange.mutex);
+                if(victimRange.begin >= victimRange.end)
+                {
+                    continue;
+                }
+                stolenEnd = victimRange.end;
+                stolenBegin = victimRange.end - (victimRange.end - victimRange.begin + 1) / 2;
+                victimRange.end = stolenBegin;
+            }
+
+            task = stolenBegin;
+            TaskRange &taskRange = taskRanges[threadIndex];
+            std::lock_guard<std::mutex> lock(taskRange.mutex);
+            taskRange.begin = stolenBegin + 1;
+            taskRange.end = stolenEnd;
+            return(true);
+        }
+    }
+    return(false);
+}
+
+std::vector<int> WorkStealingScheduler::getAvailableCpus()
+{
+    std::vector<int> cpus;
+#ifdef __linux__
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    if(sched_getaffinity(0, sizeof(cpuSet), &cpuSet) == 0)
+    {
+        for(int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if(CPU_ISSET(cpu, &cpuSet))
+            {
+                cpus.push_back(cpu);
+            }
+        }
+        return(cpus);
+    }
+#endif
+    for(unsigned int cpu = 0; cpu < std::thread::hardware_concurrency(); ++cpu)
+    {
+        cpus.push_back(cpu);
+    }
+    return(cpus);
+}
+
+int WorkStealingScheduler::getCpuNode(int cpu)
+{
+    // Linux lists node of CPU as link nodeN in its directory.
+    boost::system::error_code error;
+    const boost::filesystem::path cpuDirectory("/sys/devices/system/cpu/cpu" + std::to_string(cpu));
+    for(boost::filesystem::directory_iterator entry(cpuDirectory, error), end; !error && entry != end;
+        entry.increment(error))
+    {
+        const std::string name = entry->path().filename().string();
+        if(name.size() > 4 && name.compare(0, 4, "node") == 0 &&
+           std::all_of(name.begin() + 4, name.end(), [](char character)
+                       {
+                           return(character >= '0' && character <= '9');
+                       }))
+        {
+            return(std::stoi(name.substr(4)));
+        }
+    }
+    return(0);
+}
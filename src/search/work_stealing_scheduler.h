@@ -0,0 +1,110 @@
+#ifndef WORK_STEALING_SCHEDULER_H
+#define WORK_STEALING_SCHEDULER_H
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+#include <exception>
+#include <cstdint>
+#include <cstddef>
+
+#include <boost/align/aligned_allocator.hpp>
+
+#include "candidate_source.h"
+
+/**
+ * class WorkStealingScheduler runs tasks with indices [0, tasksCount) (e.g. chunks of candidate source)
+ * in its own threads. Each thread starts with a contiguous range of tasks, so neighbouring chunks are processed
+ * by the same thread, and takes tasks from its beginning. A thread, which has run out of tasks, steals the second
+ * half of the range of another thread, preferring threads on the same NUMA node.
+ * Threads could be pinned to CPUs, then everything a thread allocates after start (buffers and cipher state
+ * of its worker) is placed by the kernel on memory of its own node and never migrates to another one.
+ * Threads are started (and pinned) by the first run and wait for the next one after it, so a long-lived scheduler
+ * (e.g. of daemon) pays for them once instead of once per run.
+ */
+class WorkStealingScheduler
+{
+private:
+    // Range of tasks of a thread, which takes a whole cache line, so threads taking their tasks never share lines.
+    struct alignas(64) TaskRange
+    {
+        std::mutex mutex;
+        KeyspaceIndex begin = 0, end = 0;
+    };
+
+    const std::size_t threadsCount;
+    const bool pinThreads;
+    // CPU of each thread (if threads are pinned) and its NUMA node.
+    std::vector<int> threadCpus, threadNodes;
+    // Plain new doesn't guarantee extended alignment before C++17, so ranges are allocated aligned explicitly.
+    std::vector<TaskRange, boost::alignment::aligned_allocator<TaskRange, alignof(TaskRange)>> taskRanges;
+
+    bool steal(std::size_t threadIndex, KeyspaceIndex &task);
+
+public:
+    /**
+     * Handle of a thread for taking its tasks.
+     */
+    class Tasks
+    {
+    private:
+        WorkStealingScheduler &scheduler;
+        const std::size_t threadIndex;
+
+    public:
+        Tasks(WorkStealingScheduler &scheduler, std::size_t threadIndex);
+
+        /**
+         * Takes the next task of the thread or steals one from others. Returns false, if all tasks are taken.
+         */
+        bool next(KeyspaceIndex &task);
+    };
+
+private:
+    // Threads wait for a new run (or for stopping) and the caller of run waits for all of them to finish it.
+    std::vector<std::thread> threads;
+    std::mutex runMutex;
+    std::condition_variable runStarted, runFinished;
+    const std::function<void(std::size_t, Tasks &)> *runBody;
+    std::uint64_t runsCount;
+    std::size_t runningThreadsCount;
+    std::exception_ptr firstException;
+    bool stopping;
+
+    void runThread(std::size_t threadIndex);
+
+public:
+    /**
+     * Creates scheduler of threadsCount threads (at least one). If pinThreads is set, thread i is pinned to i-th
+     * (modulo their number) of CPUs available for the process.
+     */
+    WorkStealingScheduler(std::size_t threadsCount, bool pinThreads);
+    ~WorkStealingScheduler();
+
+    WorkStealingScheduler(const WorkStealingScheduler &) = delete;
+    WorkStealingScheduler &operator=(const WorkStealingScheduler &) = delete;
+
+    std::size_t getThreadsCount() const;
+
+    /**
+     * Runs body(threadIndex, tasks) in each thread and waits for all of them. Body should process tasks taken
+     * by tasks.next(), each task is taken exactly once. The first exception thrown by body is rethrown after
+     * all threads have finished. Runs are not concurrent: run must not be called before the previous one returns.
+     */
+    void run(KeyspaceIndex tasksCount, const std::function<void(std::size_t, Tasks &)> &body);
+
+    /**
+     * Returns CPUs, which the process is allowed to run on.
+     */
+    static std::vector<int> getAvailableCpus();
+
+    /**
+     * Returns NUMA node of CPU or 0, if it is unknown.
+     */
+    static int getCpuNode(int cpu);
+};
+
+#endif
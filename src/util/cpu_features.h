@@ -0,0 +1,125 @@
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+#include <string>
+#include <ostream>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+/**
+ * Levels of SIMD instruction sets, which multi-buffer cryptography kernels are specialized for.
+ * Kernels for each level are compiled in the same binary with target attributes,
+ * the level to be used is chosen at runtime.
+ */
+enum class SimdLevel
+{
+    Scalar,
+    AVX2,
+    AVX512
+};
+
+/**
+ * Instruction set extensions of current CPU, which are supported by operating system too.
+ * Flag avx512 means both AVX-512F and AVX-512VL (the latter allows 512 bit instructions on narrower vectors).
+ */
+struct CpuFeatures
+{
+    bool avx2, avx512, sha;
+};
+
+/**
+ * Detects features of current CPU with cpuid instruction. Result is computed once and cached.
+ * On non x86 platforms no features are reported.
+ */
+inline const CpuFeatures &getCpuFeatures()
+{
+    static const CpuFeatures cpuFeatures = []()
+    {
+        CpuFeatures features = {false, false, false};
+#if defined(__x86_64__) || defined(__i386__)
+        unsigned int eax, ebx, ecx, edx;
+        if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        {
+            return(features);
+        }
+
+        // AVX registers are usable only if operating system saves them on context switch (OSXSAVE and XCR0 bits).
+        const bool hasOsxsave = ecx & bit_OSXSAVE;
+        unsigned int xcr0 = 0;
+        if(hasOsxsave)
+        {
+            unsigned int xcr0High;
+            __asm__("xgetbv" : "=a"(xcr0), "=d"(xcr0High) : "c"(0));
+        }
+        const bool osSavesYmm = (xcr0 & 0x6) == 0x6;
+        const bool osSavesZmm = (xcr0 & 0xe6) == 0xe6;
+
+        if(__get_cpuid_max(0, nullptr) < 7)
+        {
+            return(features);
+        }
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        features.avx2 = osSavesYmm && (ebx & bit_AVX2);
+        features.avx512 = osSavesZmm && (ebx & bit_AVX512F) && (ebx & bit_AVX512VL);
+        features.sha = ebx & bit_SHA;
+#endif
+        return(features);
+    }();
+
+    return(cpuFeatures);
+}
+
+/**
+ * Returns the widest SIMD level supported by current CPU.
+ */
+inline SimdLevel getBestSimdLevel()
+{
+    const CpuFeatures &features = getCpuFeatures();
+    if(features.avx512)
+    {
+        return(SimdLevel::AVX512);
+    }
+    if(features.avx2)
+    {
+        return(SimdLevel::AVX2);
+    }
+    return(SimdLevel::Scalar);
+}
+
+/**
+ * Returns true if kernels of given SIMD level can be executed on current CPU.
+ */
+inline bool isSimdLevelSupported(SimdLevel simdLevel)
+{
+    switch(simdLevel)
+    {
+        case SimdLevel::AVX512:
+            return(getCpuFeatures().avx512);
+        case SimdLevel::AVX2:
+            return(getCpuFeatures().avx2);
+        default:
+            return(true);
+    }
+}
+
+inline std::string toString(SimdLevel simdLevel)
+{
+    switch(simdLevel)
+    {
+        case SimdLevel::AVX512:
+            return("avx512");
+        case SimdLevel::AVX2:
+            return("avx2");
+        default:
+            return("scalar");
+    }
+}
+
+inline std::ostream &operator<<(std::ostream &stream, SimdLevel simdLevel)
+{
+    return(stream << toString(simdLevel));
+}
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef CRYPTO_EXCEPTION_H
+#define CRYPTO_EXCEPTION_H
+
+#include <exception>
+#include <string>
+
+/**
+ * Class CryptoException is a base of exceptions thrown by cryptography libraries' wrappers
+ * (see GcryException and OpenSslException), so errors of any backend are handled in the same way.
+ */
+class CryptoException: public std::exception
+{
+protected:
+    std::string message;
+public:
+    CryptoException() = default;
+    explicit CryptoException(const std::string &message): message(message) {}
+    
+    virtual const char *what() const noexcept override
+    {
+        return(message.c_str());
+    }
+};
+
+#endif
@@ -7,15 +7,15 @@
 
 #include <gcrypt.h>
 
+#include "crypto_exception.h"
+
 /**
  * Class GcryException is intended to handle errors from libgcrypt library.
  * By taking as constructor parameter gcry_error_t it creates a error message translating
  * given error code into a error description and error source.
  */
-class GcryException: public std::exception
+class GcryException: public CryptoException
 {
-private:
-    std::string message;
 public:
     GcryException(const gcry_error_t &gcryError)
     {
@@ -31,11 +31,6 @@ public:
         }
         message = errorMessage.str();
     }
-    
-    virtual const char *what() const noexcept override
-    {
-        return(message.c_str());
-    }
 };
 
 /**
@@ -0,0 +1,78 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+#include <utility>
+
+/**
+ * Class MpscQueue is an unbounded lock-free queue of many producers and a single consumer (D. Vyukov's algorithm).
+ * Producers link a new node by a single atomic exchange, so pushing never waits for other threads, while
+ * the consumer follows links from the oldest node. Values must be default constructible, as the queue always
+ * keeps one node, the value of which has already been popped (or is a stub).
+ */
+template<class Value>
+class MpscQueue
+{
+private:
+    struct Node
+    {
+        std::atomic<Node *> next;
+        Value value;
+
+        Node(): next(nullptr), value() {}
+        explicit Node(Value &&value): next(nullptr), value(std::move(value)) {}
+    };
+
+    // The newest node, producers replace it.
+    std::atomic<Node *> head;
+    // The oldest node, which is owned by consumer: its value has been popped.
+    Node *tail;
+
+public:
+    MpscQueue():
+        head(new Node()), tail(head.load())
+    {}
+
+    ~MpscQueue()
+    {
+        while(tail != nullptr)
+        {
+            Node *next = tail->next.load(std::memory_order_relaxed);
+            delete tail;
+            tail = next;
+        }
+    }
+
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    /**
+     * Adds value to the end of queue. Could be called by any thread.
+     */
+    void push(Value value)
+    {
+        Node *node = new Node(std::move(value));
+        Node *previous = head.exchange(node, std::memory_order_acq_rel);
+        // Until this store the node is invisible for consumer, so it sees values of each producer in order.
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    /**
+     * Moves the oldest value into value and returns true, or returns false if the queue is empty (or the next
+     * node is being linked right now). Must be called by a single thread only.
+     */
+    bool tryPop(Value &value)
+    {
+        Node *next = tail->next.load(std::memory_order_acquire);
+        if(next == nullptr)
+        {
+            return(false);
+        }
+        value = std::move(next->value);
+        delete tail;
+        tail = next;
+        return(true);
+    }
+};
+
+#endif
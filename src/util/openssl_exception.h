@@ -0,0 +1,48 @@
+#ifndef OPENSSL_EXCEPTION_H
+#define OPENSSL_EXCEPTION_H
+
+#include <sstream>
+#include <string>
+
+#include <openssl/err.h>
+
+#include "crypto_exception.h"
+
+/**
+ * Class OpenSslException is intended to handle errors from OpenSSL library. Its message describes
+ * the earliest error from error queue of current thread, the queue is cleared.
+ */
+class OpenSslException: public CryptoException
+{
+public:
+    OpenSslException()
+    {
+        // Error queue is thread local, so unlike libgcrypt no critical section is needed.
+        char reason[256] = "unknown error";
+        const unsigned long errorCode = ERR_get_error();
+        if(errorCode != 0)
+        {
+            ERR_error_string_n(errorCode, reason, sizeof(reason));
+        }
+        ERR_clear_error();
+        
+        std::stringstream errorMessage;
+        errorMessage << "REASON: " << reason << std::endl;
+        errorMessage << "SOURCE: OpenSSL" << std::endl;
+        message = errorMessage.str();
+    }
+};
+
+/**
+ * processOpenSslResult is taking a result of OpenSSL function, which returns 1 on success,
+ * and if it is not successful throws an OpenSslException.
+ */
+inline void processOpenSslResult(int result)
+{
+    if(result != 1)
+    {
+        throw OpenSslException();
+    }
+}
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef SCRATCH_ARENA_H
+#define SCRATCH_ARENA_H
+
+#include <vector>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+
+#include <boost/align/aligned_allocator.hpp>
+
+/**
+ * Class ScratchArena is a cache line aligned buffer, from which a worker takes scratch arrays for a batch.
+ * Before each batch reset discards previous arrays and makes sure that the batch fits, so memory is allocated
+ * only when a batch needs more of it than any previous one, and arrays of a batch never move.
+ * Each array starts at its own cache line, so arrays of different workers never share a line.
+ * Objects of this class are not thread safe, each worker should have its own one.
+ */
+class ScratchArena
+{
+public:
+    static constexpr std::size_t cacheLineSize = 64;
+
+private:
+    std::vector<unsigned char, boost::alignment::aligned_allocator<unsigned char, cacheLineSize>> storage;
+    std::size_t used;
+
+public:
+    ScratchArena():
+        storage(), used(0)
+    {}
+
+    /**
+     * Returns size of array of count elements in arena, including alignment of the next array.
+     */
+    template<class Type>
+    static std::size_t getArraySize(std::size_t count)
+    {
+        static_assert(std::is_trivial<Type>::value && alignof(Type) <= cacheLineSize,
+                      "Arena keeps only trivial types, which fit into alignment of cache line");
+        return((count * sizeof(Type) + cacheLineSize - 1) / cacheLineSize * cacheLineSize);
+    }
+
+    /**
+     * Discards all arrays and makes sure that arrays of size bytes (sum of getArraySize of them) fit into arena.
+     */
+    void reset(std::size_t size)
+    {
+        used = 0;
+        if(storage.size() < size)
+        {
+            storage.resize(size);
+        }
+    }
+
+    /**
+     * Returns uninitialized array of count elements, which stays valid until the next reset.
+     * Throws std::logic_error if it doesn't fit into size given to reset.
+     */
+    template<class Type>
+    Type *allocate(std::size_t count)
+    {
+        const std::size_t arraySize = getArraySize<Type>(count);
+        if(arraySize > storage.size() - used)
+        {
+            throw std::logic_error("ERROR in ScratchArena::allocate: array doesn't fit into the arena.");
+        }
+        Type *array = reinterpret_cast<Type *>(storage.data() + used);
+        used += arraySize;
+        return(array);
+    }
+};
+
+#endif
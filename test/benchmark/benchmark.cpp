@@ -0,0 +1,586 @@
+#include <boost/program_options.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/range/iterator_range.hpp>
+
+#include <gcrypt.h>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <cstdlib>
+#include <cstddef>
+#include <exception>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "io/parse_file.h"
+#include "cryptography/crypto_backend.h"
+#include "cryptography/md5_batch.h"
+#include "cryptography/sha256_batch.h"
+#include "cryptography/des_bitslice.h"
+#include "search/search_worker.h"
+#include "search/mask_keyspace.h"
+#include "search/work_stealing_scheduler.h"
+#include "util/cartesian_range_power.h"
+#include "util/make_shared_array.h"
+
+namespace
+{
+
+/**
+ * Measured speed of a stage: name of stage and its implementation, size of text (zero for stages independent
+ * of it) and number of threads.
+ */
+struct Measurement
+{
+    std::string stage;
+    std::string implementation;
+    std::size_t size;
+    unsigned int threads;
+    double candidatesPerSecond;
+};
+
+typedef std::tuple<std::string, std::string, std::size_t, unsigned int> MeasurementKey;
+
+MeasurementKey getKey(const Measurement &measurement)
+{
+    return(MeasurementKey(measurement.stage, measurement.implementation, measurement.size, measurement.threads));
+}
+
+// Each measurement is repeated and the best speed is taken, so occasional interference of other processes
+// doesn't look like regression.
+constexpr unsigned int repetitionsCount = 3;
+
+/**
+ * Repeats run, which returns number of processed candidates, until duration elapses (at least once)
+ * and returns number of candidates per second.
+ */
+double measureOnce(const std::function<std::size_t()> &run, std::chrono::milliseconds duration)
+{
+    const auto start = std::chrono::steady_clock::now();
+    std::size_t candidatesCount = 0;
+    std::chrono::duration<double> elapsed(0);
+    do
+    {
+        candidatesCount += run();
+        elapsed = std::chrono::steady_clock::now() - start;
+    } while(elapsed < duration);
+    return(candidatesCount / elapsed.count());
+}
+
+double measure(const std::function<std::size_t()> &run, std::chrono::milliseconds duration)
+{
+    double bestCandidatesPerSecond = 0;
+    for(unsigned int repetition = 0; repetition < repetitionsCount; ++repetition)
+    {
+        bestCandidatesPerSecond = std::max(bestCandidatesPerSecond, measureOnce(run, duration));
+    }
+    return(bestCandidatesPerSecond);
+}
+
+std::vector<unsigned char> makeText(std::size_t size)
+{
+    std::vector<unsigned char> text(size);
+    for(std::size_t index = 0; index < size; ++index)
+    {
+        text[index] = static_cast<unsigned char>(index * 37 + 11);
+    }
+    return(text);
+}
+
+/**
+ * Creates cipher file of given size (whole blocks, without padding) encrypted with password, which isn't generated
+ * by benchmarked masks, so every candidate is checked completely.
+ */
+ParsedFile makeCipherFile(std::size_t size)
+{
+    const std::string password = "NONE";
+    const std::vector<unsigned char> text = makeText(size);
+
+    unsigned char key[tripleDesEde2KeySize + tripleDesBlockSize];
+    gcry_md_hash_buffer(GCRY_MD_MD5, key, password.data(), password.size());
+    std::copy_n(key, tripleDesBlockSize, key + tripleDesEde2KeySize);
+
+    const boost::shared_array<unsigned char> initialValue = make_shared_array<unsigned char>(tripleDesBlockSize);
+    std::fill_n(initialValue.get(), tripleDesBlockSize, 0x5a);
+    const boost::shared_array<unsigned char> content = make_shared_array<unsigned char>(size);
+    const boost::shared_array<unsigned char> shaCheckSum = make_shared_array<unsigned char>(sha256DigestSize);
+    gcry_md_hash_buffer(GCRY_MD_SHA256, shaCheckSum.get(), text.data(), text.size());
+
+    gcry_cipher_hd_t cipher;
+    if(gcry_cipher_open(&cipher, GCRY_CIPHER_3DES, GCRY_CIPHER_MODE_CBC, 0) ||
+       gcry_cipher_setkey(cipher, key, sizeof(key)) ||
+       gcry_cipher_setiv(cipher, initialValue.get(), tripleDesBlockSize) ||
+       gcry_cipher_encrypt(cipher, content.get(), size, text.data(), text.size()))
+    {
+        throw std::runtime_error("ERROR in makeCipherFile: encryption failed");
+    }
+    gcry_cipher_close(cipher);
+
+    ParsedFile parsedFile;
+    parsedFile.initialValueSize = tripleDesBlockSize;
+    parsedFile.initialValue = initialValue;
+    parsedFile.contentSize = size;
+    parsedFile.content = content;
+    parsedFile.shaCheckSumSize = sha256DigestSize;
+    parsedFile.shaCheckSum = shaCheckSum;
+    return(parsedFile);
+}
+
+class Benchmark
+{
+private:
+    const std::chrono::milliseconds duration;
+    const std::vector<std::size_t> sizes;
+    const std::vector<unsigned int> threadCounts;
+    const bool pinThreads;
+    std::vector<Measurement> measurements;
+
+    // Keys (MD5 of passwords) used by stages of checking keys.
+    std::vector<unsigned char> keys;
+
+    void add(const std::string &stage, const std::string &implementation, std::size_t size, unsigned int threads,
+             double candidatesPerSecond)
+    {
+        measurements.push_back({stage, implementation, size, threads, candidatesPerSecond});
+        std::cerr << std::setw(12) << std::left << stage << std::setw(16) << implementation
+                  << std::setw(8) << std::right << size << std::setw(4) << threads
+                  << std::setw(16) << static_cast<unsigned long long>(candidatesPerSecond) << " /s" << std::endl;
+    }
+
+    void measureGeneration();
+    void measureMd5();
+    void measureSetKey();
+    void measureDecryption(std::size_t size);
+    void measureSha256(std::size_t size);
+    void measureSearch(std::size_t size);
+public:
+    Benchmark(std::chrono::milliseconds duration, const std::vector<std::size_t> &sizes,
+              const std::vector<unsigned int> &threadCounts, bool pinThreads):
+        duration(duration), sizes(sizes), threadCounts(threadCounts), pinThreads(pinThreads), keys(256 * md5DigestSize)
+    {
+        for(std::size_t index = 0; index < keys.size(); ++index)
+        {
+            keys[index] = static_cast<unsigned char>(index * 131 + index / 7);
+        }
+    }
+
+    const std::vector<Measurement> &run()
+    {
+        measureGeneration();
+        measureMd5();
+        measureSetKey();
+        for(const std::size_t size: sizes)
+        {
+            measureDecryption(size);
+            measureSha256(size);
+        }
+        for(const std::size_t size: sizes)
+        {
+            measureSearch(size);
+        }
+        return(measurements);
+    }
+};
+
+void Benchmark::measureGeneration()
+{
+    const std::string charset = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+
+    // Iterator enumerates all passwords of length 3 sequentially.
+    const auto charsetRange = boost::make_iterator_range(charset.begin(), charset.end());
+    add("generation", "cartesian-power", 0, 1, measure([&charsetRange]()
+    {
+        std::size_t count = 0, checkSum = 0;
+        for(const std::vector<char> &password: CartesianPowerRange(charsetRange, 3))
+        {
+            checkSum += password.back();
+            ++count;
+        }
+        // Check sum keeps the loop from being optimized out.
+        return(checkSum == 0 ? 0 : count);
+    }, duration));
+
+    // Cursor of mask writes passwords of length 8 into batch as search does.
+    const MaskKeyspace keyspace(std::vector<std::string>(8, charset), 8, 8);
+    const std::unique_ptr<CandidateCursor> cursor = keyspace.cursor();
+    CandidateBatch batch(256, keyspace.getMaxLength());
+    KeyspaceIndex first = 0;
+    add("generation", "mask", 0, 1, measure([&]()
+    {
+        const KeyspaceIndex chunkSize = keyspace.getDefaultChunkSize();
+        std::size_t count = 0;
+        cursor->seek(first, first + chunkSize);
+        bool hasCandidates = true;
+        while(hasCandidates)
+        {
+            batch.clear();
+            hasCandidates = cursor->fill(batch);
+            count += batch.size();
+        }
+        first += chunkSize;
+        return(count);
+    }, duration));
+}
+
+void Benchmark::measureMd5()
+{
+    const std::size_t passwordsCount = 256, passwordLength = 8;
+    std::vector<unsigned char> passwords(passwordsCount * passwordLength);
+    std::vector<const unsigned char *> pointers;
+    const std::vector<std::size_t> lengths(passwordsCount, passwordLength);
+    for(std::size_t index = 0; index < passwordsCount; ++index)
+    {
+        std::fill_n(passwords.begin() + index * passwordLength, passwordLength, 'a' + index % 26);
+        pointers.push_back(passwords.data() + index * passwordLength);
+    }
+    std::vector<unsigned char> digests(passwordsCount * md5DigestSize);
+
+    for(const CryptoBackend backend: getAvailableCryptoBackends())
+    {
+        const std::unique_ptr<Md5Engine> engine = createMd5Engine(backend);
+        add("md5", toString(backend), 0, 1, measure([&]()
+        {
+            engine->hashBatch(pointers.data(), lengths.data(), passwordsCount, digests.data());
+            return(passwordsCount);
+        }, duration));
+    }
+}
+
+void Benchmark::measureSetKey()
+{
+    const std::size_t keysCount = keys.size() / md5DigestSize;
+    for(const CryptoBackend backend: getAvailableCryptoBackends())
+    {
+        const std::unique_ptr<TripleDesEngine> engine = createTripleDesEngine(backend);
+        add("setkey", toString(backend), 0, 1, measure([&]()
+        {
+            for(std::size_t keyIndex = 0; keyIndex < keysCount; ++keyIndex)
+            {
+                engine->setKey(keys.data() + keyIndex * md5DigestSize);
+            }
+            return(keysCount);
+        }, duration));
+    }
+
+    BitslicedTripleDes bitslicedDes;
+    add("setkey", "bitslice", 0, 1, measure([&]()
+    {
+        bitslicedDes.setKeys(keys.data(), bitslicedDes.getLanes());
+        return(bitslicedDes.getLanes());
+    }, duration));
+}
+
+void Benchmark::measureDecryption(std::size_t size)
+{
+    const std::vector<unsigned char> cipherText = makeText(size);
+    const std::vector<unsigned char> initialValue(tripleDesBlockSize, 0x5a);
+
+    // Key is set once, so only decryption is measured.
+    std::vector<unsigned char> plainText(size);
+    for(const CryptoBackend backend: getAvailableCryptoBackends())
+    {
+        const std::unique_ptr<TripleDesEngine> engine = createTripleDesEngine(backend);
+        engine->setKey(keys.data());
+        add("decrypt", toString(backend), size, 1, measure([&]()
+        {
+            engine->decrypt(initialValue.data(), cipherText.data(), size, plainText.data());
+            return(1);
+        }, duration));
+    }
+
+    BitslicedTripleDes bitslicedDes;
+    bitslicedDes.setKeys(keys.data(), bitslicedDes.getLanes());
+    std::vector<unsigned char> plainTexts(size * bitslicedDes.getLanes());
+    add("decrypt", "bitslice", size, 1, measure([&]()
+    {
+        bitslicedDes.decrypt(initialValue.data(), cipherText.data(), size / tripleDesBlockSize,
+                             plainTexts.data(), size);
+        return(bitslicedDes.getLanes());
+    }, duration));
+}
+
+void Benchmark::measureSha256(std::size_t size)
+{
+    const std::vector<unsigned char> text = makeText(size);
+    unsigned char digest[sha256DigestSize];
+    for(const CryptoBackend backend: getAvailableCryptoBackends())
+    {
+        const std::unique_ptr<Sha256Engine> engine = createSha256Engine(backend);
+        add("sha256", toString(backend), size, 1, measure([&]()
+        {
+            engine->hash(text.data(), size, digest);
+            return(1);
+        }, duration));
+    }
+
+    // Multi-buffer SHA256 hashes texts of the whole batch of bitsliced 3DES.
+    const std::size_t textsCount = BitslicedTripleDes::getBestLanes();
+    std::vector<unsigned char> texts(size * textsCount);
+    for(std::size_t index = 0; index < textsCount; ++index)
+    {
+        std::copy(text.begin(), text.end(), texts.begin() + index * size);
+    }
+    Sha256Batch sha256Batch(textsCount);
+    boost::dynamic_bitset<> matches;
+    add("sha256", "batch-" + toString(getBestSha256Kernel()), size, 1, measure([&]()
+    {
+        sha256Batch.reset(textsCount);
+        sha256Batch.update(texts.data(), size, size);
+        sha256Batch.finish(digest, matches);
+        return(textsCount);
+    }, duration));
+}
+
+void Benchmark::measureSearch(std::size_t size)
+{
+    const std::vector<SearchTarget> targets = {{"synthetic", makeCipherFile(size), 0}};
+    const MaskKeyspace keyspace(std::vector<std::string>(6, "abcdefghijklmnopqrstuvwxyz"), 6, 6);
+
+    for(const bool useBitslicedDes: {true, false})
+    {
+        SearchOptions searchOptions;
+        searchOptions.chunkSize = useBitslicedDes ? 4096 : 256;
+        searchOptions.printDecryptedText = false;
+        searchOptions.usePaddingPrefilter = false;
+        searchOptions.useBitslicedDes = useBitslicedDes;
+        searchOptions.printFileNames = false;
+
+        for(const unsigned int threads: threadCounts)
+        {
+            double bestCandidatesPerSecond = 0;
+            for(unsigned int repetition = 0; repetition < repetitionsCount; ++repetition)
+            {
+                // Threads take chunks as the search does, until duration elapses.
+                WorkStealingScheduler scheduler(threads, pinThreads);
+                std::atomic<std::size_t> candidatesCount(0);
+                std::ostringstream output;
+                ResultChannel resultChannel(targets, searchOptions, output);
+                const auto start = std::chrono::steady_clock::now();
+                const KeyspaceIndex chunksCount = keyspace.size() / searchOptions.chunkSize;
+                scheduler.run(chunksCount, [&](std::size_t, WorkStealingScheduler::Tasks &tasks)
+                {
+                    SearchWorker searchWorker(targets, keyspace, searchOptions, resultChannel);
+                    std::size_t threadCandidatesCount = 0;
+                    KeyspaceIndex chunkIndex;
+                    while(std::chrono::steady_clock::now() - start < duration && tasks.next(chunkIndex))
+                    {
+                        searchWorker.processChunk(chunkIndex * searchOptions.chunkSize,
+                                                  (chunkIndex + 1) * searchOptions.chunkSize);
+                        threadCandidatesCount += searchOptions.chunkSize;
+                    }
+                    candidatesCount += threadCandidatesCount;
+                });
+                const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                bestCandidatesPerSecond = std::max(bestCandidatesPerSecond, candidatesCount / elapsed.count());
+            }
+            add("end-to-end", useBitslicedDes ? "bitslice" : "per-key", size, threads, bestCandidatesPerSecond);
+        }
+    }
+}
+
+void writeMeasurements(std::ostream &stream, const std::vector<Measurement> &measurements)
+{
+    stream << "{\n    \"results\": [";
+    for(std::size_t index = 0; index < measurements.size(); ++index)
+    {
+        const Measurement &measurement = measurements[index];
+        stream << (index == 0 ? "\n" : ",\n")
+               << "        {\"stage\": \"" << measurement.stage << "\", "
+               << "\"implementation\": \"" << measurement.implementation << "\", "
+               << "\"size\": " << measurement.size << ", "
+               << "\"threads\": " << measurement.threads << ", "
+               << "\"candidates_per_second\": " << std::fixed << std::setprecision(1)
+               << measurement.candidatesPerSecond << "}";
+    }
+    stream << "\n    ]\n}\n";
+}
+
+std::map<MeasurementKey, double> readBaseline(const std::string &fileName)
+{
+    boost::property_tree::ptree tree;
+    boost::property_tree::read_json(fileName, tree);
+    std::map<MeasurementKey, double> baseline;
+    for(const auto &result: tree.get_child("results"))
+    {
+        const Measurement measurement = {result.second.get<std::string>("stage"),
+                                         result.second.get<std::string>("implementation"),
+                                         result.second.get<std::size_t>("size"),
+                                         result.second.get<unsigned int>("threads"),
+                                         result.second.get<double>("candidates_per_second")};
+        baseline[getKey(measurement)] = measurement.candidatesPerSecond;
+    }
+    return(baseline);
+}
+
+template<class Value>
+std::vector<Value> parseList(const std::string &list)
+{
+    std::vector<Value> values;
+    std::istringstream stream(list);
+    std::string item;
+    while(std::getline(stream, item, ','))
+    {
+        std::size_t position;
+        const unsigned long value = std::stoul(item, &position);
+        if(position != item.size() || value == 0)
+        {
+            throw std::invalid_argument("ERROR in parseList: invalid positive number \"" + item + "\"");
+        }
+        values.push_back(static_cast<Value>(value));
+    }
+    return(values);
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    if(!gcry_check_version(GCRYPT_VERSION))
+    {
+        std::cerr << "ERROR: Can't initialize libgcrypt. Version mismatch." << std::endl;
+        return(EXIT_FAILURE);
+    }
+    gcry_control(GCRYCTL_DISABLE_SECMEM, 0);
+    gcry_control(GCRYCTL_INITIALIZATION_FINISHED, 0);
+
+    unsigned int durationMilliseconds;
+    std::string sizesList, threadsList, outputFileName, baselineFileName;
+    double tolerance;
+    bool pinThreads;
+
+#ifdef _OPENMP
+    const unsigned int maxThreads = omp_get_max_threads();
+#else
+    const unsigned int maxThreads = 1;
+#endif
+    // By default threads are doubled up to all threads available.
+    std::string defaultThreadsList = "1";
+    for(unsigned int threads = 2; threads < 2 * maxThreads; threads *= 2)
+    {
+        defaultThreadsList += "," + std::to_string(std::min(threads, maxThreads));
+    }
+
+    boost::program_options::options_description options("Options");
+    options.add_options()
+        ("help,h", "Produce help message.")
+        ("duration", boost::program_options::value<unsigned int>(&durationMilliseconds)->default_value(200),
+         "Time of each of repeated measurements in milliseconds.")
+        ("sizes", boost::program_options::value<std::string>(&sizesList)->default_value("64,1024,16384"),
+         "Comma separated sizes of ciphertext in bytes (multiples of 8).")
+        ("threads", boost::program_options::value<std::string>(&threadsList)->default_value(defaultThreadsList),
+         "Comma separated numbers of threads of end-to-end search.")
+        ("pin-threads", boost::program_options::bool_switch(&pinThreads)->default_value(false),
+         "Pins threads of end-to-end search to CPUs.")
+        ("output,o", boost::program_options::value<std::string>(&outputFileName),
+         "Writes results as JSON into FILE instead of standard output.")
+        ("baseline", boost::program_options::value<std::string>(&baselineFileName),
+         "Compares results with JSON written by previous run and fails, if any of them is slower.")
+        ("tolerance", boost::program_options::value<double>(&tolerance)->default_value(0.25),
+         "Allowed relative slowdown in comparison with baseline.");
+
+    std::vector<std::size_t> sizes;
+    std::vector<unsigned int> threadCounts;
+    try
+    {
+        boost::program_options::variables_map variablesMap;
+        boost::program_options::store(boost::program_options::parse_command_line(argc, argv, options), variablesMap);
+        boost::program_options::notify(variablesMap);
+        if(variablesMap.count("help"))
+        {
+            std::cout << "Usage: benchmark [--duration MS] [--sizes LIST] [--threads LIST] [--pin-threads] "
+                         "[-o|--output FILE] "
+                         "[--baseline FILE] [--tolerance FRACTION]" << std::endl;
+            std::cout << options << std::endl;
+            return(EXIT_SUCCESS);
+        }
+        sizes = parseList<std::size_t>(sizesList);
+        threadCounts = parseList<unsigned int>(threadsList);
+        if(std::any_of(sizes.begin(), sizes.end(), [](std::size_t size)
+                       {
+                           return(size % tripleDesBlockSize != 0);
+                       }))
+        {
+            throw std::invalid_argument("sizes of ciphertext must be multiples of 8");
+        }
+    }
+    catch(const std::exception &error)
+    {
+        std::cerr << "ERROR: " << error.what() << std::endl;
+        return(EXIT_FAILURE);
+    }
+
+    std::vector<Measurement> measurements;
+    try
+    {
+        measurements = Benchmark(std::chrono::milliseconds(durationMilliseconds), sizes, threadCounts,
+                                 pinThreads).run();
+    }
+    catch(const std::exception &error)
+    {
+        std::cerr << "ERROR: Benchmark failed." << std::endl;
+        std::cerr << error.what() << std::endl;
+        return(EXIT_FAILURE);
+    }
+
+    if(outputFileName.empty())
+    {
+        writeMeasurements(std::cout, measurements);
+    }
+    else
+    {
+        std::ofstream output(outputFileName);
+        writeMeasurements(output, measurements);
+        if(!output)
+        {
+            std::cerr << "ERROR: Failed writing " << outputFileName << "." << std::endl;
+            return(EXIT_FAILURE);
+        }
+    }
+
+    if(baselineFileName.empty())
+    {
+        return(EXIT_SUCCESS);
+    }
+
+    // Measurements absent in baseline (e.g. of other number of threads) are not compared.
+    std::map<MeasurementKey, double> baseline;
+    try
+    {
+        baseline = readBaseline(baselineFileName);
+    }
+    catch(const std::exception &error)
+    {
+        std::cerr << "ERROR: Failed reading baseline " << baselineFileName << "." << std::endl;
+        std::cerr << error.what() << std::endl;
+        return(EXIT_FAILURE);
+    }
+    bool regressed = false;
+    for(const Measurement &measurement: measurements)
+    {
+        const auto baselineMeasurement = baseline.find(getKey(measurement));
+        if(baselineMeasurement != baseline.end() &&
+           measurement.candidatesPerSecond < (1 - tolerance) * baselineMeasurement->second)
+        {
+            std::cerr << "REGRESSION: " << measurement.stage << " " << measurement.implementation
+                      << " size " << measurement.size << " threads " << measurement.threads << ": "
+                      << static_cast<unsigned long long>(measurement.candidatesPerSecond) << "/s, baseline "
+                      << static_cast<unsigned long long>(baselineMeasurement->second) << "/s" << std::endl;
+            regressed = true;
+        }
+    }
+    return(regressed ? EXIT_FAILURE : EXIT_SUCCESS);
+}
@@ -0,0 +1,59 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <boost/test/data/test_case.hpp>
+
+#include <limits>
+#include <cstdint>
+#include <cstring>
+
+#include "search/candidate_source.h"
+
+BOOST_DATA_TEST_CASE(shard_range_test,
+                     boost::unit_test_framework::data::make({0, 1, 7, 100, 101}) *
+                     boost::unit_test_framework::data::make({1, 2, 3, 10, 200}),
+                     size, shardsCount)
+{
+    // Shards are contiguous, follow each other and cover all indices, their sizes differ at most by one.
+    KeyspaceIndex expectedFirst = 0;
+    for(KeyspaceIndex shardIndex = 0; shardIndex < static_cast<KeyspaceIndex>(shardsCount); ++shardIndex)
+    {
+        const auto shard = getShardRange(size, shardIndex, shardsCount);
+        BOOST_TEST(shard.first == expectedFirst);
+        BOOST_TEST(shard.second >= shard.first);
+        BOOST_TEST(shard.second - shard.first <= static_cast<KeyspaceIndex>(size / shardsCount + 1));
+        BOOST_TEST(shard.second - shard.first >= static_cast<KeyspaceIndex>(size / shardsCount));
+        expectedFirst = shard.second;
+    }
+    BOOST_TEST(expectedFirst == static_cast<KeyspaceIndex>(size));
+}
+
+BOOST_AUTO_TEST_CASE(shard_range_overflow_test)
+{
+    const KeyspaceIndex size = std::numeric_limits<KeyspaceIndex>::max();
+    BOOST_TEST(getShardRange(size, 2, 3).second == size);
+    BOOST_TEST(getShardRange(size, 1, 3).first == size / 3);
+}
+
+BOOST_AUTO_TEST_CASE(candidate_batch_test)
+{
+    // Slots, pointers and lengths of batch start at cache lines, generated and referenced candidates are mixed.
+    CandidateBatch batch(5, 3);
+    BOOST_TEST(reinterpret_cast<std::uintptr_t>(batch.getSlot()) % ScratchArena::cacheLineSize == 0);
+    BOOST_TEST(reinterpret_cast<std::uintptr_t>(batch.getCandidates()) % ScratchArena::cacheLineSize == 0);
+    BOOST_TEST(reinterpret_cast<std::uintptr_t>(batch.getLengths()) % ScratchArena::cacheLineSize == 0);
+
+    std::memcpy(batch.getSlot(), "abcdef", 6);
+    batch.pushSlots(2, 3);
+    const unsigned char word[] = "word";
+    batch.push(word, 4);
+    std::memcpy(batch.getSlot(), "xy", 2);
+    batch.push(batch.getSlot(), 2);
+    BOOST_TEST(batch.size() == 4);
+    BOOST_TEST(batch.getFreeSlotsCount() == 1);
+    BOOST_TEST(batch[0] == "abc");
+    BOOST_TEST(batch[1] == "def");
+    BOOST_TEST(batch[2] == "word");
+    BOOST_TEST(batch[3] == "xy");
+    batch.clear();
+    BOOST_TEST(batch.size() == 0);
+}
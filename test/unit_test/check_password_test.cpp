@@ -0,0 +1,55 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <boost/test/data/test_case.hpp>
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "cryptography/check_password.h"
+#include "cryptography/md5_batch.h"
+#include "io/generate_cipher_file.h"
+#include "io/parse_file.h"
+
+#include "tmp_file_fixture.h"
+
+BOOST_DATA_TEST_CASE_F(TmpFileFixture, check_password_batch_test,
+                       boost::unit_test_framework::data::make({false, true}), usePaddingPrefilter)
+{
+    // Keys of a batch are checked at once, acceptable ones are marked in bitmask and decrypted text
+    // is available after checking acceptable key once more.
+    tmpFile.close();
+    CipherFileParameters parameters;
+    parameters.password = "abc";
+    parameters.textSize = 12;
+    parameters.padding = true;
+    generateCipherFile(tmpFilePath.string(), parameters);
+    const ParsedFile file = parseFile(tmpFilePath.string(), 8, 32);
+
+    const std::size_t stride = 8;
+    const std::vector<std::string> passwords = {"nope", "abc", "ab", "abcd", "", "abc", "xyz"};
+    std::vector<unsigned char> block(passwords.size() * stride);
+    std::vector<std::size_t> lengths;
+    for(std::size_t passwordIndex = 0; passwordIndex < passwords.size(); ++passwordIndex)
+    {
+        std::copy(passwords[passwordIndex].begin(), passwords[passwordIndex].end(),
+                  block.begin() + passwordIndex * stride);
+        lengths.push_back(passwords[passwordIndex].size());
+    }
+    std::vector<unsigned char> digests(passwords.size() * md5DigestSize);
+    md5Batch(block.data(), stride, lengths.data(), passwords.size(), digests.data());
+
+    CheckPassword checkPassword(file, usePaddingPrefilter);
+    boost::dynamic_bitset<> acceptableKeys(1, 1);
+    BOOST_TEST(checkPassword.checkKeys(digests.data(), 3, acceptableKeys) == 1);
+    BOOST_TEST(acceptableKeys.size() == 3);
+    BOOST_TEST(acceptableKeys.test(1));
+
+    CheckPassword copiedCheckPassword(checkPassword);
+    BOOST_TEST(copiedCheckPassword.checkKeys(digests.data(), passwords.size(), acceptableKeys) == 2);
+    boost::dynamic_bitset<> expectedKeys(passwords.size());
+    expectedKeys.set(1).set(5);
+    BOOST_TEST(acceptableKeys == expectedKeys);
+    BOOST_TEST(checkPassword.isKeyAcceptable(digests.data() + md5DigestSize));
+    BOOST_TEST(checkPassword.getDecryptedText().substr(12) == std::string(4, '\x04'));
+}
@@ -0,0 +1,88 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <stdexcept>
+
+#include "search/checkpoint.h"
+
+#include "tmp_file_fixture.h"
+
+namespace
+{
+
+using Ranges = std::vector<std::pair<KeyspaceIndex, KeyspaceIndex>>;
+
+}
+
+BOOST_AUTO_TEST_CASE(keyspace_ranges_test)
+{
+    KeyspaceRanges ranges;
+    BOOST_TEST(ranges.getMissing(0, 10) == Ranges({{0, 10}}));
+
+    // Chunks completed out of order are merged, when the gaps between them are filled.
+    ranges.add(20, 30);
+    ranges.add(0, 10);
+    ranges.add(40, 50);
+    ranges.add(5, 5);
+    BOOST_TEST(ranges.getRanges() == Ranges({{0, 10}, {20, 30}, {40, 50}}));
+    BOOST_TEST(ranges.count() == 30);
+    BOOST_TEST(ranges.getMissing(0, 60) == Ranges({{10, 20}, {30, 40}, {50, 60}}));
+    BOOST_TEST(ranges.getMissing(5, 25) == Ranges({{10, 20}}));
+    BOOST_TEST(ranges.getMissing(22, 28).empty());
+
+    ranges.add(10, 20);
+    BOOST_TEST(ranges.getRanges() == Ranges({{0, 30}, {40, 50}}));
+    ranges.add(25, 45);
+    BOOST_TEST(ranges.getRanges() == Ranges({{0, 50}}));
+    ranges.add(60, 70);
+    ranges.add(55, 65);
+    BOOST_TEST(ranges.getRanges() == Ranges({{0, 50}, {55, 70}}));
+    BOOST_TEST(ranges.count() == 65);
+
+    ranges.clear();
+    BOOST_TEST(ranges.count() == 0);
+}
+
+BOOST_FIXTURE_TEST_CASE(checkpoint_save_load_test, TmpFileFixture)
+{
+    tmpFile.close();
+
+    Checkpoint checkpoint;
+    checkpoint.filesHash = "0123456789abcdef";
+    checkpoint.candidatesDescription = "mask 1 2\n2:ab\n10:0123456789";
+    checkpoint.candidatesSize = 22;
+    checkpoint.usePaddingPrefilter = true;
+    checkpoint.plaintextFilterDescription = "printable 8\nprefix %PDF-";
+    checkpoint.completed.add(0, 4);
+    checkpoint.completed.add(8, 12);
+    checkpoint.acceptablePasswords = {{0, "a1"}, {0, ""}, {2, std::string("\n\0\xff", 3)}};
+    checkpoint.save(tmpFilePath.string());
+
+    const Checkpoint loadedCheckpoint = Checkpoint::load(tmpFilePath.string());
+    BOOST_TEST(loadedCheckpoint.filesHash == checkpoint.filesHash);
+    BOOST_TEST(loadedCheckpoint.candidatesDescription == checkpoint.candidatesDescription);
+    BOOST_TEST(loadedCheckpoint.candidatesSize == checkpoint.candidatesSize);
+    BOOST_TEST(loadedCheckpoint.usePaddingPrefilter == checkpoint.usePaddingPrefilter);
+    BOOST_TEST(loadedCheckpoint.plaintextFilterDescription == checkpoint.plaintextFilterDescription);
+    BOOST_TEST(loadedCheckpoint.completed.getRanges() == checkpoint.completed.getRanges());
+    BOOST_TEST((loadedCheckpoint.acceptablePasswords == checkpoint.acceptablePasswords));
+
+    // Completed ranges must lie inside the candidates.
+    {
+        boost::filesystem::ofstream malformedFile(tmpFilePath, boost::filesystem::ofstream::binary);
+        malformedFile << "test_problem-checkpoint 2\nfiles-sha256 00\ncandidates 61\nsize 10\n"
+                         "padding-prefilter 0\nplaintext-filter 61\ncompleted 0 20\n";
+    }
+    BOOST_CHECK_THROW(Checkpoint::load(tmpFilePath.string()), std::runtime_error);
+
+    {
+        boost::filesystem::ofstream truncatedFile(tmpFilePath, boost::filesystem::ofstream::binary);
+        truncatedFile << "test_problem-checkpoint 2\nfiles-sha256 00\n";
+    }
+    BOOST_CHECK_THROW(Checkpoint::load(tmpFilePath.string()), std::runtime_error);
+
+    BOOST_CHECK_THROW(Checkpoint::load(tmpFilePath.string() + ".missing"), std::runtime_error);
+}
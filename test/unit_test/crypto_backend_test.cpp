@@ -0,0 +1,105 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <boost/test/data/test_case.hpp>
+
+#include <gcrypt.h>
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+
+#include "cryptography/crypto_backend.h"
+#include "cryptography/md5_batch.h"
+#include "cryptography/sha256_batch.h"
+#include "cryptography/des_bitslice.h"
+
+namespace
+{
+
+std::vector<unsigned char> makeText(std::size_t size)
+{
+    std::vector<unsigned char> text(size);
+    for(std::size_t index = 0; index < size; ++index)
+    {
+        text[index] = static_cast<unsigned char>(index * 37 + 11);
+    }
+    return(text);
+}
+
+}
+
+BOOST_DATA_TEST_CASE(crypto_backend_test, boost::unit_test_framework::data::make(getAvailableCryptoBackends()),
+                     backend)
+{
+    // Results of each backend are compared with libgcrypt, messages are short (single block of MD5)
+    // and long ones.
+    const std::vector<std::string> messages = {"", "abc", std::string(55, 'x'), std::string(200, 'y')};
+    std::vector<const unsigned char *> messagePointers;
+    std::vector<std::size_t> lengths;
+    std::vector<unsigned char> expectedDigests(messages.size() * md5DigestSize);
+    for(std::size_t index = 0; index < messages.size(); ++index)
+    {
+        messagePointers.push_back(reinterpret_cast<const unsigned char *>(messages[index].data()));
+        lengths.push_back(messages[index].size());
+        gcry_md_hash_buffer(GCRY_MD_MD5, expectedDigests.data() + index * md5DigestSize,
+                            messages[index].data(), messages[index].size());
+    }
+    const std::unique_ptr<Md5Engine> md5Engine = createMd5Engine(backend);
+    std::vector<unsigned char> digests(messages.size() * md5DigestSize);
+    md5Engine->hashBatch(messagePointers.data(), lengths.data(), messages.size(), digests.data());
+    BOOST_TEST(digests == expectedDigests);
+    md5Engine->hash(messagePointers[1], lengths[1], digests.data());
+    BOOST_TEST(std::equal(digests.begin(), digests.begin() + md5DigestSize, expectedDigests.begin() + md5DigestSize));
+
+    // Decryption by parts continues CBC chain from the previous ciphertext block.
+    const std::vector<unsigned char> cipherText = makeText(40 * tripleDesBlockSize);
+    const std::vector<unsigned char> initialValue = {1, 2, 3, 4, 5, 6, 7, 8};
+    unsigned char key[tripleDesEde2KeySize + tripleDesBlockSize];
+    std::copy_n(expectedDigests.data() + md5DigestSize, tripleDesEde2KeySize, key);
+    std::copy_n(key, tripleDesBlockSize, key + tripleDesEde2KeySize);
+    std::vector<unsigned char> expectedText(cipherText.size());
+    gcry_cipher_hd_t cipher;
+    BOOST_REQUIRE(!gcry_cipher_open(&cipher, GCRY_CIPHER_3DES, GCRY_CIPHER_MODE_CBC, 0));
+    BOOST_REQUIRE(!gcry_cipher_setkey(cipher, key, sizeof(key)));
+    BOOST_REQUIRE(!gcry_cipher_setiv(cipher, initialValue.data(), initialValue.size()));
+    BOOST_REQUIRE(!gcry_cipher_decrypt(cipher, expectedText.data(), expectedText.size(),
+                                       cipherText.data(), cipherText.size()));
+    gcry_cipher_close(cipher);
+
+    const std::unique_ptr<TripleDesEngine> tripleDesEngine = createTripleDesEngine(backend);
+    std::vector<unsigned char> plainText(cipherText.size());
+    tripleDesEngine->setKey(expectedDigests.data());
+    tripleDesEngine->decrypt(initialValue.data(), cipherText.data(), cipherText.size(), plainText.data());
+    tripleDesEngine->setKey(expectedDigests.data() + md5DigestSize);
+    tripleDesEngine->decrypt(initialValue.data(), cipherText.data(), 3 * tripleDesBlockSize, plainText.data());
+    tripleDesEngine->decrypt(cipherText.data() + 2 * tripleDesBlockSize, cipherText.data() + 3 * tripleDesBlockSize,
+                             cipherText.size() - 3 * tripleDesBlockSize, plainText.data() + 3 * tripleDesBlockSize);
+    BOOST_TEST(plainText == expectedText);
+
+    const std::unique_ptr<Sha256Engine> sha256Engine = createSha256Engine(backend);
+    for(const std::size_t size: {std::size_t(0), std::size_t(64), cipherText.size()})
+    {
+        unsigned char digest[sha256DigestSize], expectedDigest[sha256DigestSize];
+        gcry_md_hash_buffer(GCRY_MD_SHA256, expectedDigest, cipherText.data(), size);
+        sha256Engine->hash(cipherText.data(), size, digest);
+        BOOST_TEST(std::equal(digest, digest + sha256DigestSize, expectedDigest));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(crypto_backend_calibration_test)
+{
+    BOOST_TEST(parseCryptoBackend("gcrypt") == CryptoBackend::Gcrypt);
+    BOOST_CHECK_THROW(parseCryptoBackend("nettle"), std::invalid_argument);
+
+    std::ostringstream report;
+    const CryptoBackends backends = calibrateCryptoBackends(1000, &report);
+    const std::vector<CryptoBackend> availableBackends = getAvailableCryptoBackends();
+    for(const CryptoBackend backend: {backends.md5, backends.tripleDes, backends.sha256})
+    {
+        BOOST_TEST((std::find(availableBackends.begin(), availableBackends.end(), backend) !=
+                    availableBackends.end()));
+    }
+    BOOST_TEST(report.str().find("3des:") != std::string::npos);
+}
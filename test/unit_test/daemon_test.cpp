@@ -0,0 +1,162 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <cstdlib>
+
+#include "daemon/program_context.h"
+#include "daemon/daemon_protocol.h"
+#include "daemon/job_queue.h"
+#include "daemon/daemon_server.h"
+#include "daemon/daemon_client.h"
+#include "search/work_stealing_scheduler.h"
+
+namespace
+{
+
+std::shared_ptr<DaemonJob> makeJob(const std::string &name, int priority, KeyspaceIndex estimatedSize)
+{
+    std::shared_ptr<DaemonJob> job(new DaemonJob());
+    job->arguments = {name};
+    job->priority = priority;
+    job->estimatedSize = estimatedSize;
+    return(job);
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(escape_line_test)
+{
+    for(const std::string text: {"", "abc", "a\nb", "a\\nb\\", "\n\n\\"})
+    {
+        const std::string line = escapeLine(text);
+        BOOST_TEST(line.find('\n') == std::string::npos);
+        BOOST_TEST(unescapeLine(line) == text);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(job_queue_test)
+{
+    // Higher priority goes first, then smaller job, then the earlier one.
+    JobQueue jobs;
+    BOOST_TEST(jobs.push(makeJob("large", 0, 1000)));
+    BOOST_TEST(jobs.push(makeJob("small", 0, 10)));
+    BOOST_TEST(jobs.push(makeJob("urgent", 1, 100000)));
+    BOOST_TEST(jobs.push(makeJob("small again", 0, 10)));
+    BOOST_TEST(jobs.push(makeJob("background", -1, 1)));
+    BOOST_TEST(jobs.size() == 5);
+
+    std::vector<std::string> order;
+    for(unsigned int index = 0; index < 3; ++index)
+    {
+        order.push_back(jobs.pop()->arguments.front());
+    }
+    BOOST_TEST(order == std::vector<std::string>({"urgent", "small", "small again"}));
+
+    // Remaining jobs are returned by close in the same order and nothing is accepted after it.
+    order.clear();
+    for(const std::shared_ptr<DaemonJob> &job: jobs.close())
+    {
+        order.push_back(job->arguments.front());
+    }
+    BOOST_TEST(order == std::vector<std::string>({"large", "background"}));
+    BOOST_TEST(!jobs.push(makeJob("late", 0, 1)));
+    BOOST_TEST(jobs.pop() == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(daemon_server_test)
+{
+    const std::string socketName = (boost::filesystem::temp_directory_path() /
+                                    boost::filesystem::unique_path("daemon-%%%%-%%%%.socket")).string();
+
+    // Program prints its arguments, fails on "fail" at estimation and reports threads of daemon.
+    // On "silent" it prints nothing and waits until it is interrupted.
+    std::atomic<unsigned int> runsCount(0);
+    std::atomic<bool> isSilentInterrupted(false);
+    const Program program = [&runsCount, &isSilentInterrupted](const std::vector<std::string> &arguments,
+                                                               ProgramContext &context)
+    {
+        if(context.estimateOnly)
+        {
+            if(arguments.front() == "fail")
+            {
+                context.errors << "ERROR: failed\nat estimation" << std::endl;
+                throw ProgramExit(EXIT_FAILURE);
+            }
+            context.estimatedSize = arguments.size();
+            return(EXIT_SUCCESS);
+        }
+        if(arguments.front() == "silent")
+        {
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+            while(!context.interrupted && std::chrono::steady_clock::now() < deadline)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            isSilentInterrupted = context.interrupted.load();
+            return(EXIT_SUCCESS);
+        }
+        ++runsCount;
+        for(const std::string &argument: arguments)
+        {
+            context.output << argument << std::endl;
+        }
+        context.errors << "threads " << context.scheduler->getThreadsCount() << " in " << context.workingDirectory
+                       << std::endl;
+        return(static_cast<int>(arguments.size()));
+    };
+
+    WorkStealingScheduler scheduler(2, false);
+    DaemonServer daemonServer(socketName, scheduler, program);
+    std::atomic<bool> stopRequested(false);
+    std::thread daemonThread([&daemonServer, &stopRequested]()
+                             {
+                                 daemonServer.run(stopRequested);
+                             });
+    while(!boost::filesystem::exists(socketName))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // Only user of daemon can connect to its socket.
+    BOOST_TEST((boost::filesystem::status(socketName).permissions() & boost::filesystem::perms_mask) ==
+               (boost::filesystem::owner_read | boost::filesystem::owner_write));
+
+    std::ostringstream output, errors;
+    BOOST_TEST(runDaemonJob(socketName, 0, {"a", "b\\c", "multi\nline"}, output, errors) == 3);
+    BOOST_TEST(output.str() == "a\nb\\c\nmulti\nline\n");
+    BOOST_TEST(errors.str() == "threads 2 in " + boost::filesystem::current_path().string() + "\n");
+
+    output.str("");
+    errors.str("");
+    BOOST_TEST(runDaemonJob(socketName, 0, {"fail"}, output, errors) == EXIT_FAILURE);
+    BOOST_TEST(output.str().empty());
+    BOOST_TEST(errors.str() == "ERROR: failed\nat estimation\n");
+    BOOST_TEST(runsCount == 1);
+
+    // Client of silent job disconnects, so the job is interrupted and the next one runs.
+    {
+        LineConnection connection(connectUnixSocket(socketName));
+        BOOST_TEST(connection.writeLine("argument silent"));
+        BOOST_TEST(connection.writeLine("run"));
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+    output.str("");
+    errors.str("");
+    BOOST_TEST(runDaemonJob(socketName, 0, {"after"}, output, errors) == 1);
+    BOOST_TEST(output.str() == "after\n");
+    BOOST_TEST(isSilentInterrupted);
+
+    stopRequested = true;
+    daemonThread.join();
+    BOOST_TEST(!boost::filesystem::exists(socketName));
+    BOOST_CHECK_THROW(runDaemonJob(socketName, 0, {"a"}, output, errors), std::runtime_error);
+}
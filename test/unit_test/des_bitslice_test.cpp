@@ -0,0 +1,65 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <boost/test/data/test_case.hpp>
+
+#include <gcrypt.h>
+
+#include <vector>
+#include <random>
+
+#include "cryptography/des_bitslice.h"
+
+BOOST_DATA_TEST_CASE(des_bitslice_test,
+                     boost::unit_test_framework::data::make({64, 128, 256}) *
+                     boost::unit_test_framework::data::make({1, 63, 64, 200}) *
+                     boost::unit_test_framework::data::make({1, 3}),
+                     lanes, keysCount, blocksCount)
+{
+    if(static_cast<std::size_t>(keysCount) > static_cast<std::size_t>(lanes))
+    {
+        return;
+    }
+    
+    std::mt19937 generator(lanes * keysCount + blocksCount);
+    std::uniform_int_distribution<int> byteDistribution(0, 255);
+    auto randomBytes = [&generator, &byteDistribution](std::size_t size)
+    {
+        std::vector<unsigned char> bytes(size);
+        for(auto &byte: bytes)
+        {
+            byte = byteDistribution(generator);
+        }
+        return(bytes);
+    };
+    
+    const auto initialValue = randomBytes(tripleDesBlockSize);
+    const auto cipherText = randomBytes(blocksCount * tripleDesBlockSize);
+    const auto keys = randomBytes(keysCount * tripleDesEde2KeySize);
+    
+    BitslicedTripleDes bitslicedTripleDes(lanes);
+    bitslicedTripleDes.setKeys(keys.data(), keysCount);
+    std::vector<unsigned char> plainTexts(keysCount * cipherText.size());
+    bitslicedTripleDes.decrypt(initialValue.data(), cipherText.data(), blocksCount,
+                               plainTexts.data(), cipherText.size());
+    
+    gcry_cipher_hd_t cipher;
+    BOOST_REQUIRE(!gcry_cipher_open(&cipher, GCRY_CIPHER_3DES, GCRY_CIPHER_MODE_CBC, 0));
+    for(int keyIndex = 0; keyIndex < keysCount; ++keyIndex)
+    {
+        // EDE2 key is extended to 3DES key by repeating the first DES key.
+        std::vector<unsigned char> tripleDesKey(keys.begin() + keyIndex * tripleDesEde2KeySize,
+                                                keys.begin() + (keyIndex + 1) * tripleDesEde2KeySize);
+        tripleDesKey.insert(tripleDesKey.end(), tripleDesKey.begin(), tripleDesKey.begin() + tripleDesBlockSize);
+        
+        std::vector<unsigned char> expectedPlainText(cipherText.size());
+        BOOST_REQUIRE(!gcry_cipher_setkey(cipher, tripleDesKey.data(), tripleDesKey.size()));
+        BOOST_REQUIRE(!gcry_cipher_setiv(cipher, initialValue.data(), initialValue.size()));
+        BOOST_REQUIRE(!gcry_cipher_decrypt(cipher, expectedPlainText.data(), expectedPlainText.size(),
+                                           cipherText.data(), cipherText.size()));
+        
+        std::vector<unsigned char> plainText(plainTexts.begin() + keyIndex * cipherText.size(),
+                                             plainTexts.begin() + (keyIndex + 1) * cipherText.size());
+        BOOST_TEST(plainText == expectedPlainText, boost::test_tools::per_element());
+    }
+    gcry_cipher_close(cipher);
+}
@@ -0,0 +1,98 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <boost/test/data/test_case.hpp>
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <atomic>
+
+#include "io/generate_cipher_file.h"
+#include "io/parse_file.h"
+#include "cryptography/check_password.h"
+
+#include "tmp_file_fixture.h"
+
+BOOST_DATA_TEST_CASE_F(TmpFileFixture, generate_cipher_file_test,
+                       boost::unit_test_framework::data::make({8, 1000, 1 << 20, (1 << 20) + 13}) *
+                       boost::unit_test_framework::data::make({false, true}),
+                       textSize, padding)
+{
+    // Generated file is accepted with its password only, padding is valid and size of text is as requested.
+    if(!padding && textSize % 8 != 0)
+    {
+        return;
+    }
+    tmpFile.close();
+    CipherFileParameters parameters;
+    parameters.password = "aZ7";
+    parameters.textSize = textSize;
+    parameters.padding = padding;
+    generateCipherFile(tmpFilePath.string(), parameters);
+
+    const ParsedFile parsedFile = parseFile(tmpFilePath.string(), 8, 32);
+    BOOST_TEST(parsedFile.contentSize == (padding ? textSize / 8 * 8 + 8 : textSize));
+    CheckPassword checkPassword(parsedFile);
+    BOOST_TEST(!checkPassword.isPasswordAcceptable("aZ8"));
+    BOOST_TEST(checkPassword.isPasswordAcceptable("aZ7"));
+    if(padding)
+    {
+        CheckPassword paddingCheckPassword(parsedFile, true);
+        BOOST_TEST(paddingCheckPassword.isPasswordAcceptable("aZ7"));
+        const std::string text = checkPassword.getDecryptedText();
+        BOOST_TEST(std::count(text.end() - text.back(), text.end(), text.back()) == text.back());
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(generate_cipher_corpus_test, TmpFileFixture)
+{
+    // Files of corpus differ, while the same seed gives the same file.
+    tmpFile.close();
+    CipherFileParameters parameters;
+    parameters.password = "NONE";
+    parameters.textSize = 64;
+    parameters.seed = 5;
+    const std::vector<std::string> fileNames = generateCipherCorpus(tmpFilePath.string(), parameters, 11);
+    BOOST_TEST(fileNames.size() == 11);
+    BOOST_TEST(fileNames[7] == tmpFilePath.string() + ".07");
+
+    auto readFile = [](const std::string &fileName)
+    {
+        const ParsedFile parsedFile = parseFile(fileName, 8, 32);
+        return(std::string(parsedFile.initialValue.get(), parsedFile.shaCheckSum.get() + parsedFile.shaCheckSumSize));
+    };
+    parameters.seed = 12;
+    generateCipherFile(tmpFilePath.string(), parameters);
+    BOOST_TEST(readFile(tmpFilePath.string()) == readFile(fileNames[7]));
+    BOOST_TEST(readFile(fileNames[6]) != readFile(fileNames[7]));
+    for(const std::string &fileName: fileNames)
+    {
+        boost::filesystem::remove(fileName);
+    }
+
+    // Interrupted generation leaves no partially written files.
+    const std::atomic<bool> interrupted(true);
+    BOOST_TEST(!generateCipherFile(tmpFilePath.string(), parameters, &interrupted));
+    BOOST_TEST(!boost::filesystem::exists(tmpFilePath));
+    BOOST_TEST(generateCipherCorpus(tmpFilePath.string(), parameters, 3, &interrupted).empty());
+    BOOST_TEST(!boost::filesystem::exists(tmpFilePath.string() + ".0"));
+
+    parameters.textSize = 63;
+    BOOST_CHECK_THROW(generateCipherFile(tmpFilePath.string(), parameters), std::runtime_error);
+    BOOST_TEST(getCorpusFileName("file.bin", 0, 1) == "file.bin");
+    BOOST_TEST(getCorpusFileName("file.bin", 3, 10) == "file.bin.3");
+}
+
+BOOST_AUTO_TEST_CASE(parse_byte_size_test)
+{
+    BOOST_TEST(parseByteSize("0") == 0);
+    BOOST_TEST(parseByteSize("1000") == 1000);
+    BOOST_TEST(parseByteSize("64K") == 64 << 10);
+    BOOST_TEST(parseByteSize("3m") == 3 << 20);
+    BOOST_TEST(parseByteSize("2G") == 2ull << 30);
+    for(const char *size: {"", "K", "12KB", "1T", "-1", "1 K", "99999999999999999999", "17179869184G"})
+    {
+        BOOST_CHECK_THROW(parseByteSize(size), std::invalid_argument);
+    }
+}
@@ -0,0 +1,106 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <boost/test/data/test_case.hpp>
+
+#include <string>
+#include <vector>
+#include <set>
+#include <memory>
+#include <stdexcept>
+
+#include "search/markov_model.h"
+#include "search/mask_keyspace.h"
+
+#include "tmp_file_fixture.h"
+
+namespace
+{
+
+MarkovModel trainModel()
+{
+    MarkovModel model;
+    for(const std::string word: {"abc", "abd", "abd", "xbd"})
+    {
+        model.addWord(word.data(), word.size());
+    }
+    return(model);
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(markov_model_order_test)
+{
+    const MarkovModel model = trainModel();
+    BOOST_TEST(model.getCount(0, -1, 'a') == 3);
+    BOOST_TEST(model.getCount(2, 'b', 'd') == 3);
+    BOOST_TEST(model.getCount(2, 'a', 'd') == 0);
+
+    // Characters are ordered by counts after the previous one, then by counts at position, then by charset.
+    BOOST_TEST(model.orderCharset("abcdx", 0, -1) == "axbcd");
+    BOOST_TEST(model.orderCharset("abcdx", 2, 'b') == "dcabx");
+    BOOST_TEST(model.orderCharset("abcdx", 1, 'q') == "bacdx");
+    BOOST_TEST(model.orderCharset("abcdx", 5, 'a') == "abcdx");
+}
+
+BOOST_FIXTURE_TEST_CASE(markov_model_save_load_test, TmpFileFixture)
+{
+    tmpFile.close();
+    const MarkovModel model = trainModel();
+    model.save(tmpFilePath.string());
+    const MarkovModel loadedModel = MarkovModel::load(tmpFilePath.string());
+    for(const int previous: {-1, int('a'), int('b'), int('x')})
+    {
+        for(std::size_t position = 0; position < 4; ++position)
+        {
+            BOOST_TEST(loadedModel.orderCharset("abcdx", position, previous) ==
+                       model.orderCharset("abcdx", position, previous));
+        }
+    }
+
+    boost::filesystem::ofstream malformedFile(tmpFilePath, boost::filesystem::ofstream::binary);
+    malformedFile << "MKV1\x01";
+    malformedFile.close();
+    BOOST_CHECK_THROW(MarkovModel::load(tmpFilePath.string()), std::runtime_error);
+    BOOST_CHECK_THROW(MarkovModel::load(tmpFilePath.string() + ".absent"), std::runtime_error);
+}
+
+BOOST_DATA_TEST_CASE(markov_keyspace_test, boost::unit_test_framework::data::make({1, 3}), minLength)
+{
+    // Ordered keyspace contains the same passwords as lexicographic one, each of them once, the password
+    // of the most probable characters goes first and cursors produce the same passwords as decoding.
+    const MarkovModel model = trainModel();
+    const std::vector<std::string> charsets = parseMask("?l?l?1", {"abcdx"});
+    const MaskKeyspace keyspace(charsets, minLength, 3), orderedKeyspace(charsets, minLength, 3, &model);
+    BOOST_TEST(orderedKeyspace.size() == keyspace.size());
+    BOOST_TEST(orderedKeyspace.getDescription() != keyspace.getDescription());
+
+    std::set<std::string> passwords, orderedPasswords;
+    std::vector<std::string> orderedSequence;
+    std::vector<char> buffer(3);
+    for(KeyspaceIndex index = 0; index < keyspace.size(); ++index)
+    {
+        passwords.insert(std::string(buffer.data(), keyspace.decode(index, buffer.data())));
+        orderedSequence.push_back(std::string(buffer.data(), orderedKeyspace.decode(index, buffer.data())));
+        orderedPasswords.insert(orderedSequence.back());
+    }
+    BOOST_TEST(orderedPasswords.size() == orderedSequence.size());
+    BOOST_TEST(orderedPasswords == passwords);
+    BOOST_TEST(orderedSequence[minLength == 3 ? 0 : 26 + 26 * 26] == "abd");
+
+    const std::unique_ptr<CandidateCursor> cursor = orderedKeyspace.cursor();
+    CandidateBatch batch(10, orderedKeyspace.getMaxLength());
+    const KeyspaceIndex first = 7;
+    cursor->seek(first, orderedKeyspace.size());
+    KeyspaceIndex index = first;
+    bool hasCandidates = true;
+    while(hasCandidates)
+    {
+        batch.clear();
+        hasCandidates = cursor->fill(batch);
+        for(std::size_t batchIndex = 0; batchIndex < batch.size(); ++batchIndex, ++index)
+        {
+            BOOST_REQUIRE(batch[batchIndex] == orderedSequence[index]);
+        }
+    }
+    BOOST_TEST(index == orderedKeyspace.size());
+}
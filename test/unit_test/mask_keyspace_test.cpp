@@ -0,0 +1,149 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <boost/test/data/test_case.hpp>
+
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <memory>
+#include <algorithm>
+#include <utility>
+
+#include "search/mask_keyspace.h"
+
+BOOST_AUTO_TEST_CASE(mask_parse_test)
+{
+    BOOST_TEST(expandCharset("?d") == "0123456789");
+    BOOST_TEST(expandCharset("?h?d") == "0123456789abcdef");
+    BOOST_TEST(expandCharset("xy?dx??") == "xy0123456789?");
+    BOOST_TEST(expandCharset("?a").size() == 95);
+    BOOST_TEST(expandCharset("?b").size() == 256);
+
+    const std::vector<std::string> charsets = parseMask("a?u?1??", {"?dxy"});
+    BOOST_TEST(charsets.size() == 4);
+    BOOST_TEST(charsets[0] == "a");
+    BOOST_TEST(charsets[1] == "ABCDEFGHIJKLMNOPQRSTUVWXYZ");
+    BOOST_TEST(charsets[2] == "0123456789xy");
+    BOOST_TEST(charsets[3] == "?");
+
+    BOOST_CHECK_THROW(parseMask("?x", {}), std::invalid_argument);
+    BOOST_CHECK_THROW(parseMask("ab?", {}), std::invalid_argument);
+    BOOST_CHECK_THROW(parseMask("?2", {"abc"}), std::invalid_argument);
+    BOOST_CHECK_THROW(parseMask("?1", {"?z"}), std::invalid_argument);
+}
+
+BOOST_DATA_TEST_CASE(mask_keyspace_test,
+                     boost::unit_test_framework::data::make({1, 2, 3}) *
+                     boost::unit_test_framework::data::make({0, 1, 2}),
+                     minLength, extraLength)
+{
+    const std::vector<std::string> charsets = parseMask("?d?1x?1", {"abc"});
+    const std::size_t maxLength = minLength + extraLength;
+    if(maxLength > charsets.size())
+    {
+        return;
+    }
+    const MaskKeyspace keyspace(charsets, minLength, maxLength);
+
+    // Passwords of each length are the Cartesian product of charsets of mask prefix, shorter ones go first.
+    std::vector<std::string> expectedPasswords;
+    for(std::size_t length = minLength; length <= maxLength; ++length)
+    {
+        std::vector<std::string> passwords(1);
+        for(std::size_t position = 0; position < length; ++position)
+        {
+            std::vector<std::string> longerPasswords;
+            for(const std::string &password: passwords)
+            {
+                for(char character: charsets[position])
+                {
+                    longerPasswords.push_back(password + character);
+                }
+            }
+            passwords.swap(longerPasswords);
+        }
+        expectedPasswords.insert(expectedPasswords.end(), passwords.begin(), passwords.end());
+    }
+    BOOST_TEST(keyspace.size() == expectedPasswords.size());
+
+    // Cursor enumerates the same passwords as decoding, from any start and wrapping around after the last one.
+    for(KeyspaceIndex start: {KeyspaceIndex(0), keyspace.size() / 2, keyspace.size() - 1})
+    {
+        MaskKeyspaceCursor cursor(keyspace);
+        std::vector<char> buffer(keyspace.getMaxLength());
+        std::size_t length = cursor.seek(start, buffer.data());
+        for(KeyspaceIndex step = 0; step < keyspace.size(); ++step)
+        {
+            const KeyspaceIndex index = (start + step) % keyspace.size();
+            std::vector<char> decoded(keyspace.getMaxLength());
+            const std::size_t decodedLength = keyspace.decode(index, decoded.data());
+            BOOST_TEST(std::string(decoded.data(), decodedLength) == expectedPasswords[index]);
+            BOOST_TEST(std::string(buffer.data(), length) == expectedPasswords[index]);
+            length = cursor.next(buffer.data());
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(mask_keyspace_limits_test)
+{
+    // Default mask is Cartesian power of [a-zA-Z0-9], index of which is a number in base 62.
+    const MaskKeyspace keyspace(parseMask("?1?1?1", {"?l?u?d"}), 3, 3);
+    BOOST_TEST(keyspace.size() == 62 * 62 * 62);
+    const std::vector<std::pair<KeyspaceIndex, std::string>> expectedPasswords =
+    {
+        {0, "aaa"}, {(3 * 62 + 13) * 62 + 7, "dnh"}, {(26 * 62 + 51) * 62 + 52, "AZ0"}, {keyspace.size() - 1, "999"}
+    };
+    for(const auto &expectedPassword: expectedPasswords)
+    {
+        std::string password(3, ' ');
+        keyspace.decode(expectedPassword.first, &password[0]);
+        BOOST_TEST(password == expectedPassword.second);
+    }
+
+    BOOST_CHECK_THROW(MaskKeyspace(parseMask("?d?d", {}), 0, 2), std::invalid_argument);
+    BOOST_CHECK_THROW(MaskKeyspace(parseMask("?d?d", {}), 2, 1), std::invalid_argument);
+    BOOST_CHECK_THROW(MaskKeyspace(parseMask("?d?d", {}), 1, 3), std::invalid_argument);
+    // 256^8 is exactly 2^64, which doesn't fit into 64 bit index.
+    BOOST_CHECK_THROW(MaskKeyspace(parseMask("?b?b?b?b?b?b?b?b", {}), 8, 8), std::overflow_error);
+    BOOST_TEST(MaskKeyspace(parseMask("?b?b?b?b?b?b?b", {}), 7, 7).size() == (KeyspaceIndex(1) << 56));
+}
+
+BOOST_DATA_TEST_CASE(mask_cursor_test, boost::unit_test_framework::data::xrange(1, 19), maskLength)
+{
+    // Fixed length cursors (up to maxFixedMaskLength) and the generic one write the same passwords as decoding,
+    // also across partially filled batches.
+    std::vector<std::string> charsets;
+    for(int position = 0; position < maskLength; ++position)
+    {
+        charsets.push_back(position % 3 == 0 ? "?d" : position % 3 == 1 ? "xyz" : "Q");
+        charsets.back() = expandCharset(charsets.back());
+    }
+    for(const std::size_t minLength: {std::size_t(maskLength), std::size_t(1)})
+    {
+        const MaskKeyspace keyspace(charsets, minLength, maskLength);
+        const std::unique_ptr<CandidateCursor> cursor = keyspace.cursor();
+        CandidateBatch batch(7, keyspace.getMaxLength());
+        // Batch already contains a candidate, so parts of passwords start in the middle of batch.
+        for(const KeyspaceIndex first: {KeyspaceIndex(0), keyspace.size() / 3,
+                                         keyspace.size() - std::min<KeyspaceIndex>(keyspace.size(), 100)})
+        {
+            const KeyspaceIndex last = std::min<KeyspaceIndex>(first + 100, keyspace.size());
+            cursor->seek(first, last);
+            KeyspaceIndex index = first;
+            bool hasCandidates = true;
+            while(hasCandidates)
+            {
+                batch.clear();
+                batch.push(nullptr, 0);
+                hasCandidates = cursor->fill(batch);
+                for(std::size_t batchIndex = 1; batchIndex < batch.size(); ++batchIndex, ++index)
+                {
+                    std::vector<char> decoded(keyspace.getMaxLength());
+                    const std::size_t decodedLength = keyspace.decode(index, decoded.data());
+                    BOOST_REQUIRE(batch[batchIndex] == boost::string_view(decoded.data(), decodedLength));
+                }
+            }
+            BOOST_TEST(index == last);
+        }
+    }
+}
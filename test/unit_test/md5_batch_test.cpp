@@ -0,0 +1,94 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <boost/test/data/test_case.hpp>
+
+#include <gcrypt.h>
+
+#include <vector>
+#include <random>
+
+#include "cryptography/md5_batch.h"
+
+BOOST_DATA_TEST_CASE(md5_batch_test,
+                     boost::unit_test_framework::data::make({SimdLevel::Scalar, SimdLevel::AVX2, SimdLevel::AVX512}) *
+                     boost::unit_test_framework::data::make({1, 7, 37, 64}),
+                     simdLevel, count)
+{
+    if(!isSimdLevelSupported(simdLevel))
+    {
+        return;
+    }
+    
+    // Lengths cover empty messages, all single block lengths and a few longer messages hashed by libgcrypt.
+    const std::size_t stride = 80;
+    std::mt19937 generator(count);
+    std::uniform_int_distribution<int> byteDistribution(0, 255);
+    std::uniform_int_distribution<std::size_t> lengthDistribution(0, stride);
+    
+    std::vector<unsigned char> messages(count * stride);
+    std::vector<std::size_t> lengths(count);
+    for(int messageIndex = 0; messageIndex < count; ++messageIndex)
+    {
+        lengths[messageIndex] = messageIndex <= 56 ? messageIndex : lengthDistribution(generator);
+        for(std::size_t byteIndex = 0; byteIndex < stride; ++byteIndex)
+        {
+            messages[messageIndex * stride + byteIndex] = byteDistribution(generator);
+        }
+    }
+    
+    std::vector<unsigned char> digests(count * md5DigestSize);
+    md5Batch(messages.data(), stride, lengths.data(), count, digests.data(), simdLevel);
+    
+    for(int messageIndex = 0; messageIndex < count; ++messageIndex)
+    {
+        std::vector<unsigned char> expectedDigest(md5DigestSize);
+        gcry_md_hash_buffer(GCRY_MD_MD5, expectedDigest.data(), messages.data() + messageIndex * stride,
+                            lengths[messageIndex]);
+        
+        std::vector<unsigned char> digest(digests.begin() + messageIndex * md5DigestSize,
+                                          digests.begin() + (messageIndex + 1) * md5DigestSize);
+        BOOST_TEST(digest == expectedDigest, boost::test_tools::per_element());
+    }
+}
+
+BOOST_DATA_TEST_CASE(md5_batch_shared_prefix_test,
+                     boost::unit_test_framework::data::make({SimdLevel::Scalar, SimdLevel::AVX2, SimdLevel::AVX512}) *
+                     boost::unit_test_framework::data::xrange(1, 57),
+                     simdLevel, length)
+{
+    if(!isSimdLevelSupported(simdLevel))
+    {
+        return;
+    }
+    
+    // Messages are enumerated like passwords of mask: the last character changes first, so groups of lanes share
+    // words of block, which are cached between groups, until a carry changes them. A few messages of other lengths
+    // break sharing in the middle of batch.
+    const std::size_t count = 300;
+    std::vector<unsigned char> messages(count * length);
+    std::vector<std::size_t> lengths(count, length);
+    for(std::size_t messageIndex = 0; messageIndex < count; ++messageIndex)
+    {
+        std::size_t index = messageIndex;
+        for(std::size_t position = length; position-- > 0; index /= 7)
+        {
+            messages[messageIndex * length + position] = 'a' + index % 7;
+        }
+    }
+    lengths[100] = length - 1;
+    lengths[201] = 0;
+    
+    std::vector<unsigned char> digests(count * md5DigestSize);
+    md5Batch(messages.data(), length, lengths.data(), count, digests.data(), simdLevel);
+    
+    for(std::size_t messageIndex = 0; messageIndex < count; ++messageIndex)
+    {
+        std::vector<unsigned char> expectedDigest(md5DigestSize);
+        gcry_md_hash_buffer(GCRY_MD_MD5, expectedDigest.data(), messages.data() + messageIndex * length,
+                            lengths[messageIndex]);
+        
+        std::vector<unsigned char> digest(digests.begin() + messageIndex * md5DigestSize,
+                                          digests.begin() + (messageIndex + 1) * md5DigestSize);
+        BOOST_TEST(digest == expectedDigest, boost::test_tools::per_element());
+    }
+}
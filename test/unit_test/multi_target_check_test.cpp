@@ -0,0 +1,139 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <boost/test/data/test_case.hpp>
+
+#include <gcrypt.h>
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "cryptography/multi_target_check.h"
+#include "cryptography/md5_batch.h"
+#include "util/make_shared_array.h"
+
+namespace
+{
+
+/**
+ * Encrypts text padded with PKCS#7 by 3DES (EDE2) with MD5 of password as key, like files in data folder.
+ */
+ParsedFile encryptFile(const std::string &password, const std::string &initialValue, std::string text)
+{
+    const std::size_t paddingSize = tripleDesBlockSize - text.size() % tripleDesBlockSize;
+    text.append(paddingSize, static_cast<char>(paddingSize));
+
+    unsigned char key[3 * tripleDesBlockSize];
+    gcry_md_hash_buffer(GCRY_MD_MD5, key, password.data(), password.size());
+    std::copy_n(key, tripleDesBlockSize, key + tripleDesEde2KeySize);
+
+    const boost::shared_array<unsigned char> initialValueData = make_shared_array<unsigned char>(initialValue.size());
+    std::copy(initialValue.begin(), initialValue.end(), initialValueData.get());
+    const boost::shared_array<unsigned char> content = make_shared_array<unsigned char>(text.size());
+    const boost::shared_array<unsigned char> shaCheckSum = make_shared_array<unsigned char>(32);
+    gcry_md_hash_buffer(GCRY_MD_SHA256, shaCheckSum.get(), text.data(), text.size());
+
+    gcry_cipher_hd_t cipher;
+    BOOST_REQUIRE(!gcry_cipher_open(&cipher, GCRY_CIPHER_3DES, GCRY_CIPHER_MODE_CBC, 0));
+    BOOST_REQUIRE(!gcry_cipher_setkey(cipher, key, sizeof(key)));
+    BOOST_REQUIRE(!gcry_cipher_setiv(cipher, initialValue.data(), initialValue.size()));
+    BOOST_REQUIRE(!gcry_cipher_encrypt(cipher, content.get(), text.size(), text.data(), text.size()));
+    gcry_cipher_close(cipher);
+
+    ParsedFile parsedFile;
+    parsedFile.initialValueSize = initialValue.size();
+    parsedFile.initialValue = initialValueData;
+    parsedFile.contentSize = text.size();
+    parsedFile.content = content;
+    parsedFile.shaCheckSumSize = 32;
+    parsedFile.shaCheckSum = shaCheckSum;
+    return(parsedFile);
+}
+
+}
+
+BOOST_DATA_TEST_CASE(multi_target_check_test, boost::unit_test_framework::data::make({false, true}),
+                     usePaddingPrefilter)
+{
+    const std::string commonText(1000, 'x');
+    const std::vector<ParsedFile> files = {
+        encryptFile("abc", "initial!", commonText + "first"),
+        // The same key, initial value and beginning of text give the same beginning of ciphertext.
+        encryptFile("abc", "initial!", commonText + "second"),
+        encryptFile("xyz", "initial!", commonText + "first"),
+        encryptFile("abc", "initial!", commonText + "first"),
+        encryptFile("qwe", "another!", "short")
+    };
+    const std::vector<std::string> passwords = {"nope", "abc", "qwe", "xyz", "abc1"};
+
+    std::vector<unsigned char> digests(passwords.size() * md5DigestSize);
+    for(std::size_t passwordIndex = 0; passwordIndex < passwords.size(); ++passwordIndex)
+    {
+        gcry_md_hash_buffer(GCRY_MD_MD5, digests.data() + passwordIndex * md5DigestSize,
+                            passwords[passwordIndex].data(), passwords[passwordIndex].size());
+    }
+
+    MultiTargetCheck multiTargetCheck(files, usePaddingPrefilter);
+    BOOST_TEST(multiTargetCheck.getTargetsCount() == files.size());
+    // Without prefilter the first, the second and the fourth files share the beginning, with prefilter only
+    // the first and the fourth files share the last blocks.
+    BOOST_TEST(multiTargetCheck.getGroupsCount() == (usePaddingPrefilter ? 4 : 3));
+
+    std::vector<boost::dynamic_bitset<>> acceptableKeys;
+    multiTargetCheck.checkKeys(digests.data(), passwords.size(), acceptableKeys);
+    BOOST_REQUIRE(acceptableKeys.size() == files.size());
+    const std::vector<std::string> expectedPasswords = {"abc", "abc", "xyz", "abc", "qwe"};
+    for(std::size_t targetIndex = 0; targetIndex < files.size(); ++targetIndex)
+    {
+        BOOST_REQUIRE(acceptableKeys[targetIndex].size() == passwords.size());
+        for(std::size_t passwordIndex = 0; passwordIndex < passwords.size(); ++passwordIndex)
+        {
+            BOOST_TEST(acceptableKeys[targetIndex][passwordIndex] ==
+                       (passwords[passwordIndex] == expectedPasswords[targetIndex]));
+        }
+    }
+
+    BOOST_TEST(multiTargetCheck.getTarget(1).isPasswordAcceptable("abc"));
+    BOOST_TEST(multiTargetCheck.getTarget(1).getDecryptedText().substr(0, commonText.size() + 6) ==
+               commonText + "second");
+}
+
+BOOST_DATA_TEST_CASE(multi_target_check_plaintext_filter_test, boost::unit_test_framework::data::make({false, true}),
+                     usePaddingPrefilter)
+{
+    const std::vector<ParsedFile> files = {
+        encryptFile("abc", "initial!", "%PDF-1.4 " + std::string(1000, 'x')),
+        // The first blocks checked by filter are equal to the first file, so these files are checked together.
+        encryptFile("abc", "initial!", "%PDF-1.4 " + std::string(1000, 'x') + "tail"),
+        encryptFile("qwe", "another!", "%PDF-1.4"),
+        // Text doesn't match the filter, so its password is rejected.
+        encryptFile("abc", "initial!", "%PS-Adobe " + std::string(1000, 'x'))
+    };
+    const std::vector<std::string> passwords = {"nope", "abc", "qwe", "xyz"};
+
+    std::vector<unsigned char> digests(passwords.size() * md5DigestSize);
+    for(std::size_t passwordIndex = 0; passwordIndex < passwords.size(); ++passwordIndex)
+    {
+        gcry_md_hash_buffer(GCRY_MD_MD5, digests.data() + passwordIndex * md5DigestSize,
+                            passwords[passwordIndex].data(), passwords[passwordIndex].size());
+    }
+
+    MultiTargetCheck multiTargetCheck(files, usePaddingPrefilter, PlaintextFilter("%PDF-", 600));
+    BOOST_TEST(multiTargetCheck.getGroupsCount() == 3);
+
+    std::vector<boost::dynamic_bitset<>> acceptableKeys;
+    multiTargetCheck.checkKeys(digests.data(), passwords.size(), acceptableKeys);
+    const std::vector<std::string> expectedPasswords = {"abc", "abc", "qwe", ""};
+    for(std::size_t targetIndex = 0; targetIndex < files.size(); ++targetIndex)
+    {
+        for(std::size_t passwordIndex = 0; passwordIndex < passwords.size(); ++passwordIndex)
+        {
+            BOOST_TEST(acceptableKeys[targetIndex][passwordIndex] ==
+                       (passwords[passwordIndex] == expectedPasswords[targetIndex]));
+        }
+    }
+
+    BOOST_TEST(!multiTargetCheck.getTarget(3).isPasswordAcceptable("abc"));
+    BOOST_TEST(multiTargetCheck.getTarget(0).isPasswordAcceptable("abc"));
+    BOOST_TEST(multiTargetCheck.getTarget(0).getDecryptedText().substr(0, 9) == "%PDF-1.4 ");
+}
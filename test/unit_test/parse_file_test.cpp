@@ -4,36 +4,12 @@
 
 #include "io/parse_file.h"
 
-#include <boost/filesystem/path.hpp>
-#include <boost/filesystem/operations.hpp>
-#include <boost/filesystem/fstream.hpp>
+#include "tmp_file_fixture.h"
 
 #include <string>
 #include <random>
 #include <algorithm>
 
-struct TmpFileFixture
-{
-    boost::filesystem::path tmpFilePath;
-    boost::filesystem::ofstream tmpFile;
-    
-    TmpFileFixture(const std::string &dirForTmpFile = "."):
-        tmpFilePath(boost::filesystem::unique_path(boost::filesystem::path(dirForTmpFile) /
-                                               "tempFile_for_unit_testing-%%%%%%")),
-        tmpFile(tmpFilePath, boost::filesystem::ofstream::binary)
-    {}
-    
-    ~TmpFileFixture()
-    {
-        if(tmpFile.is_open())
-        {
-            tmpFile.close();
-        }
-        
-        boost::filesystem::remove(tmpFilePath);
-    }
-};
-
 bool operator==(const ParsedFile &lhs, const ParsedFile &rhs)
 {
     return(lhs.initialValueSize == rhs.initialValueSize &&
@@ -75,17 +51,32 @@ BOOST_DATA_TEST_CASE_F(TmpFileFixture, parsed_file_test,
     
     parsedFile.initialValueSize = FirstFieldSize;
     parsedFile.initialValue.reset(new unsigned char[parsedFile.initialValueSize]);
-    tmpFile.write(reinterpret_cast<char *>(parsedFile.initialValue.get()), parsedFile.initialValueSize);
+    tmpFile.write(reinterpret_cast<const char *>(parsedFile.initialValue.get()), parsedFile.initialValueSize);
     
     parsedFile.contentSize = SecondFieldSize;
     parsedFile.content.reset(new unsigned char[parsedFile.contentSize]);
-    tmpFile.write(reinterpret_cast<char *>(parsedFile.content.get()), parsedFile.contentSize);
+    tmpFile.write(reinterpret_cast<const char *>(parsedFile.content.get()), parsedFile.contentSize);
     
     parsedFile.shaCheckSumSize = ThirdFieldSize;
     parsedFile.shaCheckSum.reset(new unsigned char[parsedFile.shaCheckSumSize]);
-    tmpFile.write(reinterpret_cast<char *>(parsedFile.shaCheckSum.get()), parsedFile.shaCheckSumSize);
+    tmpFile.write(reinterpret_cast<const char *>(parsedFile.shaCheckSum.get()), parsedFile.shaCheckSumSize);
     
     tmpFile.close();
     
-    BOOST_TEST(parsedFile == parseFile(tmpFilePath.string(), FirstFieldSize, ThirdFieldSize));
+    ParsedFile mappedFile = parseFile(tmpFilePath.string(), FirstFieldSize, ThirdFieldSize);
+    BOOST_TEST(parsedFile == mappedFile);
+    
+    // Fields are views into the same mapping without copies, which stays mapped while any of them is alive.
+    BOOST_TEST(mappedFile.content.get() == mappedFile.initialValue.get() + FirstFieldSize);
+    BOOST_TEST(mappedFile.shaCheckSum.get() == mappedFile.content.get() + SecondFieldSize);
+    const boost::shared_array<const unsigned char> shaCheckSum = mappedFile.shaCheckSum;
+    mappedFile = ParsedFile();
+    BOOST_TEST(std::equal(shaCheckSum.get(), shaCheckSum.get() + ThirdFieldSize, parsedFile.shaCheckSum.get()));
+}
+
+BOOST_FIXTURE_TEST_CASE(parsed_file_too_short_test, TmpFileFixture)
+{
+    tmpFile.write("0123456789", 10);
+    tmpFile.close();
+    BOOST_CHECK_THROW(parseFile(tmpFilePath.string(), 8, 2), std::runtime_error);
 }
@@ -0,0 +1,62 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <stdexcept>
+
+#include "cryptography/plaintext_filter.h"
+
+namespace
+{
+
+bool isAcceptable(const PlaintextFilter &plaintextFilter, const std::string &text)
+{
+    return(plaintextFilter.isPrefixAcceptable(reinterpret_cast<const unsigned char *>(text.data()), text.size()));
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(parse_known_prefix_test)
+{
+    BOOST_TEST(parseKnownPrefix("%PDF-") == "%PDF-");
+    BOOST_TEST(parseKnownPrefix("PK\\x03\\x04") == std::string("PK\x03\x04", 4));
+    BOOST_TEST(parseKnownPrefix("\\xfF\\\\x") == "\xff\\x");
+    BOOST_TEST(parseKnownPrefix("\\x00") == std::string(1, '\0'));
+
+    BOOST_CHECK_THROW(parseKnownPrefix("\\"), std::invalid_argument);
+    BOOST_CHECK_THROW(parseKnownPrefix("\\x0"), std::invalid_argument);
+    BOOST_CHECK_THROW(parseKnownPrefix("\\xg0"), std::invalid_argument);
+    BOOST_CHECK_THROW(parseKnownPrefix("\\n"), std::invalid_argument);
+
+    BOOST_TEST(getFormatSignature("zip") == std::string("PK\x03\x04", 4));
+    BOOST_CHECK_THROW(getFormatSignature("doc"), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(plaintext_filter_test)
+{
+    BOOST_TEST(PlaintextFilter().isEmpty());
+    BOOST_TEST(isAcceptable(PlaintextFilter(), "\x01\x02"));
+
+    const PlaintextFilter plaintextFilter("<?xml", 12);
+    BOOST_TEST(!plaintextFilter.isEmpty());
+    BOOST_TEST(plaintextFilter.getCheckedSize() == 12);
+    BOOST_TEST(plaintextFilter.isApplicable(5));
+    BOOST_TEST(!plaintextFilter.isApplicable(4));
+
+    BOOST_TEST(isAcceptable(plaintextFilter, "<?xml version=\"1.0\"?>"));
+    BOOST_TEST(isAcceptable(plaintextFilter, "<?xml\tv\r\n1.0\x01"));
+    BOOST_TEST(!isAcceptable(plaintextFilter, "<?xmL version"));
+    BOOST_TEST(!isAcceptable(plaintextFilter, "<?xml vers\x80on"));
+    // Partial check sees only the given bytes.
+    BOOST_TEST(isAcceptable(plaintextFilter, "<?x"));
+
+    // The last block of text could hold padding, so it isn't checked for printable characters.
+    const PlaintextFilter limitedFilter = plaintextFilter.limitTo(16, 8);
+    BOOST_TEST(limitedFilter.getCheckedSize() == 8);
+    BOOST_TEST(isAcceptable(limitedFilter, "<?xml a>\x08\x08\x08\x08\x08\x08\x08\x08"));
+    BOOST_TEST(plaintextFilter.limitTo(8, 8).getCheckedSize() == 5);
+    BOOST_TEST(plaintextFilter.limitTo(100, 8).getCheckedSize() == 12);
+
+    BOOST_TEST(plaintextFilter.getDescription() != PlaintextFilter("<?xml", 0).getDescription());
+    BOOST_TEST(plaintextFilter.getDescription() != PlaintextFilter("<?xm", 12).getDescription());
+}
@@ -0,0 +1,64 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include <string>
+#include <sstream>
+#include <chrono>
+
+#include "search/progress_reporter.h"
+#include "tmp_file_fixture.h"
+
+BOOST_AUTO_TEST_CASE(progress_status_test)
+{
+    ProgressStatus status;
+    status.elapsedSeconds = 3725;
+    status.doneIndices = 250;
+    status.totalIndices = 1000;
+    status.candidatesPerSecond = 1234.5;
+    status.etaSeconds = -1;
+    status.threadCandidates = {100, 50};
+    status.imbalancePercent = 50;
+    status.finished = false;
+    BOOST_TEST(status.getDonePercent() == 25.0);
+
+    std::ostringstream text;
+    text << status;
+    BOOST_TEST(text.str() == "Progress: 25.00% (250/1000), 1234 passwords/s, elapsed 1:02:05, ETA unknown, "
+                             "2 threads, imbalance 50%");
+
+    std::stringstream json;
+    writeJson(json, status);
+    boost::property_tree::ptree tree;
+    boost::property_tree::read_json(json, tree);
+    BOOST_TEST(tree.get<KeyspaceIndex>("done") == 250);
+    BOOST_TEST(tree.get<std::string>("eta_seconds") == "null");
+    BOOST_TEST(tree.get_child("thread_candidates").size() == 2);
+    BOOST_TEST(tree.get<std::string>("finished") == "false");
+}
+
+BOOST_FIXTURE_TEST_CASE(progress_reporter_test, TmpFileFixture)
+{
+    std::ostringstream stream;
+    {
+        // Interval is long, so only the final status is reported.
+        ProgressReporter progressReporter(2, 1000, 100, std::chrono::hours(1), &stream, tmpFilePath.string());
+        progressReporter.start();
+        progressReporter.getThreadProgress(0).addCandidates(300);
+        progressReporter.getThreadProgress(0).addIndices(300);
+        progressReporter.getThreadProgress(1).addCandidates(100);
+        progressReporter.getThreadProgress(1).addIndices(100);
+        progressReporter.getThreadProgress(1).addIndices(100);
+    }
+    BOOST_TEST(stream.str().find("Finished: 60.00% (600/1000)") == 0);
+    BOOST_TEST(stream.str().find("2 threads, imbalance 67%") != std::string::npos);
+
+    boost::property_tree::ptree tree;
+    boost::property_tree::read_json(tmpFilePath.string(), tree);
+    BOOST_TEST(tree.get<KeyspaceIndex>("total") == 1000);
+    BOOST_TEST(tree.get<KeyspaceIndex>("done") == 600);
+    BOOST_TEST(tree.get<std::string>("finished") == "true");
+    BOOST_TEST(tree.get<double>("eta_seconds") >= 0);
+}
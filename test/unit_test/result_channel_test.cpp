@@ -0,0 +1,74 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <thread>
+#include <utility>
+
+#include "search/search_worker.h"
+#include "search/result_channel.h"
+#include "util/mpsc_queue.h"
+
+BOOST_AUTO_TEST_CASE(mpsc_queue_test)
+{
+    const std::size_t producersCount = 4, valuesCount = 10000;
+    MpscQueue<std::pair<std::size_t, std::size_t>> queue;
+    std::vector<std::thread> producers;
+    for(std::size_t producer = 0; producer < producersCount; ++producer)
+    {
+        producers.emplace_back([&queue, producer, valuesCount]()
+        {
+            for(std::size_t value = 0; value < valuesCount; ++value)
+            {
+                queue.push(std::make_pair(producer, value));
+            }
+        });
+    }
+
+    // Values of each producer are popped in order of pushing, while producers are still running.
+    std::vector<std::size_t> nextValues(producersCount, 0);
+    std::size_t poppedCount = 0;
+    std::pair<std::size_t, std::size_t> value;
+    while(poppedCount < producersCount * valuesCount)
+    {
+        if(queue.tryPop(value))
+        {
+            BOOST_REQUIRE(value.second == nextValues[value.first]);
+            ++nextValues[value.first];
+            ++poppedCount;
+        }
+    }
+    for(std::thread &producer: producers)
+    {
+        producer.join();
+    }
+    BOOST_TEST(!queue.tryPop(value));
+}
+
+BOOST_AUTO_TEST_CASE(result_channel_test)
+{
+    const std::vector<SearchTarget> targets = {{"first.bin", ParsedFile(), 0}, {"second.bin", ParsedFile(), 1}};
+    SearchOptions searchOptions;
+    searchOptions.printDecryptedText = true;
+    searchOptions.printFileNames = true;
+    searchOptions.stopAfter = 2;
+
+    std::ostringstream output;
+    ResultChannel resultChannel(targets, searchOptions, output);
+    resultChannel.push({0, "abc", "text"});
+    resultChannel.push({1, "xyz", "other"});
+    resultChannel.push({0, "abd", "text"});
+    // Search is cancelled only when each target has got enough passwords.
+    BOOST_TEST(!resultChannel.isCancelled());
+    resultChannel.push({1, "xyw", "other"});
+    BOOST_TEST(resultChannel.isCancelled());
+    // Passwords found before workers notice cancellation aren't printed.
+    resultChannel.push({0, "abe", "text"});
+    resultChannel.push({1, "xyv", "other"});
+    resultChannel.close();
+
+    BOOST_TEST(output.str() == "first.bin:abc\ntext\nsecond.bin:xyz\nother\nfirst.bin:abd\ntext\n"
+                               "second.bin:xyw\nother\n");
+}
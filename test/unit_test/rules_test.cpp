@@ -0,0 +1,117 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <boost/test/data/test_case.hpp>
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+
+#include "search/rules.h"
+#include "search/mask_keyspace.h"
+
+namespace
+{
+
+std::string applyRule(const std::string &rule, const std::string &word)
+{
+    unsigned char result[ruleMaxResultLength];
+    const std::size_t length = Rule(rule).apply(word.data(), word.size(), result);
+    return(length == ruleRejected ? std::string("<rejected>") : std::string(result, result + length));
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(rule_apply_test)
+{
+    BOOST_TEST(applyRule(":", "pAss1") == "pAss1");
+    BOOST_TEST(applyRule("l", "pAss1") == "pass1");
+    BOOST_TEST(applyRule("u", "pAss1") == "PASS1");
+    BOOST_TEST(applyRule("c", "pAss1") == "Pass1");
+    BOOST_TEST(applyRule("C", "pAss1") == "pASS1");
+    BOOST_TEST(applyRule("t", "pAss1") == "PaSS1");
+    BOOST_TEST(applyRule("T1", "pAss1") == "pass1");
+    BOOST_TEST(applyRule("T9", "pAss1") == "pAss1");
+    BOOST_TEST(applyRule("r", "pAss1") == "1ssAp");
+    BOOST_TEST(applyRule("d", "ab") == "abab");
+    BOOST_TEST(applyRule("f", "ab") == "abba");
+    BOOST_TEST(applyRule("$1 $2", "ab") == "ab12");
+    BOOST_TEST(applyRule("^1^2", "ab") == "21ab");
+    BOOST_TEST(applyRule("[", "abc") == "bc");
+    BOOST_TEST(applyRule("]", "abc") == "ab");
+    BOOST_TEST(applyRule("[]", "") == "");
+    BOOST_TEST(applyRule("sa@ so0", "foobar") == "f00b@r");
+    BOOST_TEST(applyRule("@o", "foobar") == "fbar");
+    BOOST_TEST(applyRule("c sa4 $!", "banana") == "B4n4n4!");
+    BOOST_TEST(applyRule("$ ", "ab") == "ab ");
+
+    // Results longer than ruleMaxResultLength are rejected.
+    const std::string longWord(ruleMaxResultLength / 2 + 1, 'x');
+    BOOST_TEST(applyRule("d", longWord) == "<rejected>");
+    BOOST_TEST(applyRule("$1", std::string(ruleMaxResultLength, 'x')) == "<rejected>");
+    BOOST_TEST(applyRule(":", std::string(ruleMaxResultLength + 1, 'x')) == "<rejected>");
+
+    BOOST_CHECK_THROW(Rule("x"), std::invalid_argument);
+    BOOST_CHECK_THROW(Rule("sa"), std::invalid_argument);
+    BOOST_CHECK_THROW(Rule("$"), std::invalid_argument);
+    BOOST_CHECK_THROW(Rule("T-"), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(parse_rules_test)
+{
+    std::istringstream input("# comment\n:\r\n\nr\nc $1\n");
+    BOOST_TEST(parseRules(input).size() == 3);
+
+    std::istringstream emptyInput("# only comment\n\n");
+    BOOST_CHECK_THROW(parseRules(emptyInput), std::invalid_argument);
+
+    std::istringstream malformedInput(":\nq\n");
+    BOOST_CHECK_THROW(parseRules(malformedInput), std::invalid_argument);
+}
+
+BOOST_DATA_TEST_CASE(ruled_candidate_source_test,
+                     boost::unit_test_framework::data::make({1, 7, 100}) *
+                     boost::unit_test_framework::data::make({1, 5, 64}),
+                     chunkSize, batchCapacity)
+{
+    const std::vector<std::string> definitions = {":", "u", "r $9", "]"};
+    std::vector<Rule> rules(definitions.begin(), definitions.end());
+    std::unique_ptr<const CandidateSource> base(new MaskKeyspace(parseMask("?1?d", {"ab"}), 1, 2));
+    const RuledCandidateSource candidates(std::move(base), rules);
+    BOOST_TEST(candidates.size() == 22);
+
+    // Each base candidate is expanded by all rules in their order, whatever sizes of chunks and batches are.
+    std::vector<std::string> expectedCandidates;
+    const std::vector<std::string> words = {"a", "b", "a0", "a1", "a2", "a3", "a4", "a5", "a6", "a7", "a8", "a9",
+                                            "b0", "b1", "b2", "b3", "b4", "b5", "b6", "b7", "b8", "b9"};
+    for(const std::string &word: words)
+    {
+        for(const Rule &rule: rules)
+        {
+            unsigned char result[ruleMaxResultLength];
+            const std::size_t length = rule.apply(word.data(), word.size(), result);
+            expectedCandidates.push_back(std::string(result, result + length));
+        }
+    }
+
+    std::vector<std::string> producedCandidates;
+    const auto cursor = candidates.cursor();
+    CandidateBatch batch(batchCapacity, candidates.getMaxLength());
+    for(KeyspaceIndex first = 0; first < candidates.size(); first += chunkSize)
+    {
+        cursor->seek(first, std::min<KeyspaceIndex>(first + chunkSize, candidates.size()));
+        bool hasCandidates = true;
+        while(hasCandidates)
+        {
+            batch.clear();
+            hasCandidates = cursor->fill(batch);
+            for(std::size_t index = 0; index < batch.size(); ++index)
+            {
+                producedCandidates.push_back(batch[index].to_string());
+            }
+        }
+    }
+    BOOST_TEST(producedCandidates == expectedCandidates, boost::test_tools::per_element());
+}
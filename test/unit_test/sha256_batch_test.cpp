@@ -0,0 +1,61 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <boost/test/data/test_case.hpp>
+
+#include <gcrypt.h>
+
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include "cryptography/sha256_batch.h"
+
+BOOST_DATA_TEST_CASE(sha256_batch_test,
+                     boost::unit_test_framework::data::make({Sha256Kernel::Scalar, Sha256Kernel::ShaNi,
+                                                             Sha256Kernel::AVX2, Sha256Kernel::AVX512}) *
+                     boost::unit_test_framework::data::make({1, 9, 33}) *
+                     boost::unit_test_framework::data::make({0, 55, 56, 64, 300}),
+                     kernel, count, size)
+{
+    if(!isSha256KernelSupported(kernel))
+    {
+        return;
+    }
+
+    const std::size_t stride = 320;
+    std::mt19937 generator(count * size);
+    std::uniform_int_distribution<int> byteDistribution(0, 255);
+    std::vector<unsigned char> messages(count * stride);
+    std::generate(messages.begin(), messages.end(), [&]() {return(byteDistribution(generator));});
+
+    // Messages are fed by parts of random sizes, so that both buffered and direct hashing of blocks are covered.
+    Sha256Batch batch(count, kernel);
+    batch.reset(count);
+    std::uniform_int_distribution<int> partDistribution(0, 100);
+    for(int offset = 0; offset < size;)
+    {
+        const int partSize = std::min(partDistribution(generator), size - offset);
+        batch.update(messages.data() + offset, stride, partSize);
+        offset += partSize;
+    }
+    const unsigned char *digests = batch.finish();
+
+    for(int messageIndex = 0; messageIndex < count; ++messageIndex)
+    {
+        std::vector<unsigned char> expectedDigest(sha256DigestSize);
+        gcry_md_hash_buffer(GCRY_MD_SHA256, expectedDigest.data(), messages.data() + messageIndex * stride, size);
+
+        std::vector<unsigned char> digest(digests + messageIndex * sha256DigestSize,
+                                          digests + (messageIndex + 1) * sha256DigestSize);
+        BOOST_TEST(digest == expectedDigest, boost::test_tools::per_element());
+    }
+
+    // Only messages with the expected digest are matched.
+    std::vector<unsigned char> expectedDigest(sha256DigestSize);
+    gcry_md_hash_buffer(GCRY_MD_SHA256, expectedDigest.data(), messages.data() + (count - 1) * stride, size);
+    boost::dynamic_bitset<> matches;
+    sha256Batch(messages.data(), stride, size, count, expectedDigest.data(), matches, kernel);
+    BOOST_TEST(matches.size() == static_cast<std::size_t>(count));
+    BOOST_TEST(matches[count - 1]);
+    BOOST_TEST(matches.count() == (size == 0 ? static_cast<std::size_t>(count) : 1));
+}
@@ -0,0 +1,35 @@
+#ifndef TMP_FILE_FIXTURE_H
+#define TMP_FILE_FIXTURE_H
+
+#include <boost/filesystem/path.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include <string>
+
+/**
+ * Creates temporary file with unique name, which is removed on destruction.
+ */
+struct TmpFileFixture
+{
+    boost::filesystem::path tmpFilePath;
+    boost::filesystem::ofstream tmpFile;
+    
+    TmpFileFixture(const std::string &dirForTmpFile = "."):
+        tmpFilePath(boost::filesystem::unique_path(boost::filesystem::path(dirForTmpFile) /
+                                               "tempFile_for_unit_testing-%%%%%%")),
+        tmpFile(tmpFilePath, boost::filesystem::ofstream::binary)
+    {}
+    
+    ~TmpFileFixture()
+    {
+        if(tmpFile.is_open())
+        {
+            tmpFile.close();
+        }
+        
+        boost::filesystem::remove(tmpFilePath);
+    }
+};
+
+#endif
@@ -0,0 +1,56 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <boost/test/data/test_case.hpp>
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "search/wordlist.h"
+
+#include "tmp_file_fixture.h"
+
+BOOST_DATA_TEST_CASE_F(TmpFileFixture, wordlist_test,
+                       boost::unit_test_framework::data::make({1, 2, 3, 5, 8, 13, 1000}) *
+                       boost::unit_test_framework::data::make({1, 3, 64}),
+                       chunkSize, batchCapacity)
+{
+    // Windows line endings, empty lines and the last line without line ending.
+    tmpFile << "password\n123456\r\n\nqwerty\n\r\nabc\nletmein";
+    tmpFile.close();
+    const std::vector<std::string> expectedWords = {"password", "123456", "qwerty", "abc", "letmein"};
+
+    const Wordlist wordlist(tmpFilePath.string());
+    BOOST_TEST(wordlist.size() == 38);
+
+    // Any split of wordlist into chunks gives each word exactly once and in order of file.
+    std::vector<std::string> words;
+    const auto cursor = wordlist.cursor();
+    CandidateBatch batch(batchCapacity, wordlist.getMaxLength());
+    for(KeyspaceIndex first = 0; first < wordlist.size(); first += chunkSize)
+    {
+        cursor->seek(first, std::min<KeyspaceIndex>(first + chunkSize, wordlist.size()));
+        bool hasCandidates = true;
+        while(hasCandidates)
+        {
+            batch.clear();
+            hasCandidates = cursor->fill(batch);
+            BOOST_TEST(batch.size() <= static_cast<std::size_t>(batchCapacity));
+            for(std::size_t index = 0; index < batch.size(); ++index)
+            {
+                // Words are referenced in place, not copied.
+                BOOST_TEST((batch.getCandidates()[index] >=
+                            reinterpret_cast<const unsigned char *>(wordlist.getData())));
+                words.push_back(batch[index].to_string());
+            }
+        }
+    }
+    BOOST_TEST(words == expectedWords, boost::test_tools::per_element());
+}
+
+BOOST_FIXTURE_TEST_CASE(empty_wordlist_test, TmpFileFixture)
+{
+    tmpFile.close();
+    const Wordlist wordlist(tmpFilePath.string());
+    BOOST_TEST(wordlist.size() == 0);
+}
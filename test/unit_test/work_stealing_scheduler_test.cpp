@@ -0,0 +1,90 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <boost/test/data/test_case.hpp>
+
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+
+#include "search/work_stealing_scheduler.h"
+
+BOOST_DATA_TEST_CASE(work_stealing_scheduler_test,
+                     boost::unit_test_framework::data::make({1, 2, 4}) *
+                     boost::unit_test_framework::data::make({false, true}),
+                     threadsCount, pinThreads)
+{
+    WorkStealingScheduler scheduler(threadsCount, pinThreads);
+    BOOST_TEST(scheduler.getThreadsCount() == threadsCount);
+
+    for(const KeyspaceIndex tasksCount: {0, 3, 1000})
+    {
+        std::unique_ptr<std::atomic<unsigned int>[]> taken(new std::atomic<unsigned int>[tasksCount]);
+        for(KeyspaceIndex task = 0; task < tasksCount; ++task)
+        {
+            taken[task] = 0;
+        }
+        std::vector<KeyspaceIndex> threadTasksCounts(threadsCount, 0);
+        scheduler.run(tasksCount, [&](std::size_t threadIndex, WorkStealingScheduler::Tasks &tasks)
+        {
+            KeyspaceIndex task;
+            while(tasks.next(task))
+            {
+                BOOST_REQUIRE(task < tasksCount);
+                ++taken[task];
+                ++threadTasksCounts[threadIndex];
+                // The first thread is slow, so others have to steal its tasks.
+                if(threadIndex == 0)
+                {
+                    std::this_thread::sleep_for(std::chrono::microseconds(100));
+                }
+            }
+        });
+        for(KeyspaceIndex task = 0; task < tasksCount; ++task)
+        {
+            BOOST_REQUIRE(taken[task] == 1);
+        }
+        if(tasksCount == 1000 && threadsCount > 1)
+        {
+            BOOST_TEST(threadTasksCounts[0] < tasksCount / threadsCount);
+        }
+    }
+
+    BOOST_CHECK_THROW(scheduler.run(10, [](std::size_t threadIndex, WorkStealingScheduler::Tasks &)
+                                    {
+                                        if(threadIndex == 0)
+                                        {
+                                            throw std::runtime_error("failure");
+                                        }
+                                    }),
+                      std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(work_stealing_scheduler_threads_test)
+{
+    // Threads are kept between runs, so each index is run by the same thread every time.
+    const std::size_t threadsCount = 3;
+    WorkStealingScheduler scheduler(threadsCount, false);
+    std::vector<std::thread::id> firstThreadIds(threadsCount), threadIds(threadsCount);
+    scheduler.run(0, [&firstThreadIds](std::size_t threadIndex, WorkStealingScheduler::Tasks &)
+                  {
+                      firstThreadIds[threadIndex] = std::this_thread::get_id();
+                  });
+    for(unsigned int run = 0; run < 10; ++run)
+    {
+        scheduler.run(threadsCount, [&threadIds](std::size_t threadIndex, WorkStealingScheduler::Tasks &)
+                      {
+                          threadIds[threadIndex] = std::this_thread::get_id();
+                      });
+        BOOST_TEST(threadIds == firstThreadIds);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(available_cpus_test)
+{
+    const std::vector<int> cpus = WorkStealingScheduler::getAvailableCpus();
+    BOOST_TEST(!cpus.empty());
+    BOOST_TEST(WorkStealingScheduler::getCpuNode(cpus.front()) >= 0);
+}